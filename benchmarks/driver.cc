@@ -0,0 +1,181 @@
+/**
+ * @file driver.cc
+ * @brief Local scaling benchmarks of main_parallel on generated graphs
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace po = boost::program_options;
+
+/**
+ * @brief Parse a comma separated list of numbers, "1,2,4"
+ */
+static vector<long long> parseList(const string& list)
+{
+    vector<long long> values;
+    stringstream In(list);
+    string value;
+    while (getline(In, value, ',')) {
+        values.push_back(atoll(value.c_str()));
+    }
+    return values;
+}
+
+/**
+ * @brief Absolute path of main_parallel, built into the directory of this
+ *        executable, the runs start in the work directory
+ */
+static string mainParallel(const string& argv0)
+{
+    size_t slash = argv0.rfind('/');
+    string dir = slash == string::npos ? "." : argv0.substr(0, slash);
+    char* path = realpath(dir.c_str(), nullptr);
+    if (path == nullptr) {
+        std::cerr << "ERROR: Can't find the directory " << dir << endl;
+        exit(-1);
+    }
+    dir = path;
+    free(path);
+    return dir + "/main_parallel";
+}
+
+/**
+ * @brief <phase, seconds> of the file written by main_parallel --times-file
+ */
+static map<string, double> readTimes(const string& filename)
+{
+    map<string, double> times;
+    ifstream In(filename);
+    string phase;
+    double seconds;
+    while (In >> phase >> seconds) {
+        times[phase] = seconds;
+    }
+    return times;
+}
+
+static double median(vector<double> values)
+{
+    sort(values.begin(), values.end());
+    int n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help,h", ":produce help message")
+    ("sizes", po::value<string>(), ":numbers of vertices, default: 4096,16384")
+    ("subgraphs", po::value<string>(), ":numbers of subgraphs, default: 4")
+    ("ranks", po::value<string>(), ":numbers of processes, default: 1,2,4")
+    ("threads", po::value<string>(), ":threads of the generator in each process, default: 1")
+    ("repeats", po::value<int>(), ":runs of each configuration, default: 3")
+    ("model", po::value<string>(), ":erdos-renyi, rmat or geometric, default: rmat")
+    ("edge-factor", po::value<int>(), ":edges per vertex, default: 8")
+    ("weak", ":weak scaling, the sizes are per process")
+    ("mpirun", po::value<string>(), ":the MPI launcher, default: mpirun")
+    ("mpirun-args", po::value<string>(), ":extra arguments of the launcher, e.g. --oversubscribe")
+    ("work-dir", po::value<string>(), ":directory of the runs, default: bench_runs")
+    ("output,o", po::value<string>(), ":CSV file of the results, default: bench.csv")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help")) {
+        cout << desc << endl;
+        return 0;
+    }
+
+    auto option = [&](const string& name, const string& value) {
+        return vm.count(name) ? vm[name].as<string>() : value;
+    };
+    vector<long long> sizes = parseList(option("sizes", "4096,16384"));
+    vector<long long> subgraphs = parseList(option("subgraphs", "4"));
+    vector<long long> ranks = parseList(option("ranks", "1,2,4"));
+    vector<long long> threads = parseList(option("threads", "1"));
+    const int repeats = vm.count("repeats") ? vm["repeats"].as<int>() : 3;
+    const int edgeFactor =
+        vm.count("edge-factor") ? vm["edge-factor"].as<int>() : 8;
+    const bool weak = vm.count("weak");
+    const string model = option("model", "rmat");
+    const string launcher =
+        option("mpirun", "mpirun") + " " + option("mpirun-args", "");
+    const string binary = mainParallel(argv[0]);
+    const string work = option("work-dir", "bench_runs");
+    for (const string& dir : {work, work + "/output", work + "/times"}) {
+        mkdir(dir.c_str(), 0755);
+    }
+    const char* phases[] = {"input", "solve",     "output", "lanczos",
+                            "tqli",  "partition", "total"};
+
+    ofstream Output(option("output", "bench.csv"));
+    Output << "model,vertices,edges,subgraphs,ranks,threads,repeats,phase,"
+              "median,min"
+           << endl;
+    for (const long long& size : sizes) {
+        for (const long long& s : subgraphs) {
+            for (const long long& r : ranks) {
+                for (const long long& t : threads) {
+                    const long long vertices = weak ? size * r : size;
+                    const long long edges = vertices * edgeFactor;
+                    stringstream command;
+                    command << "cd " << work << " && " << launcher << " -np "
+                            << r << " " << binary << " --generate " << model
+                            << " -v " << vertices << " --edges " << edges
+                            << " -s " << s << " --threads " << t
+                            << " --times-file times.txt > run.log 2>&1";
+                    map<string, vector<double>> samples;
+                    bool failed = false;
+                    for (int repeat = 0; repeat < repeats && !failed;
+                         repeat++) {
+                        remove((work + "/times.txt").c_str());
+                        auto start = chrono::steady_clock::now();
+                        failed = system(command.str().c_str()) != 0;
+                        chrono::duration<double> elapsed =
+                            chrono::steady_clock::now() - start;
+                        samples["launch"].push_back(elapsed.count());
+                        for (const auto& it :
+                             readTimes(work + "/times.txt")) {
+                            samples[it.first].push_back(it.second);
+                        }
+                    }
+                    if (failed) {
+                        cerr << "ERROR: failed, see " << work
+                             << "/run.log: " << command.str() << endl;
+                        return 1;
+                    }
+                    vector<string> names(begin(phases), end(phases));
+                    names.push_back("launch");
+                    for (const string& phase : names) {
+                        const vector<double>& times = samples[phase];
+                        if (times.empty()) continue;
+                        Output << model << "," << vertices << "," << edges
+                               << "," << s << "," << r << "," << t << ","
+                               << times.size() << "," << phase << ","
+                               << median(times) << ","
+                               << *min_element(times.begin(), times.end())
+                               << endl;
+                    }
+                    cout << vertices << " vertices, " << s << " subgraphs, "
+                         << r << " ranks, " << t << " threads: total "
+                         << median(samples["launch"]) << "s" << endl;
+                }
+            }
+        }
+    }
+    return 0;
+}
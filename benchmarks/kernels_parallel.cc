@@ -0,0 +1,120 @@
+/**
+ * @file kernels_parallel.cc
+ * @brief Microbenchmarks of the communicating kernels of the parallel build
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include <benchmark/benchmark.h>
+#include <boost/mpi.hpp>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "generator.h"
+#include "graph.h"
+#include "laplacian.h"
+
+namespace mpi = boost::mpi;
+using namespace std;
+
+/*
+ * Every process runs the same fixed number of iterations, the kernels are
+ * collective and an adaptive count would differ between the processes.
+ * Only rank 0 reports, its times include the waits for the others.
+ */
+
+static const int iterations = 100;
+
+class NullReporter : public benchmark::BenchmarkReporter
+{
+public:
+    bool ReportContext(const Context&) override { return true; }
+    void ReportRuns(const std::vector<Run>&) override {}
+};
+
+static void setRates(benchmark::State& state, double bytes, double flops)
+{
+    state.SetBytesProcessed(int64_t(bytes * state.iterations()));
+    state.counters["flops"] =
+        benchmark::Counter(flops * state.iterations(),
+                           benchmark::Counter::kIsRate);
+}
+
+/**
+ * @brief Number of distinct halo vertices of the process
+ */
+static int haloSize(const Graph& g)
+{
+    unordered_set<int> halo;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            if (g.global_rank_map[neighbour] != g.rank()) {
+                halo.insert(neighbour);
+            }
+        }
+    }
+    return halo.size();
+}
+
+static void HaloUpdate(benchmark::State& state, const Graph* g)
+{
+    Laplacian<vector<double>, double> laplacian(*g);
+    vector<double> x(g->size(), 1.0);
+    for (auto _ : state) {
+        laplacian.haloUpdate(x, 1);
+    }
+    setRates(state, 8.0 * haloSize(*g), 0.0);
+}
+
+static void Multiply(benchmark::State& state, const Graph* g)
+{
+    Laplacian<vector<double>, double> laplacian(*g);
+    const int n = g->size();
+    const double nnz = 2.0 * g->edgesNum();
+    vector<double> x(n, 1.0), y;
+    for (auto _ : state) {
+        laplacian.multiply(x, y);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setRates(state, 12.0 * nnz + 16.0 * n + 8.0 * haloSize(*g),
+             nnz + 2.0 * n);
+}
+
+static void Reduce(benchmark::State& state, const Graph* g)
+{
+    Laplacian<vector<double>, double> laplacian(*g);
+    vector<double> sum(state.range(0), 1.0);
+    for (auto _ : state) {
+        laplacian.reduce(sum);
+        benchmark::DoNotOptimize(sum.data());
+    }
+    setRates(state, 8.0 * sum.size(), sum.size());
+}
+
+int main(int argc, char* argv[])
+{
+    mpi::environment env;
+    mpi::communicator world;
+    Graph g;
+    g.generate(Generator(Generator::Rmat, 1 << 16, 8 << 16, 1));
+    const string graph = "/rmat/65536/procs:" + to_string(world.size());
+
+    benchmark::RegisterBenchmark(("HaloUpdate" + graph).c_str(), HaloUpdate,
+                                 &g)
+        ->Iterations(iterations);
+    benchmark::RegisterBenchmark(("Multiply" + graph).c_str(), Multiply, &g)
+        ->Iterations(iterations);
+    benchmark::RegisterBenchmark(("Reduce" + graph).c_str(), Reduce, &g)
+        ->Arg(1)
+        ->Arg(64)
+        ->Iterations(iterations);
+
+    benchmark::Initialize(&argc, argv);
+    if (world.rank() == 0) {
+        benchmark::RunSpecifiedBenchmarks();
+    } else {
+        NullReporter reporter;
+        benchmark::RunSpecifiedBenchmarks(&reporter);
+    }
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,250 @@
+/**
+ * @file kernels_serial.cc
+ * @brief Microbenchmarks of the hot kernels of the serial build
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "basis.h"
+#include "csr.h"
+#include "generator.h"
+#include "graph.h"
+#include "kernels.h"
+#include "lanczos.h"
+#include "laplacian.h"
+#include "partition.h"
+#include "tqli.h"
+
+using namespace std;
+
+/*
+ * The bytes are the least each kernel has to move (every entry read or
+ * written once, the adjacency as 4-byte ids), so bytes_per_second against
+ * the memory bandwidth of the machine tells how far a kernel is from the
+ * roofline. flops is a rate as well. The threaded readers are timed by the
+ * wall clock.
+ */
+
+static void setRates(benchmark::State& state, double bytes, double flops)
+{
+    state.SetBytesProcessed(int64_t(bytes * state.iterations()));
+    state.counters["flops"] =
+        benchmark::Counter(flops * state.iterations(),
+                           benchmark::Counter::kIsRate);
+}
+
+static vector<double> randomVector(int n, int seed)
+{
+    vector<double> x(n);
+    srand48(seed);
+    for (auto& entry : x) {
+        entry = drand48() - 0.5;
+    }
+    return x;
+}
+
+static void Multiply(benchmark::State& state, const Graph* g)
+{
+    Laplacian<vector<double>, double> laplacian(*g);
+    const int n = g->size();
+    const double nnz = 2.0 * g->edgesNum();
+    vector<double> x = randomVector(n, 1), y;
+    for (auto _ : state) {
+        laplacian.multiply(x, y);
+        benchmark::DoNotOptimize(y.data());
+    }
+    setRates(state, 12.0 * nnz + 16.0 * n, nnz + 2.0 * n);
+}
+
+static void Dot(benchmark::State& state)
+{
+    const int n = state.range(0);
+    vector<double> x = randomVector(n, 1), y = randomVector(n, 2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Kernels::dot(x.data(), y.data(), n));
+    }
+    setRates(state, 16.0 * n, 2.0 * n);
+}
+BENCHMARK(Dot)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+
+static void Norm(benchmark::State& state)
+{
+    const int n = state.range(0);
+    vector<double> x = randomVector(n, 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sqrt(Kernels::dot(x.data(), x.data(), n)));
+    }
+    setRates(state, 8.0 * n, 2.0 * n);
+}
+BENCHMARK(Norm)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 24);
+
+/**
+ * @brief One classical Gram-Schmidt pass of w against m orthonormal Lanczos
+ *        vectors, Lanczos::gramSchmidt as the reorthogonalisation does it
+ */
+static void GramSchmidt(benchmark::State& state)
+{
+    typedef Lanczos<vector<double>, double> Solver;
+    const int n = state.range(0), m = state.range(1);
+    LanczosBasis<double> basis;
+    basis.reserve(m, n, "");
+    vector<int> against;
+    for (int row = 0; row < m; row++) {
+        vector<double> v = randomVector(n, row);
+        Solver::gramSchmidt(basis, against, v);
+        const double norm = sqrt(Kernels::dot(v.data(), v.data(), n));
+        for (auto& entry : v) {
+            entry /= norm;
+        }
+        basis.push_back(v);
+        against.push_back(row);
+    }
+    vector<double> w = randomVector(n, m);
+    for (auto _ : state) {
+        Solver::gramSchmidt(basis, against, w);
+        benchmark::DoNotOptimize(w.data());
+    }
+    setRates(state, 40.0 * n * m, 4.0 * n * m);
+}
+BENCHMARK(GramSchmidt)->Args({1 << 16, 32})->Args({1 << 20, 32});
+
+/**
+ * @brief Eigenpairs of an m x m tridiagonal matrix with the eigenvectors,
+ *        about 3 m^3 flops for the rotations of z
+ */
+static void Tqli(benchmark::State& state)
+{
+    const int m = state.range(0);
+    vector<double> alpha = randomVector(m, 1), beta = randomVector(m - 1, 2);
+    for (auto _ : state) {
+        vector<double> d = alpha, e = beta;
+        vector<vector<double>> z;
+        tqli(d, e, z);
+        benchmark::DoNotOptimize(z.data());
+    }
+    setRates(state, 8.0 * m * m, 3.0 * m * m * m);
+}
+BENCHMARK(Tqli)->Arg(50)->Arg(100)->Arg(200)->Arg(400);
+
+/**
+ * @brief A Ritz vector from m stored Lanczos vectors,
+ *        Partition::getOneLapEigenVec
+ */
+template <typename T>
+static void RitzVector(benchmark::State& state)
+{
+    const int n = state.range(0), m = state.range(1);
+    LanczosBasis<T> basis;
+    basis.reserve(m, n, "");
+    vector<vector<double>> eigenvectors;
+    for (int row = 0; row < m; row++) {
+        basis.push_back(randomVector(n, row));
+        eigenvectors.push_back(randomVector(m, m + row));
+    }
+    for (auto _ : state) {
+        vector<double> ritz =
+            Partition::getOneLapEigenVec(basis, eigenvectors, 0);
+        benchmark::DoNotOptimize(ritz.data());
+    }
+    setRates(state, (sizeof(T) + 16.0) * n * m, 2.0 * n * m);
+}
+BENCHMARK_TEMPLATE(RitzVector, double)->Args({1 << 20, 32});
+BENCHMARK_TEMPLATE(RitzVector, float)->Args({1 << 20, 32});
+
+static double fileSize(const string& filename)
+{
+    ifstream In(filename, ios::binary | ios::ate);
+    return In.tellg();
+}
+
+static void ReadDotFormat(benchmark::State& state, const string& filename)
+{
+    for (auto _ : state) {
+        Graph g;
+        g.readDotFormat(filename);
+        benchmark::DoNotOptimize(g.size());
+    }
+    setRates(state, fileSize(filename), 0.0);
+}
+
+static void ReadDotFormatStreaming(benchmark::State& state,
+                                   const string& filename)
+{
+    for (auto _ : state) {
+        Graph g;
+        g.readDotFormatStreaming(filename, state.range(0));
+        benchmark::DoNotOptimize(g.size());
+    }
+    setRates(state, fileSize(filename), 0.0);
+}
+
+static void ReadDotFormatCsr(benchmark::State& state, const string& filename)
+{
+    for (auto _ : state) {
+        Csr<int32_t> csr = readDotFormatCsr<int32_t>(filename, state.range(0));
+        benchmark::DoNotOptimize(csr.neighbours.data());
+    }
+    setRates(state, fileSize(filename), 0.0);
+}
+
+/**
+ * @brief The graphs are generated ones and the ones of tests/dotfiles
+ *        (TEST_FILES as for the unit tests), a generated graph is written
+ *        to a dot file for the readers too
+ */
+int main(int argc, char* argv[])
+{
+    char* path = getenv("TEST_FILES");
+    const string dir = path != nullptr ? path : "../../tests/dotfiles";
+    map<string, unique_ptr<Graph>> graphs;
+    vector<string> files = {dir + "/test_1000.dot",
+                            dir + "/par_test_10240.dot"};
+    for (const char* model : {"erdos-renyi", "rmat", "geometric"}) {
+        Graph* g = new Graph;
+        g->generate(Generator(Generator::model(model), 1 << 18, 8 << 18, 1));
+        graphs[string(model) + "/262144"].reset(g);
+    }
+    for (const string& file : files) {
+        Graph* g = new Graph;
+        g->readDotFormat(file);
+        graphs[file.substr(file.rfind('/') + 1)].reset(g);
+    }
+    const string generated = "bench_rmat_262144.dot";
+    graphs["rmat/262144"]->outputDotFormat(generated);
+    files.push_back(generated);
+
+    for (const auto& it : graphs) {
+        benchmark::RegisterBenchmark(("Multiply/" + it.first).c_str(),
+                                     Multiply, it.second.get());
+    }
+    for (const string& file : files) {
+        const string name = file.substr(file.rfind('/') + 1);
+        benchmark::RegisterBenchmark(("ReadDotFormat/" + name).c_str(),
+                                     ReadDotFormat, file);
+        benchmark::RegisterBenchmark(
+            ("ReadDotFormatStreaming/" + name).c_str(),
+            ReadDotFormatStreaming, file)
+            ->Arg(1)
+            ->Arg(4)
+            ->UseRealTime();
+        benchmark::RegisterBenchmark(("ReadDotFormatCsr/" + name).c_str(),
+                                     ReadDotFormatCsr, file)
+            ->Arg(1)
+            ->Arg(4)
+            ->UseRealTime();
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    remove(generated.c_str());
+    return 0;
+}
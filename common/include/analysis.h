@@ -14,6 +14,9 @@ class Analysis
 {
 public:
     static double cutEdgePercent(const Graph& g);
+    static double ratioCut(const Graph& g);
+    static double normalisedCut(const Graph& g);
+    static int bandwidth(const Graph& g);
     static void cutEdgeVertexTable(const Graph& g,
                                    const std::vector<double>& ritzValues);
     static void manuallyPartition(const Graph& g);
@@ -22,6 +25,8 @@ public:
     // For serial
     static void randomPartition(const Graph& g, const int& colours);
     static void evenPartition(const Graph& g, const int& colours);
+    static void precisionReport(const Graph& g, const int& colours,
+                                bool enableGramSchmidt);
     static void outputTimes(const int& numOfVertices, const std::vector<double>& vec);
     //static void benchmarks(bool enableGramSchmidt);
 };
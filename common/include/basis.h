@@ -0,0 +1,165 @@
+/**
+ * @file basis.h
+ * @brief Storage of the Lanczos vectors, in memory or spilled to a file
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef BASIS_H_
+#define BASIS_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "kernels.h"
+#include "memory_usage.h"
+
+/*
+ * =====================================================================================
+ *        Class:  MappedFile
+ *  Description:  An anonymous temporary file mapped into memory, the pages
+ *                are backed by the file instead of swap so the kernel can
+ *                write them out and drop them under memory pressure
+ * =====================================================================================
+ */
+
+class MappedFile
+{
+private:
+    void* data_;
+    std::size_t bytes_;
+
+public:
+    MappedFile() : data_(nullptr), bytes_(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    void open(const std::string& directory, std::size_t bytes);
+    void close();
+    void* data() const { return data_; }
+    // Start reading [addr, addr + bytes) in the background
+    static void willNeed(const void* addr, std::size_t bytes);
+};
+
+/*
+ * =====================================================================================
+ *        Class:  BasisRow
+ *  Description:  Read-only view of one stored Lanczos vector
+ * =====================================================================================
+ */
+
+template <typename T>
+class BasisRow
+{
+private:
+    const T* data_;
+    int size_;
+
+public:
+    typedef T value_type;
+    BasisRow(const T* data, int size) : data_(data), size_(size) {}
+    const T* data() const { return data_; }
+    int size() const { return size_; }
+    const T& operator[](int i) const { return data_[i]; }
+};
+
+/*
+ * =====================================================================================
+ *        Class:  LanczosBasis
+ *  Description:  The Lanczos vectors in one contiguous m * n arena of T
+ *                allocated up front, each row padded to start on a 64-byte
+ *                boundary. With a spill directory the arena is a mapped
+ *                file, the vectors are written sequentially and reading a
+ *                vector prefetches the next one, so sequential passes
+ *                (reorthogonalisation, Ritz vectors) overlap the disk with
+ *                the arithmetic. Lanczos in T writes each vector in place
+ *                with append() and reads the last two as views of the rows.
+ * =====================================================================================
+ */
+
+template <typename T>
+class LanczosBasis
+{
+private:
+    struct Free {
+        void operator()(T* p) const { std::free(p); }
+    };
+    int rows_, cols_, size_;
+    std::size_t stride_;  // Entries from a row to the next
+    std::unique_ptr<T, Free> memory_;
+    MappedFile file_;
+    T* data_;
+
+    T* row(int i) const { return data_ + i * stride_; }
+
+public:
+    typedef BasisRow<T> Row;
+    LanczosBasis() : rows_(0), cols_(0), size_(0), stride_(0), data_(nullptr)
+    {
+    }
+
+    /**
+     * @brief Allocate space for rows vectors of cols entries
+     * @param spillDirectory Keep the vectors in a file in the directory, in
+     *        memory if empty
+     */
+    void reserve(int rows, int cols, const std::string& spillDirectory)
+    {
+        const std::size_t alignment = 64;
+        rows_ = rows;
+        cols_ = cols;
+        size_ = 0;
+        stride_ = (cols * sizeof(T) + alignment - 1) / alignment * alignment /
+                  sizeof(T);
+        std::size_t bytes = rows * stride_ * sizeof(T);
+        memory_.reset();
+        file_.close();
+        if (spillDirectory.empty()) {
+            void* arena = nullptr;
+            if (posix_memalign(&arena, alignment, std::max(bytes, alignment))) {
+                throw std::bad_alloc();
+            }
+            memory_.reset(static_cast<T*>(arena));
+            data_ = memory_.get();
+            MemoryUsage::record("lanczos/basis", bytes);
+        } else {
+            file_.open(spillDirectory, bytes);
+            data_ = static_cast<T*>(file_.data());
+        }
+    }
+
+    // Append a vector, converted to T
+    template <typename Vector>
+    void push_back(const Vector& vec)
+    {
+        assert(size_ < rows_ && (int)vec.size() == cols_);
+        VectorOps<Vector, typename Vector::value_type>::store(row(size_++),
+                                                             vec);
+    }
+
+    // Append a vector written in place into the returned row of cols()
+    // entries
+    T* append()
+    {
+        assert(size_ < rows_);
+        return row(size_++);
+    }
+
+    Row operator[](int i) const
+    {
+        if (file_.data() && i + 1 < size_) {
+            MappedFile::willNeed(row(i + 1), cols_ * sizeof(T));
+        }
+        return Row(row(i), cols_);
+    }
+    int size() const { return size_; }
+    int cols() const { return cols_; }
+    bool spilled() const { return file_.data() != nullptr; }
+};
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file chebyshev.h
+ * @brief The interface of Chebyshev polynomial filtering
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef CHEBYSHEV_H_
+#define CHEBYSHEV_H_
+
+#include "laplacian.h"
+
+/*
+ * =====================================================================================
+ *        Class:  ChebyshevFilter
+ *  Description:  p(L) x with p the Chebyshev polynomial of the given degree
+ *                mapped onto [cut * bound, bound], where bound is the
+ *                Gershgorin bound of the eigenvalues. The eigenvectors in
+ *                the damped interval are kept at most 1, the ones below it
+ *                are amplified by cosh(degree * acosh(...)), so the small
+ *                eigenvalues dominate. Only products with L are needed, no
+ *                reductions.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T, typename Operator = Combinatorial,
+          typename Index = int32_t>
+class ChebyshevFilter
+{
+private:
+    Laplacian<Vector, T, Operator, Index>& laplacian;
+    int degree_;
+    T lower_, upper_;
+
+public:
+    ChebyshevFilter(Laplacian<Vector, T, Operator, Index>& L,
+                    const int& degree, const T& cut = 0.05);
+
+    // x holds width vectors row by row, as in Laplacian::multiply
+    void apply(Vector& x, const int& width = 1);
+    int degree() const { return degree_; }
+};
+
+#include "../src/chebyshev.cc"
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file csr.h
+ * @brief Header file for csr.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef CSR_H_
+#define CSR_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * =====================================================================================
+ *        Class:  Csr
+ *  Description:  Compressed sparse rows of an undirected graph, the
+ *                neighbours of vertex v are neighbours[offsets[v] ..
+ *                offsets[v + 1]) in increasing order without duplicates.
+ *                The arrays are allocated once at their exact size. Index
+ *                is the type of the vertex ids, int32_t keeps the rows
+ *                half the size, int64_t reads ids beyond 2^31; the
+ *                offsets are 64-bit for either.
+ * =====================================================================================
+ */
+
+template <typename Index>
+struct Csr {
+    std::vector<int64_t> offsets;  // size() + 1 entries
+    std::vector<Index> neighbours;
+
+    Index size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    int64_t degree(const Index& v) const
+    {
+        return offsets[v + 1] - offsets[v];
+    }
+};
+
+// Read the vertices and edges of a dot file in two passes over the file, the
+// first counts the degrees, the second fills the rows. Each pass is split
+// into chunks of lines over threads (0 for the hardware concurrency). Throws
+// std::out_of_range for a vertex id that does not fit in Index.
+template <typename Index>
+Csr<Index> readDotFormatCsr(const std::string& filename, int threads = 0);
+
+// The number of vertices (the largest id + 1) and edges of a dot file in one
+// pass over threads, nothing is stored. Each edge is listed in both
+// directions, only the lines a -- b with a < b are counted.
+void countDotFormat(const std::string& filename, int64_t& vertices,
+                    int64_t& edges, int threads = 0);
+
+extern template Csr<int32_t> readDotFormatCsr(const std::string&, int);
+extern template Csr<int64_t> readDotFormatCsr(const std::string&, int);
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file generator.h
+ * @brief Header file for generator.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * =====================================================================================
+ *        Class:  Generator
+ *  Description:  Seeded random graphs. Every random number is a hash of
+ *                (seed, counter), edge i or vertex v always gets the same
+ *                values, so any slice of the graph is generated
+ *                independently of the others and of the number of threads
+ *                and processes. ErdosRenyi draws the given number of edges
+ *                uniformly, Rmat draws them from the recursive quadrants of
+ *                the adjacency matrix (skewed degrees as in Graph500),
+ *                Geometric connects the points in the unit square closer
+ *                than the radius that gives the same average degree, the
+ *                number of points per cell of the grid is multinomial as
+ *                for independent uniform points.
+ *                Duplicate edges and loops of ErdosRenyi and Rmat are left
+ *                to the graph to drop.
+ * =====================================================================================
+ */
+
+class Generator
+{
+public:
+    enum Model { ErdosRenyi, Rmat, Geometric };
+    typedef std::vector<std::pair<int64_t, int64_t>> Edges;
+
+    // "erdos-renyi", "rmat" or "geometric"
+    static Model model(const std::string& name);
+
+    Generator(Model model, const int64_t& vertices, const int64_t& edges,
+              const uint64_t& seed);
+
+    // Each undirected edge once, of slice part in [0, parts), split over
+    // threads (0 for the hardware concurrency)
+    Edges edges(const int& part, const int& parts, int threads = 0) const;
+
+    int64_t vertices() const { return vertices_; }
+
+    // The quadrant probabilities of Rmat, d = 1 - a - b - c
+    double a, b, c;
+
+private:
+    Model model_;
+    int64_t vertices_;
+    int64_t edges_;
+    uint64_t seed_;
+
+    int64_t cellsPerSide_;  // Geometric, cells of side >= the radius
+    double radius_;
+
+    double uniform(const uint64_t& counter, const uint64_t& stream) const;
+    int64_t binomial(const int64_t& trials, const double& p,
+                     const uint64_t& counter) const;
+    int64_t split(const uint64_t& node, const int64_t& lo, const int64_t& hi,
+                  const int64_t& vertices) const;
+    void rmatEdges(int64_t first, int64_t last, Edges& edges) const;
+    void erdosRenyiEdges(int64_t first, int64_t last, Edges& edges) const;
+    void geometricEdges(int64_t first, int64_t last, Edges& edges) const;
+    int64_t cellOf(const int64_t& vertex) const;
+    int64_t firstOf(const int64_t& cell) const;
+    void cellFirsts(const uint64_t& node, const int64_t& lo, const int64_t& hi,
+                    const int64_t& base, const int64_t& count,
+                    const int64_t& low, std::vector<int64_t>& firsts) const;
+    std::pair<double, double> point(const int64_t& vertex,
+                                    const int64_t& cell) const;
+};
+
+#endif
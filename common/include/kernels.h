@@ -0,0 +1,277 @@
+/**
+ * @file kernels.h
+ * @brief Header file for kernels.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/*
+ * =====================================================================================
+ *        Class:  Kernels
+ *  Description:  Vector kernels of Lanczos iteration on contiguous arrays,
+ *                AVX-512/AVX2 is selected at runtime with a scalar fallback
+ * =====================================================================================
+ */
+
+class Kernels
+{
+public:
+    enum ISA { Scalar = 0, AVX2 = 1, AVX512 = 2 };
+    static ISA isa();
+    static ISA supportedISA();
+    static void setISA(ISA isa);  // Clamped to the supported ISA
+    static const char* isaName();
+
+    // x . y
+    static double dot(const double* x, const double* y, int n);
+    static float dot(const float* x, const float* y, int n);
+    static double dot(const float* x, const double* y, int n);
+    // w = w - alpha * v1 - beta * v0, return w . w
+    static double update(double* w, const double* v1, const double* v0,
+                         double alpha, double beta, int n);
+    static float update(float* w, const float* v1, const float* v0,
+                        float alpha, float beta, int n);
+    // y = a * x + y
+    static void axpy(double* y, const double* x, double a, int n);
+    static void axpy(float* y, const float* x, float a, int n);
+    static void axpy(double* y, const float* x, double a, int n);
+    // y = a * x
+    static void scale(double* y, const double* x, double a, int n);
+    static void scale(float* y, const float* x, float a, int n);
+    // y = x in lower precision
+    static void convert(float* y, const double* x, int n);
+};
+
+/*
+ * =====================================================================================
+ *        Class:  VectorOps
+ *  Description:  Vector operations used by Lanczos, the generic version loops
+ *                over operator[], std::vector<double/float> is specialised to
+ *                use the SIMD kernels
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T>
+struct VectorOps {
+    // x may be a Lanczos vector stored in another precision
+    template <typename Basis>
+    static T dot(const Basis& x, const Vector& y)
+    {
+        T sum = 0.0;
+        int size = x.size();
+        for (int i = 0; i < size; i++) {
+            sum += x[i] * y[i];
+        }
+        return sum;
+    }
+    static T update(Vector& w, const Vector& v1, const Vector& v0, T alpha,
+                    T beta)
+    {
+        T sum = 0.0;
+        int size = w.size();
+        for (int i = 0; i < size; i++) {
+            w[i] = w[i] - alpha * v1[i] - beta * v0[i];
+            sum += w[i] * w[i];
+        }
+        return sum;
+    }
+    // On spans of n entries, e.g. rows of the Lanczos basis
+    static T update(T* w, const T* v1, const T* v0, T alpha, T beta, int n)
+    {
+        T sum = 0.0;
+        for (int i = 0; i < n; i++) {
+            w[i] = w[i] - alpha * v1[i] - beta * v0[i];
+            sum += w[i] * w[i];
+        }
+        return sum;
+    }
+    template <typename Basis>
+    static void axpy(Vector& y, const Basis& x, T a)
+    {
+        int size = y.size();
+        for (int i = 0; i < size; i++) {
+            y[i] += a * x[i];
+        }
+    }
+    static void scale(Vector& y, const Vector& x, T a)
+    {
+        int size = x.size();
+        y.resize(size);
+        for (int i = 0; i < size; i++) {
+            y[i] = a * x[i];
+        }
+    }
+    static void scale(T* y, const T* x, T a, int n)
+    {
+        for (int i = 0; i < n; i++) {
+            y[i] = a * x[i];
+        }
+    }
+    template <typename Basis>
+    static void store(Basis& y, const Vector& x)
+    {
+        int size = x.size();
+        y.resize(size);
+        for (int i = 0; i < size; i++) {
+            y[i] = x[i];
+        }
+    }
+    // y has the size of x
+    template <typename S>
+    static void store(S* y, const Vector& x)
+    {
+        int size = x.size();
+        for (int i = 0; i < size; i++) {
+            y[i] = x[i];
+        }
+    }
+};
+
+/*
+ * =====================================================================================
+ *        Class:  BlockOps
+ *  Description:  Operations on blocks of b vectors used by block Lanczos, a
+ *                block is stored row by row, entry (i, c) at x[i * b + c], so
+ *                the b values of a vertex are adjacent. Small b * b matrices
+ *                are row major std::vector<T>. The results are local, the
+ *                parallel version reduces them.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T>
+struct BlockOps {
+    // x^T y
+    static std::vector<T> gram(const Vector& x, const Vector& y, int b)
+    {
+        std::vector<T> c(b * b, 0.0);
+        int size = x.size() / b;
+        for (int i = 0; i < size; i++) {
+            for (int r = 0; r < b; r++) {
+                T xr = x[i * b + r];
+                for (int s = 0; s < b; s++) {
+                    c[r * b + s] += xr * y[i * b + s];
+                }
+            }
+        }
+        return c;
+    }
+    // y = y - x * c, or y - x * c^T
+    static void subtract(Vector& y, const Vector& x, const std::vector<T>& c,
+                         int b, bool transpose)
+    {
+        int size = y.size() / b;
+        for (int i = 0; i < size; i++) {
+            for (int s = 0; s < b; s++) {
+                T sum = 0.0;
+                for (int r = 0; r < b; r++) {
+                    sum += x[i * b + r] * (transpose ? c[s * b + r]
+                                                     : c[r * b + s]);
+                }
+                y[i * b + s] -= sum;
+            }
+        }
+    }
+    // d[c] = q . x(:, c)
+    template <typename Basis>
+    static void dots(T* d, const Basis& q, const Vector& x, int b)
+    {
+        int size = q.size();
+        std::fill(d, d + b, 0.0);
+        for (int i = 0; i < size; i++) {
+            for (int c = 0; c < b; c++) {
+                d[c] += q[i] * x[i * b + c];
+            }
+        }
+    }
+    // x(:, c) = x(:, c) - d[c] * q
+    template <typename Basis>
+    static void subtract(Vector& x, const Basis& q, const T* d, int b)
+    {
+        int size = q.size();
+        for (int i = 0; i < size; i++) {
+            for (int c = 0; c < b; c++) {
+                x[i * b + c] -= d[c] * q[i];
+            }
+        }
+    }
+    static void column(Vector& y, const Vector& x, int b, int c)
+    {
+        int size = x.size() / b;
+        y.resize(size);
+        for (int i = 0; i < size; i++) {
+            y[i] = x[i * b + c];
+        }
+    }
+};
+
+template <typename T>
+struct ContiguousVectorOps {
+    typedef std::vector<T> Vector;
+    // Basis is a contiguous std::vector or BasisRow
+    template <typename Basis>
+    static T dot(const Basis& x, const Vector& y)
+    {
+        assert((size_t)x.size() == y.size());
+        return Kernels::dot(x.data(), y.data(), y.size());
+    }
+    static T update(Vector& w, const Vector& v1, const Vector& v0, T alpha,
+                    T beta)
+    {
+        assert(w.size() == v1.size() && w.size() == v0.size());
+        return Kernels::update(w.data(), v1.data(), v0.data(), alpha, beta,
+                               w.size());
+    }
+    static T update(T* w, const T* v1, const T* v0, T alpha, T beta, int n)
+    {
+        return Kernels::update(w, v1, v0, alpha, beta, n);
+    }
+    template <typename Basis>
+    static void axpy(Vector& y, const Basis& x, T a)
+    {
+        assert((size_t)x.size() == y.size());
+        Kernels::axpy(y.data(), x.data(), a, y.size());
+    }
+    static void scale(Vector& y, const Vector& x, T a)
+    {
+        y.resize(x.size());
+        Kernels::scale(y.data(), x.data(), a, x.size());
+    }
+    static void scale(T* y, const T* x, T a, int n)
+    {
+        Kernels::scale(y, x, a, n);
+    }
+    static void store(Vector& y, const Vector& x) { y = x; }
+    template <typename S>
+    static void store(std::vector<S>& y, const Vector& x)
+    {
+        y.resize(x.size());
+        store(y.data(), x);
+    }
+    static void store(T* y, const Vector& x)
+    {
+        std::copy(x.begin(), x.end(), y);
+    }
+    template <typename S>
+    static void store(S* y, const Vector& x)
+    {
+        Kernels::convert(y, x.data(), x.size());
+    }
+};
+
+template <>
+struct VectorOps<std::vector<double>, double>
+    : public ContiguousVectorOps<double> {
+};
+
+template <>
+struct VectorOps<std::vector<float>, float>
+    : public ContiguousVectorOps<float> {
+};
+
+#endif
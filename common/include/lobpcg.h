@@ -0,0 +1,62 @@
+/**
+ * @file lobpcg.h
+ * @brief The interface of LOBPCG eigensolver
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef LOBPCG_H_
+#define LOBPCG_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "laplacian.h"
+
+/*
+ * =====================================================================================
+ *        Class:  Lobpcg
+ *  Description:  Locally optimal block preconditioned conjugate gradient for
+ *                the smallest non-trivial eigenpairs of the Laplacian matrix.
+ *                The constant vector is projected out, only the blocks X
+ *                (eigenvectors), W (preconditioned residuals) and P
+ *                (directions) are kept, 3k vectors in total. Index is the
+ *                vertex type of the graph.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T, typename Index = int32_t>
+class Lobpcg
+{
+public:
+    enum Preconditioner { None, Jacobi, Smoother };
+    // "none", "jacobi" or "smoother", throws std::invalid_argument otherwise
+    static Preconditioner preconditioner(const std::string& name);
+
+    Lobpcg(const BasicGraph<Index>& g, const int& num_of_eigenvec,
+           Preconditioner preconditioner = Jacobi, const int& max_iter = 500,
+           const T& tol = 1e-6,
+           const std::vector<Vector>& start = std::vector<Vector>());
+
+    std::vector<T> eigenvalues;        // In increasing order
+    std::vector<Vector> eigenvectors;  // Local part of each eigenvector
+    int iterations;
+    bool converged;
+
+private:
+    typedef std::vector<Vector> Block;  // Vectors of the local size
+    Laplacian<Vector, T, Combinatorial, Index> laplacian;
+    Vector inverse_diagonal;
+    Preconditioner preconditioner_;
+
+    T dot(const Vector& x, const Vector& y);
+    void deflate(Vector& x);
+    void orthonormalise(Block& s);
+    Block multiply(const Block& s);
+    Block precondition(const Block& r);
+    Block combine(const Block& s, const std::vector<std::vector<double>>& c,
+                  const std::vector<int>& columns, const int& first);
+};
+
+#include "../src/lobpcg.cc"
+#endif
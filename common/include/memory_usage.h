@@ -0,0 +1,104 @@
+/**
+ * @file memory_usage.h
+ * @brief Header file for memory_usage.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef MEMORY_USAGE_H_
+#define MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/*
+ * =====================================================================================
+ *        Class:  MemoryUsage
+ *  Description:  Size accounting of the large structures of a run, the
+ *                largest size recorded of each by name, e.g.
+ *                "graph/adjacency", next to the high-water mark of the
+ *                resident set of the process. The sizes of the containers
+ *                are estimated from their capacities and, for the hash
+ *                containers, the nodes and buckets as glibc malloc
+ *                allocates them. estimate() predicts the same entries
+ *                before anything is allocated.
+ * =====================================================================================
+ */
+
+class MemoryUsage
+{
+public:
+    typedef std::map<std::string, std::size_t> Entries;  // <name, bytes>
+
+    // Keep the largest of the sizes recorded for the name
+    static void record(const std::string& name, const std::size_t& bytes);
+    static const Entries& entries();
+    static void reset();
+    static std::size_t peakRss();  // Bytes, 0 if unknown
+
+    // The entries of a run of a graph with the given vertices and
+    // (undirected) edges on the processes, m Lanczos vectors of
+    // basisBytes per entry and the eigenvectors of the colouring.
+    // distributed for the parallel build, its index and halo structures.
+    static Entries estimate(const int64_t& vertices, const int64_t& edges,
+                            const int& m, const int& eigenvectors,
+                            const int& processes,
+                            const std::size_t& basisBytes, bool distributed);
+
+    // The min, max and average over the processes of each entry, the total
+    // and the high-water mark of the resident set of each process, in MB
+    static void report(std::ostream& out,
+                       const std::vector<Entries>& processes,
+                       const std::vector<std::size_t>& rss);
+
+    static std::size_t allocation(const std::size_t& bytes);  // With malloc
+    template <typename T>
+    static std::size_t bytes(const std::vector<T>& v)
+    {
+        return v.capacity() * sizeof(T);
+    }
+    template <typename T>
+    static std::size_t bytes(const std::vector<std::vector<T>>& m)
+    {
+        std::size_t total = m.capacity() * sizeof(std::vector<T>);
+        for (const auto& row : m) {
+            total += bytes(row);
+        }
+        return total;
+    }
+    template <typename K, typename V, typename H>
+    static std::size_t bytes(const std::unordered_map<K, V, H>& m)
+    {
+        typedef std::pair<void*, std::pair<K, V>> Node;
+        return m.bucket_count() * sizeof(void*) +
+               m.size() * allocation(sizeof(Node));
+    }
+    template <typename K>
+    static std::size_t bytes(const std::unordered_set<K>& s)
+    {
+        typedef std::pair<void*, K> Node;
+        return s.bucket_count() * sizeof(void*) +
+               s.size() * allocation(sizeof(Node));
+    }
+    // A map of sets, the adjacency of the graphs
+    template <typename K>
+    static std::size_t bytes(
+        const std::unordered_map<K, std::unordered_set<K>>& m)
+    {
+        typedef std::pair<void*, std::pair<K, std::unordered_set<K>>> Node;
+        std::size_t total = m.bucket_count() * sizeof(void*) +
+                            m.size() * allocation(sizeof(Node));
+        for (const auto& it : m) {
+            total += bytes(it.second);
+        }
+        return total;
+    }
+};
+
+#endif
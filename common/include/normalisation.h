@@ -0,0 +1,39 @@
+/**
+ * @file normalisation.h
+ * @brief Operator policies of the Laplacian matrix
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef NORMALISATION_H_
+#define NORMALISATION_H_
+
+/*
+ * =====================================================================================
+ *        Class:  Combinatorial, SymmetricNormalised, RandomWalk
+ *  Description:  Template arguments of Laplacian and Lanczos choosing the
+ *                operator at compile time. Combinatorial is L = D - A, its
+ *                eigenvectors minimise the ratio cut. SymmetricNormalised
+ *                is D^-1/2 L D^-1/2, with the scaling D^-1/2 computed once
+ *                and applied inside the product. RandomWalk is D^-1 L, it
+ *                is not symmetric, so Lanczos runs on the similar
+ *                symmetric operator and its eigenvectors are D^-1/2 times
+ *                those, minimising the normalised cut.
+ * =====================================================================================
+ */
+
+struct Combinatorial {
+    static const bool normalised = false;
+    static const bool randomWalk = false;
+};
+
+struct SymmetricNormalised {
+    static const bool normalised = true;
+    static const bool randomWalk = false;
+};
+
+struct RandomWalk {
+    static const bool normalised = true;
+    static const bool randomWalk = true;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * @file ordering.h
+ * @brief Header file for ordering.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef ORDERING_H_
+#define ORDERING_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Each ordering returns order[new_index] = old_index, Index is the type of
+// the vertex ids, int32_t and int64_t are instantiated in ordering.cc
+template <typename Index>
+std::vector<Index> reverseCuthillMcKee(
+    const std::vector<std::vector<Index>>& adjacency);
+template <typename Index>
+std::vector<Index> breadthFirstOrdering(
+    const std::vector<std::vector<Index>>& adjacency);
+template <typename Index>
+std::vector<Index> degreeOrdering(
+    const std::vector<std::vector<Index>>& adjacency);
+template <typename Index>
+std::vector<Index> vertexOrdering(
+    const std::string& method,
+    const std::vector<std::vector<Index>>& adjacency);
+
+#endif
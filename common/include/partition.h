@@ -8,9 +8,48 @@
 #define PARTITION_H_
 
 #include <map>
+#include <string>
 #include <vector>
+#include "basis.h"
 #include "graph.h"
 
+/*
+ * =====================================================================================
+ *        Class:  PartitionOptions
+ *  Description:  Options of the eigensolver used for partitioning
+ * =====================================================================================
+ */
+
+struct PartitionOptions {
+    explicit PartitionOptions(bool GramSchmidt = false)
+        : gramSchmidt(GramSchmidt),
+          mixedPrecision(false),
+          blockSize(1),
+          chebyshevDegree(0),
+          minComponentSize(0),
+          eigensolver("lanczos"),
+          preconditioner("jacobi"),
+          laplacian("combinatorial")
+    {
+    }
+    bool gramSchmidt;            // Reorthogonalise the Lanczos vectors
+    bool mixedPrecision;         // Store the Lanczos vectors in float
+    std::string spillDirectory;  // Store the Lanczos vectors in a file here
+    int blockSize;               // Block Lanczos if > 1
+    int chebyshevDegree;         // Filter the Lanczos start vector if > 0
+    int minComponentSize;        // Smaller components are not partitioned,
+                                 // 0 partitions the whole graph at once
+    std::string eigensolver;     // "lanczos" or "lobpcg"
+    std::string preconditioner;  // Of LOBPCG, "none", "jacobi" or "smoother"
+    // Operator of Lanczos, "combinatorial" (ratio cut), "normalised" or
+    // "random-walk" (normalised cut)
+    std::string laplacian;
+    // Local parts of the eigenvectors of a previous run (or colourVectors of
+    // a previous colouring) to warm start the eigensolver, empty for a cold
+    // start
+    std::vector<std::vector<double>> startVectors;
+};
+
 class Partition
 {
 private:
@@ -19,18 +58,61 @@ private:
     std::vector<double> laplacianEigenvalues_;
     DenseMatrix laplacianEigenMatrix_;
 
-    std::vector<double> getOneLapEigenVec(DenseMatrix& lanczosVectors,
-                                          DenseMatrix& tridiagonalEigenVectors,
-                                          const int& vectorIndex);
+    template <typename Index>
+    void partitionByComponents(const BasicGraph<Index>& g,
+                               const int& numOfSubGraphs,
+                               const PartitionOptions& options);
+    template <typename Index>
+    void partitionConnected(const BasicGraph<Index>& g,
+                            const int& numOfSubGraphs,
+                            const PartitionOptions& options);
+    template <typename Operator, typename Index>
+    void partitionByLanczos(const BasicGraph<Index>& g,
+                            const int& numOfEigenvectors,
+                            const PartitionOptions& options);
+    template <typename Basis, typename Operator, typename Index>
+    void lanczosEigenvectors(const BasicGraph<Index>& g,
+                             const int& numOfEigenvectors,
+                             const PartitionOptions& options);
+    template <typename Index>
+    void partitionByLobpcg(const BasicGraph<Index>& g,
+                           const int& numOfEigenvectors,
+                           const PartitionOptions& options);
+    template <typename Index>
+    void colour(const BasicGraph<Index>& g, const int& numOfEigenvectors);
     inline int signMedian(double entry, double median);
 
 public:
     Partition() {}
-    Partition(const Graph& g, const int& subgraphs, bool GramSchmidt);
+    // Instantiated in partition.cc for Graph and Graph64
+    template <typename Index>
+    Partition(const BasicGraph<Index>& g, const int& subgraphs,
+              bool GramSchmidt);
+    template <typename Index>
+    Partition(const BasicGraph<Index>& g, const int& subgraphs,
+              const PartitionOptions& options);
+
+    // The Ritz vector of the column vectorIndex of the eigenvectors of the
+    // tridiagonal matrix, instantiated in partition.cc for the bases in
+    // double and float
+    template <typename T>
+    static std::vector<double> getOneLapEigenVec(
+        const LanczosBasis<T>& lanczosVectors,
+        const DenseMatrix& tridiagonalEigenVectors, const int& vectorIndex);
 
     void printLapEigenMat();
     void printLapEigenvalues();
     void outputLapEigenvalues();
+    // Local parts of the eigenvectors the colours are taken from, to warm
+    // start the next run
+    const std::vector<std::vector<double>>& eigenvectors() const
+    {
+        return laplacianEigenMatrix_;
+    }
+    // Start vectors from a colouring, +-1 by bit r of the colour in vector
+    // r, 0 for the vertices without a colour (-1)
+    static std::vector<std::vector<double>> colourVectors(
+        const std::vector<int>& colours, const int& numOfSubGraphs);
     std::vector<double> ritzValues;
     std::vector<double> times;
 };
@@ -0,0 +1,53 @@
+/**
+ * @file random_stream.h
+ * @brief Random numbers of the start vectors, per thread once seeded
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef RANDOM_STREAM_H_
+#define RANDOM_STREAM_H_
+
+#include <cstdlib>
+
+/*
+ * =====================================================================================
+ *        Class:  RandomStream
+ *  Description:  The uniform random numbers of the Lanczos start vectors.
+ *                drand48 on a thread never seeded, so srand48 still
+ *                reproduces a run, otherwise the erand48 stream of the
+ *                calling thread. Solves on concurrent threads draw their
+ *                own reproducible numbers instead of racing on the state of
+ *                drand48.
+ * =====================================================================================
+ */
+
+class RandomStream
+{
+private:
+    struct State {
+        bool seeded;
+        unsigned short xsubi[3];
+    };
+    static State& state()
+    {
+        static thread_local State stream = {false, {0, 0, 0}};
+        return stream;
+    }
+
+public:
+    static void seedThread(const long& seed)
+    {
+        State& stream = state();
+        stream.seeded = true;
+        stream.xsubi[0] = 0x330e;  // As srand48
+        stream.xsubi[1] = seed & 0xffff;
+        stream.xsubi[2] = (seed >> 16) & 0xffff;
+    }
+    static double uniform()
+    {
+        State& stream = state();
+        return stream.seeded ? erand48(stream.xsubi) : drand48();
+    }
+};
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file reorthogonalisation.h
+ * @brief Header file for reorthogonalisation.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef REORTHOGONALISATION_H_
+#define REORTHOGONALISATION_H_
+
+#include <vector>
+
+/*
+ * =====================================================================================
+ *        Class:  PartialReorthogonalisation
+ *  Description:  Simon's partial reorthogonalisation. The omega recurrence
+ *                estimates omega[k] = q_j . q_k from alpha and beta only, a
+ *                new Lanczos vector is orthogonalised when max |omega| passes
+ *                sqrt(eps), against the vectors with |omega| > eps^(3/4), and
+ *                the next vector against the same ones.
+ * =====================================================================================
+ */
+
+class PartialReorthogonalisation
+{
+private:
+    double eps_, anorm_;
+    std::vector<double> alpha_, beta_;
+    std::vector<double> omegaPrev_, omegaCur_;  // Of q_(j-1) and q_j
+    std::vector<int> against_;
+    bool repeat_;
+    int steps_, vectors_;
+
+public:
+    // eps is the precision the Lanczos vectors are stored in
+    explicit PartialReorthogonalisation(double eps);
+
+    // alpha_j and beta_j of step j, return the vectors q_k that q_(j+1) has
+    // to be orthogonalised against
+    const std::vector<int>& next(double alpha, double beta);
+    // q_(j+1) is orthogonalised, beta is its norm before normalisation
+    void orthogonalised(double beta);
+
+    int steps() const { return steps_; }      // Steps reorthogonalised
+    int vectors() const { return vectors_; }  // Vectors orthogonalised against
+};
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * @file repartition.h
+ * @brief Header file for repartition.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef REPARTITION_H_
+#define REPARTITION_H_
+
+#include <utility>
+#include <vector>
+#include "graph.h"
+#include "partition.h"
+
+/*
+ * =====================================================================================
+ *        Class:  Repartition
+ *  Description:  Keeps the partition of a graph under batches of edge
+ *                insertions and deletions. The colours around the updated
+ *                edges are refined greedily, a vertex moves to the colour of
+ *                most of its neighbours if that cuts fewer edges and the
+ *                colour stays within the imbalance (or gets no worse). The
+ *                spectral partition is only recomputed, warm started from
+ *                the last eigenvectors, when the cut edge percent has grown
+ *                by more than the tolerance since the last one.
+ * =====================================================================================
+ */
+
+class Repartition
+{
+public:
+    typedef std::vector<std::pair<int, int>> Edges;
+
+    Repartition(Graph& g, const int& numOfSubGraphs,
+                const PartitionOptions& options = PartitionOptions(),
+                const double& tolerance = 0.1, const double& imbalance = 0.05);
+
+    // Apply the batch to the graph and update the colours, true if the
+    // partition was recomputed. Every process has to call it with the same
+    // batch.
+    bool update(const Edges& inserted, const Edges& removed);
+
+    double cut() const { return cut_; }  // Of the last update
+    int moves;       // Vertices moved by the refinement so far
+    int recomputes;  // Full partitions after the first one
+
+private:
+    Graph& g_;
+    int numOfSubGraphs_;
+    PartitionOptions options_;
+    double tolerance_, imbalance_;
+    double cut_, baseline_;  // Cut edge percent now and after the last
+                             // full partition
+
+    void partition();
+    void refine(const Edges& inserted, const Edges& removed);
+};
+
+#endif
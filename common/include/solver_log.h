@@ -0,0 +1,41 @@
+/**
+ * @file solver_log.h
+ * @brief Progress messages of the eigensolvers, per thread once redirected
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef SOLVER_LOG_H_
+#define SOLVER_LOG_H_
+
+#include <iostream>
+
+/*
+ * =====================================================================================
+ *        Class:  SolverLog
+ *  Description:  The stream the eigensolvers report their iterations to.
+ *                std::cout on a thread never redirected, otherwise the
+ *                stream of the calling thread, so the solves of components
+ *                on concurrent threads are collected and printed in turn
+ *                instead of interleaving.
+ * =====================================================================================
+ */
+
+class SolverLog
+{
+private:
+    static std::ostream*& target()
+    {
+        static thread_local std::ostream* stream = &std::cout;
+        return stream;
+    }
+
+public:
+    // nullptr goes back to std::cout
+    static void redirect(std::ostream* stream)
+    {
+        target() = stream ? stream : &std::cout;
+    }
+    static std::ostream& out() { return *target(); }
+};
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file timers.h
+ * @brief Header file for timers.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * =====================================================================================
+ *        Class:  Timers
+ *  Description:  Registry of wall-clock (steady clock) timers. A Scope adds
+ *                the time between its construction and destruction (or
+ *                stop) to the entry of its path, the names of the enclosing
+ *                scopes joined by '/', e.g. "partition/lanczos/spmv". Each
+ *                (enclosing scope, name) pair is interned once into a node
+ *                of a tree, a scope after the first one of its path only
+ *                adds to its node, the paths are built by entries(). Each
+ *                thread has its own registry, merge() adds the entries of
+ *                a worker thread to the calling one. Independent of the VT_
+ *                tracing, the scopes are events of the Trace timeline when
+ *                built with Trace_.
+ * =====================================================================================
+ */
+
+class Timers
+{
+public:
+    // <path, <seconds, calls>>
+    typedef std::map<std::string, std::pair<double, long long>> Entries;
+
+    class Scope
+    {
+    private:
+        std::chrono::steady_clock::time_point start_;
+        const char* name_;
+        int node_, parent_;  // Of the scope and of the enclosing one
+        bool running_;
+
+    public:
+        explicit Scope(const char* name);
+        ~Scope() { stop(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        // Record the time now instead of at the end of the scope, the
+        // inner scopes have to be stopped already
+        double stop();
+        double elapsed() const;  // Seconds since the start
+    };
+
+    static const Entries& entries();  // Of the calling thread
+    static void reset();
+    // Add the entries, e.g. of a worker thread, under the running scope of
+    // the calling thread
+    static void merge(const Entries& entries);
+    // JSON of the entries of each process, the min, max and average
+    // seconds over the processes (0 for a process without the entry) and
+    // the max calls
+    static void report(std::ostream& out,
+                       const std::vector<Entries>& processes);
+};
+
+#endif
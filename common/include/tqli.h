@@ -11,5 +11,18 @@
 
 void tqli(std::vector<double>& d, std::vector<double>& e,
           std::vector<std::vector<double>>& z);
+void tqliLastRow(std::vector<double>& d, std::vector<double>& e,
+                 std::vector<double>& last);
+bool ritzConverged(const std::vector<double>& alpha,
+                   const std::vector<double>& beta, const double& next_beta,
+                   const int& num, const double& tol);
+bool blockRitzConverged(const std::vector<std::vector<double>>& block_tri,
+                        const int& n, const std::vector<double>& next_beta,
+                        const int& b, const int& num, const double& tol);
+void tred2(std::vector<std::vector<double>>& z, std::vector<double>& d,
+           std::vector<double>& e);
+void symmetricEigen(const std::vector<std::vector<double>>& a,
+                    std::vector<double>& d,
+                    std::vector<std::vector<double>>& z);
 
 #endif
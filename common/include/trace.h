@@ -0,0 +1,78 @@
+/**
+ * @file trace.h
+ * @brief Header file for trace.cc
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A slice of the timeline from here to the end of the block, nothing unless
+// built with -DTrace_=ON
+#ifdef Trace_
+#define TRACE_SCOPE(name) Trace::Scope trace_scope_(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+/*
+ * =====================================================================================
+ *        Class:  Trace
+ *  Description:  Timeline of the solver phases in the Chrome trace format
+ *                (chrome://tracing, ui.perfetto.dev), one complete event
+ *                (begin and duration) per scope, of each process and thread.
+ *                The events go into a ring buffer allocated by start(), once
+ *                full the oldest ones are overwritten. The Timers scopes are
+ *                recorded too when built with Trace_.
+ * =====================================================================================
+ */
+
+class Trace
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Event {
+        const char* name;    // A literal, only the pointer is kept
+        int64_t begin, end;  // Nanoseconds since start()
+        int thread;          // In the order of the first event, main is 0
+    };
+
+    class Scope
+    {
+    private:
+        const char* name_;
+        Clock::time_point start_;
+
+    public:
+        explicit Scope(const char* name) : name_(name), start_(Clock::now())
+        {
+        }
+        ~Scope() { record(name_, start_, Clock::now()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // Allocate the buffer of the given number of events and start the
+    // clock, on the main thread before the others record, nothing is
+    // recorded before
+    static void start(const size_t& capacity = 1 << 16);
+    static void record(const char* name, const Clock::time_point& begin,
+                       const Clock::time_point& end);
+    static std::vector<Event> events();  // The oldest first
+    static uint64_t dropped();           // Overwritten events
+
+    // The events as JSON objects of the process, separated by commas
+    static std::string json(const int& process);
+    // The trace file of the json of each process
+    static void write(std::ostream& out,
+                      const std::vector<std::string>& processes);
+};
+
+#endif
@@ -6,8 +6,11 @@
 
 #include "analysis.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <string>
 #include <vector>
 #include "partition.h"
@@ -21,7 +24,7 @@ using namespace std;
  */
 double Analysis::cutEdgePercent(const Graph& g)
 {
-    int numOfCutEdges = 0;
+    int64_t numOfCutEdges = 0;
     if (g.subgraphsNum() == 1) {
         return 0.0;
     }
@@ -37,6 +40,80 @@ double Analysis::cutEdgePercent(const Graph& g)
     return (double)numOfCutEdges / (double)g.edgesNum() / 2.0;
 }
 
+/**
+ * @brief Weights of the cut edges and all the edges of each colour, of the
+ *        vertices in the (local) graph
+ */
+static void cutAndVolume(const Graph& g, map<int, double>& cut,
+                         map<int, double>& volume, map<int, int>& vertices)
+{
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        int vertexColour = g.getColour(it->first);
+        vertices[vertexColour]++;
+        for (const int& neighbour : it->second) {
+            double weight = g.getWeight(it->first, neighbour);
+            volume[vertexColour] += weight;
+            if (g.getColour(neighbour) != vertexColour) {
+                cut[vertexColour] += weight;
+            }
+        }
+    }
+}
+
+/**
+ * @brief The ratio cut, sum of cut(A) / |A| over the subgraphs A, minimised
+ *        by the combinatorial Laplacian
+ * @param g The graph to be analysed
+ * @return The ratio cut
+ */
+double Analysis::ratioCut(const Graph& g)
+{
+    map<int, double> cut, volume;
+    map<int, int> vertices;
+    cutAndVolume(g, cut, volume, vertices);
+    double ratio = 0.0;
+    for (const auto& it : cut) {
+        ratio += it.second / vertices[it.first];
+    }
+    return ratio;
+}
+
+/**
+ * @brief The normalised cut, sum of cut(A) / vol(A) over the subgraphs A,
+ *        vol(A) is the sum of the weighted degrees, minimised by the
+ *        normalised Laplacians
+ * @param g The graph to be analysed
+ * @return The normalised cut
+ */
+double Analysis::normalisedCut(const Graph& g)
+{
+    map<int, double> cut, volume;
+    map<int, int> vertices;
+    cutAndVolume(g, cut, volume, vertices);
+    double ncut = 0.0;
+    for (const auto& it : cut) {
+        ncut += it.second / volume[it.first];
+    }
+    return ncut;
+}
+
+/**
+ * @brief The bandwidth of the (local) Laplacian matrix, max |i - j| over the
+ *        edges, a smaller bandwidth means better locality in SpMV
+ * @param g The graph to be analysed
+ * @return The bandwidth
+ */
+int Analysis::bandwidth(const Graph& g)
+{
+    int maxDistance = 0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            maxDistance = max(maxDistance, abs(it->first - neighbour));
+        }
+    }
+    return maxDistance;
+}
+
 /**
  * cutEdgeVertexTable
  * @param g graph to be analysed
@@ -91,6 +168,8 @@ void Analysis::cutEdgeVertexTable(const Graph& g,
     copy(ritzValues.cbegin(), ritzValues.cend(), it_double);
     cout << endl
          << "Cut Edge Percent: " << cutEdgePercent(g) * 100 << "%" << endl;
+    cout << "Ratio Cut: " << ratioCut(g) << endl;
+    cout << "Normalised Cut: " << normalisedCut(g) << endl;
     cout << "/*----------------------------------------------------------------"
             "-------------"
          << endl;
@@ -225,6 +304,41 @@ void Analysis::evenPartition(const Graph& g, const int& colours)
     }
 }
 
+/**
+ * @brief Partition with the Lanczos vectors stored in double and in float
+ *        from the same starting vector, and compare the Ritz values and the
+ *        cut edges
+ * @param g The graph to partition, left coloured by the double run
+ * @param colours The number of subgraphs
+ * @param enableGramSchmidt Enable GramSchmidt
+ */
+void Analysis::precisionReport(const Graph& g, const int& colours,
+                               bool enableGramSchmidt)
+{
+    PartitionOptions options(enableGramSchmidt);
+    options.mixedPrecision = true;
+    srand48(1);
+    Partition mixed(g, colours, options);
+    double mixedCut = cutEdgePercent(g);
+
+    options.mixedPrecision = false;
+    srand48(1);
+    Partition full(g, colours, options);
+    double fullCut = cutEdgePercent(g);
+
+    cout << "Ritz value	double	float basis	difference" << endl;
+    for (unsigned int i = 0; i < full.ritzValues.size(); i++) {
+        double mixedValue =
+            i < mixed.ritzValues.size() ? mixed.ritzValues[i] : 0.0;
+        cout << i << "\t" << full.ritzValues[i] << "\t" << mixedValue << "\t"
+             << abs(full.ritzValues[i] - mixedValue) << endl;
+    }
+    cout << "Cut Edge Percent: " << fullCut * 100 << "% (double), "
+         << mixedCut * 100 << "% (float basis)" << endl;
+    cout << "Lanczos takes " << full.times[0] << "s (double), "
+         << mixed.times[0] << "s (float basis)" << endl;
+}
+
 /**
  * @brief output the times into a file
  * @param numOfVertices
@@ -0,0 +1,83 @@
+/**
+ * @file basis.cc
+ * @brief File backed storage of the Lanczos vectors
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "basis.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief Create a temporary file of the given size in the directory and map
+ *        it, the file is unlinked at once so it is removed when unmapped or
+ *        when the process dies. Throws std::runtime_error if the disk has
+ *        no room for it.
+ * @param directory A directory on a fast local disk
+ * @param bytes Size of the file
+ */
+void MappedFile::open(const string& directory, size_t bytes)
+{
+    close();
+    if (bytes == 0) {
+        return;
+    }
+    string path = directory + "/lanczos_basis_XXXXXX";
+    vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    int fd = mkstemp(name.data());
+    if (fd == -1) {
+        throw runtime_error("Can't create a file in " + directory + ": " +
+                            strerror(errno));
+    }
+    unlink(name.data());
+    // Allocate the blocks now, a sparse file would fail with SIGBUS on a
+    // page write once the disk is full
+    int error = posix_fallocate(fd, 0, bytes);
+    if (error != 0) {
+        ::close(fd);
+        throw runtime_error(string("Can't allocate the basis file: ") +
+                            strerror(error));
+    }
+    void* addr =
+        mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    error = errno;
+    ::close(fd);  // The mapping keeps the file
+    if (addr == MAP_FAILED) {
+        throw runtime_error(string("Can't map the basis file: ") +
+                            strerror(error));
+    }
+    // The vectors are written and read in order
+    madvise(addr, bytes, MADV_SEQUENTIAL);
+    data_ = addr;
+    bytes_ = bytes;
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+        munmap(data_, bytes_);
+        data_ = nullptr;
+        bytes_ = 0;
+    }
+}
+
+/**
+ * @brief Ask the kernel to read the pages in the background, returns at once
+ * @param addr Start of the range in a mapping
+ * @param bytes Length of the range
+ */
+void MappedFile::willNeed(const void* addr, size_t bytes)
+{
+    static const uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(addr) + bytes;
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file chebyshev.cc
+ * @brief Chebyshev polynomial filtering
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef CHEBYSHEV_CC_
+#define CHEBYSHEV_CC_
+
+#include "chebyshev.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+/**
+ * @brief The spectral bound is computed once
+ * @param L The Laplacian matrix
+ * @param degree Degree of the polynomial, 0 disables the filter
+ * @param cut The damped interval starts at cut * bound
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+ChebyshevFilter<Vector, T, Operator, Index>::ChebyshevFilter(
+    Laplacian<Vector, T, Operator, Index>& L, const int& degree,
+    const T& cut)
+    : laplacian(L), degree_(degree), lower_(0.0), upper_(0.0)
+{
+    if (degree_ > 0) {
+        upper_ = laplacian.spectralBound();
+        lower_ = cut * upper_;
+    }
+}
+
+/**
+ * @brief Three-term recurrence of Chebyshev polynomials, scaled so that
+ *        p(0) = 1 (Zhou and Saad 2007) to avoid overflow
+ * @param x The vectors, returns p(L) x
+ * @param width Number of vectors
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void ChebyshevFilter<Vector, T, Operator, Index>::apply(Vector& x,
+                                                        const int& width)
+{
+#ifdef VT_
+    VT_TRACER("ChebyshevFilter::apply");
+#endif
+    if (degree_ <= 0 || upper_ <= lower_) {
+        return;
+    }
+    const T e = (upper_ - lower_) / 2.0, c = (upper_ + lower_) / 2.0;
+    const T sigma1 = e / (0.0 - c);
+    T sigma = sigma1;
+    const size_t n = x.size();
+    Vector y, y_new, ly;
+
+    // y = (L - c) x * sigma1 / e
+    laplacian.multiply(x, ly, width);
+    y.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        y[i] = (ly[i] - c * x[i]) * sigma1 / e;
+    }
+    y_new.resize(n);
+    for (int k = 1; k < degree_; k++) {
+        const T sigma_new = 1.0 / (2.0 / sigma1 - sigma);
+        laplacian.multiply(y, ly, width);
+        for (size_t i = 0; i < n; i++) {
+            y_new[i] = 2.0 * sigma_new / e * (ly[i] - c * y[i]) -
+                       sigma * sigma_new * x[i];
+        }
+        x.swap(y);
+        y.swap(y_new);
+        sigma = sigma_new;
+    }
+    x.swap(y);
+}
+
+#endif
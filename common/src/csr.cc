@@ -0,0 +1,232 @@
+/**
+ * @file csr.cc
+ * @brief Streaming reader of dot files into compressed sparse rows
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "csr.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "trace.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+using namespace std;
+
+/**
+ * @brief Parse a line of a dot file, "v;", "v[C=c];" or "src--dest ;", the
+ *        other lines (the header and "}") do not start with a digit
+ * @return The number of vertices on the line, 0, 1 or 2 for an edge
+ */
+static int parseLine(const string& line, int64_t& from, int64_t& to)
+{
+    const char* p = line.c_str();
+    while (*p == ' ' || *p == '\t') p++;
+    if (!isdigit(*p)) return 0;
+    char* end;
+    from = strtoll(p, &end, 10);
+    p = end;
+    while (*p == ' ' || *p == '\t') p++;
+    if (p[0] != '-' || p[1] != '-') return 1;
+    p += 2;
+    while (*p == ' ' || *p == '\t') p++;
+    if (!isdigit(*p)) return 1;
+    to = strtoll(p, &end, 10);
+    return 2;
+}
+
+/**
+ * @brief Call visit for each line starting in [begin, end) of the file, a
+ *        line across end belongs to this chunk and the one across begin to
+ *        the previous chunk
+ */
+static void forEachLine(const string& filename, long begin, long end,
+                        const function<void(const string&)>& visit)
+{
+    ifstream In(filename, ios::binary);
+    string line;
+    if (begin > 0) {
+        In.seekg(begin - 1);
+        getline(In, line);  // The rest of the line of the previous chunk
+    }
+    while (In.good() && (long)In.tellg() < end && getline(In, line)) {
+        visit(line);
+    }
+}
+
+/**
+ * @brief Run work(t, begin, end) on threads over equal byte ranges of a file
+ */
+static void overChunks(const string& filename, const int& threads,
+                       const function<void(int, long, long)>& work)
+{
+    ifstream In(filename, ios::binary | ios::ate);
+    long size = In.tellg();
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            TRACE_SCOPE("read_chunk");
+            work(t, size * t / threads, size * (t + 1) / threads);
+        });
+    }
+    for (auto& worker : pool) {
+        worker.join();
+    }
+}
+
+template <typename Index>
+Csr<Index> readDotFormatCsr(const string& filename, int threads)
+{
+#ifdef VT_
+    VT_TRACER("readDotFormatCsr");
+#endif
+    if (!ifstream(filename).is_open()) {
+        throw runtime_error("Can't open the file " + filename);
+    }
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+
+    // Pass 1: the ends of the edges of each thread are buffered and merged
+    // into the shared degrees in batches, no thread holds its own array of
+    // all the vertices
+    const int64_t max_id = numeric_limits<Index>::max() - 1;
+    const size_t batch = 1 << 16;
+    atomic<bool> too_large(false);
+    mutex degrees_mutex;
+    vector<int64_t> degrees;
+    overChunks(filename, threads, [&](int t, long begin, long end) {
+        vector<int64_t> ends;
+        ends.reserve(batch);
+        int64_t from = 0, to = 0, largest = -1;
+        auto merge = [&]() {
+            lock_guard<mutex> lock(degrees_mutex);
+            if (largest >= (int64_t)degrees.size()) {
+                degrees.resize(largest + 1, 0);
+            }
+            for (const int64_t& vertex : ends) {
+                degrees[vertex]++;
+            }
+            ends.clear();
+        };
+        forEachLine(filename, begin, end, [&](const string& line) {
+            int vertices = parseLine(line, from, to);
+            int64_t last = vertices == 2 ? max(from, to) : from;
+            if (vertices > 0 && last > max_id) {
+                too_large = true;
+                return;
+            }
+            if (vertices > 0) {
+                largest = max(largest, last);
+            }
+            if (vertices == 2 && from != to) {
+                ends.push_back(from);
+                ends.push_back(to);
+                if (ends.size() >= batch) {
+                    merge();
+                }
+            }
+        });
+        merge();
+    });
+    if (too_large) {
+        throw out_of_range("Vertex id out of the index range in " + filename);
+    }
+    Csr<Index> csr;
+    Index size = degrees.size();
+    csr.offsets.assign(size + 1, 0);
+    for (Index v = 0; v < size; v++) {
+        csr.offsets[v + 1] = csr.offsets[v] + degrees[v];
+    }
+    vector<int64_t>().swap(degrees);
+
+    // Pass 2: both ends of each edge into the rows
+    csr.neighbours.resize(csr.offsets[size]);
+    unique_ptr<atomic<int64_t>[]> cursor(new atomic<int64_t>[size]);
+    for (Index v = 0; v < size; v++) {
+        cursor[v] = csr.offsets[v];
+    }
+    overChunks(filename, threads, [&](int t, long begin, long end) {
+        int64_t from = 0, to = 0;
+        forEachLine(filename, begin, end, [&](const string& line) {
+            if (parseLine(line, from, to) == 2 && from != to) {
+                csr.neighbours[cursor[from]++] = to;
+                csr.neighbours[cursor[to]++] = from;
+            }
+        });
+    });
+    cursor.reset();
+
+    // Sort and remove the duplicates of each row, then close the gaps
+    vector<int64_t> unique_degree(size);
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            TRACE_SCOPE("sort_rows");
+            for (Index v = (int64_t)size * t / threads;
+                 v < (int64_t)size * (t + 1) / threads; v++) {
+                auto first = csr.neighbours.begin() + csr.offsets[v];
+                auto last = csr.neighbours.begin() + csr.offsets[v + 1];
+                sort(first, last);
+                unique_degree[v] = unique(first, last) - first;
+            }
+        });
+    }
+    for (auto& worker : pool) {
+        worker.join();
+    }
+    int64_t next = 0;
+    for (Index v = 0; v < size; v++) {
+        int64_t first = csr.offsets[v];
+        csr.offsets[v] = next;
+        for (int64_t i = 0; i < unique_degree[v]; i++) {
+            csr.neighbours[next++] = csr.neighbours[first + i];
+        }
+    }
+    csr.offsets[size] = next;
+    // Both directions of a dot file were stored, give the half back
+    csr.neighbours.resize(next);
+    csr.neighbours.shrink_to_fit();
+    return csr;
+}
+
+void countDotFormat(const string& filename, int64_t& vertices,
+                    int64_t& edges, int threads)
+{
+    if (!ifstream(filename).is_open()) {
+        throw runtime_error("Can't open the file " + filename);
+    }
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    vector<int64_t> ids(threads, -1), lines(threads, 0);
+    overChunks(filename, threads, [&](int t, long begin, long end) {
+        int64_t from = 0, to = 0;
+        forEachLine(filename, begin, end, [&](const string& line) {
+            int count = parseLine(line, from, to);
+            if (count > 0) {
+                ids[t] = max(ids[t], count == 2 ? max(from, to) : from);
+            }
+            lines[t] += count == 2 && from < to;  // Both directions listed
+        });
+    });
+    vertices = *max_element(ids.begin(), ids.end()) + 1;
+    edges = 0;
+    for (const int64_t& count : lines) {
+        edges += count;
+    }
+}
+
+template Csr<int32_t> readDotFormatCsr(const string& filename, int threads);
+template Csr<int64_t> readDotFormatCsr(const string& filename, int threads);
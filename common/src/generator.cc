@@ -0,0 +1,344 @@
+/**
+ * @file generator.cc
+ * @brief Counter-based random graph generators
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "generator.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include "trace.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+using namespace std;
+
+/**
+ * @brief The finaliser of splitmix64, a bijection of 64-bit integers with
+ *        good avalanche
+ */
+static uint64_t mix(uint64_t z)
+{
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+Generator::Model Generator::model(const string& name)
+{
+    if (name == "erdos-renyi") {
+        return ErdosRenyi;
+    } else if (name == "rmat") {
+        return Rmat;
+    } else if (name == "geometric") {
+        return Geometric;
+    }
+    throw invalid_argument("Unknown graph model: " + name);
+}
+
+/**
+ * @brief Set up a generator, no edge is generated until edges
+ * @param model The random graph model
+ * @param vertices Number of vertices
+ * @param edges Number of edges drawn for ErdosRenyi and Rmat, the expected
+ *        number of edges for Geometric
+ * @param seed The same seed gives the same graph
+ */
+Generator::Generator(Model model, const int64_t& vertices,
+                     const int64_t& edges, const uint64_t& seed)
+    : a(0.57),
+      b(0.19),
+      c(0.19),
+      model_(model),
+      vertices_(vertices),
+      edges_(edges),
+      seed_(seed),
+      cellsPerSide_(1),
+      radius_(0.0)
+{
+    if (vertices <= 0 || edges < 0) {
+        throw invalid_argument("A graph needs vertices and no negative edges");
+    }
+    if (model == Geometric) {
+        // n^2 pi r^2 / 2 edges on average, ignoring the border
+        radius_ = sqrt(2.0 * edges / M_PI) / vertices;
+        double side = radius_ > 0.0 ? floor(1.0 / radius_) : vertices;
+        cellsPerSide_ = max<int64_t>(
+            1, (int64_t)min(side, floor(sqrt((double)vertices))));
+    }
+}
+
+/**
+ * @brief Generate a slice of the graph, the slices of all the parts are
+ *        the whole graph whatever the number of parts is
+ * @param part Index of the slice, e.g. the rank of the process
+ * @param parts Number of slices
+ * @param threads Number of threads, 0 for the hardware concurrency
+ * @return The edges, of the edge counters in the slice for ErdosRenyi and
+ *         Rmat, of the vertices in the slice to the higher ones for
+ *         Geometric
+ */
+Generator::Edges Generator::edges(const int& part, const int& parts,
+                                  int threads) const
+{
+#ifdef VT_
+    VT_TRACER("Generator::edges");
+#endif
+    if (parts <= 0 || part < 0 || part >= parts) {
+        throw out_of_range("Slice out of the number of parts");
+    }
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    const int64_t total = model_ == Geometric ? vertices_ : edges_;
+    const int64_t first = total * part / parts;
+    const int64_t last = total * (part + 1) / parts;
+
+    vector<Edges> chunks(threads);
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            TRACE_SCOPE("generate_chunk");
+            int64_t begin = first + (last - first) * t / threads;
+            int64_t end = first + (last - first) * (t + 1) / threads;
+            if (model_ == ErdosRenyi) {
+                erdosRenyiEdges(begin, end, chunks[t]);
+            } else if (model_ == Rmat) {
+                rmatEdges(begin, end, chunks[t]);
+            } else {
+                geometricEdges(begin, end, chunks[t]);
+            }
+        });
+    }
+    for (auto& worker : pool) {
+        worker.join();
+    }
+    size_t size = 0;
+    for (const auto& chunk : chunks) {
+        size += chunk.size();
+    }
+    Edges edges;
+    edges.reserve(size);
+    for (auto& chunk : chunks) {
+        edges.insert(edges.end(), chunk.begin(), chunk.end());
+        Edges().swap(chunk);
+    }
+    return edges;
+}
+
+/**
+ * @brief Uniform in [0, 1), a hash of the seed, the stream and the counter
+ */
+double Generator::uniform(const uint64_t& counter,
+                          const uint64_t& stream) const
+{
+    // The top 53 bits over 2^53
+    return (mix(mix(seed_ + stream) ^ counter) >> 11) / 9007199254740992.0;
+}
+
+void Generator::erdosRenyiEdges(int64_t first, int64_t last,
+                                Edges& edges) const
+{
+    edges.reserve(last - first);
+    for (int64_t i = first; i < last; i++) {
+        int64_t u = min<int64_t>(uniform(i, 0) * vertices_, vertices_ - 1);
+        int64_t v = min<int64_t>(uniform(i, 1) * vertices_, vertices_ - 1);
+        edges.emplace_back(u, v);
+    }
+}
+
+/**
+ * @brief One quadrant per bit of the ids, the ids beyond the number of
+ *        vertices (not a power of 2) wrap around
+ */
+void Generator::rmatEdges(int64_t first, int64_t last, Edges& edges) const
+{
+    int scale = 0;
+    while (((int64_t)1 << scale) < vertices_) scale++;
+    edges.reserve(last - first);
+    for (int64_t i = first; i < last; i++) {
+        int64_t u = 0, v = 0;
+        for (int level = 0; level < scale; level++) {
+            double r = uniform(i, level);
+            u = 2 * u + (r >= a + b);
+            v = 2 * v + (r >= a && (r < a + b || r >= a + b + c));
+        }
+        edges.emplace_back(u % vertices_, v % vertices_);
+    }
+}
+
+/**
+ * @brief Binomial of the given trials and probability, a function of the
+ *        counter: a sum of Bernoulli draws for few trials, the inversion
+ *        of the distribution for a small mean and the rounded normal
+ *        approximation otherwise
+ */
+int64_t Generator::binomial(const int64_t& trials, const double& p,
+                            const uint64_t& counter) const
+{
+    // Draw the rarer outcome
+    const double q = min(p, 1.0 - p);
+    int64_t successes = 0;
+    if (trials < 32) {
+        for (int64_t i = 0; i < trials; i++) {
+            successes += uniform(counter, 2 + i) < q;
+        }
+    } else if (trials * q < 16.0) {
+        double u = uniform(counter, 2);
+        double f = pow(1.0 - q, (double)trials);
+        while (u >= f && successes < trials) {
+            u -= f;
+            f *= q / (1.0 - q) * (trials - successes) / (successes + 1);
+            successes++;
+        }
+    } else {
+        double z = sqrt(-2.0 * log(1.0 - uniform(counter, 2))) *
+                   cos(2.0 * M_PI * uniform(counter, 3));
+        double x = trials * q + z * sqrt(trials * q * (1.0 - q));
+        successes = max<int64_t>(0, min<int64_t>(trials, llround(x)));
+    }
+    return p <= 0.5 ? successes : trials - successes;
+}
+
+/**
+ * @brief The number of the vertices of the cells [lo, hi) that fall in the
+ *        first half [lo, (lo + hi) / 2), node numbers the halvings from 1
+ *        for the whole grid as in a heap, so each halving is drawn once
+ *        whoever asks for it
+ */
+int64_t Generator::split(const uint64_t& node, const int64_t& lo,
+                         const int64_t& hi, const int64_t& vertices) const
+{
+    const int64_t mid = lo + (hi - lo) / 2;
+    return binomial(vertices, (double)(mid - lo) / (hi - lo), node);
+}
+
+/**
+ * @brief The vertices are numbered cell by cell, the counts of the cells
+ *        are multinomial by halving the grid with binomial splits, and the
+ *        vertices are at uniform points in their cell, so the neighbours
+ *        of a vertex are in the 3 x 3 cells around it
+ */
+void Generator::geometricEdges(int64_t first, int64_t last,
+                               Edges& edges) const
+{
+    if (first >= last) {
+        return;
+    }
+    const int64_t k = cellsPerSide_;
+    const double r2 = radius_ * radius_;
+    const int64_t firstCell = cellOf(first), lastCell = cellOf(last - 1);
+
+    // The first vertices of the rows of cells around the slice
+    const int64_t low = max<int64_t>(0, firstCell / k - 1) * k;
+    const int64_t high = min(k, lastCell / k + 2) * k;
+    vector<int64_t> firsts(high - low + 1);
+    cellFirsts(1, 0, k * k, 0, vertices_, low, firsts);
+    firsts.back() = firstOf(high);
+
+    for (int64_t cell = firstCell; cell <= lastCell; cell++) {
+        for (int64_t v = max(first, firsts[cell - low]);
+             v < min(last, firsts[cell + 1 - low]); v++) {
+            pair<double, double> p = point(v, cell);
+            for (int64_t y = max<int64_t>(0, cell / k - 1);
+                 y <= min(k - 1, cell / k + 1); y++) {
+                for (int64_t x = max<int64_t>(0, cell % k - 1);
+                     x <= min(k - 1, cell % k + 1); x++) {
+                    int64_t neighbour = y * k + x;
+                    for (int64_t u = max(v + 1, firsts[neighbour - low]);
+                         u < firsts[neighbour + 1 - low]; u++) {
+                        pair<double, double> q = point(u, neighbour);
+                        double dx = p.first - q.first;
+                        double dy = p.second - q.second;
+                        if (dx * dx + dy * dy < r2) {
+                            edges.emplace_back(v, u);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int64_t Generator::cellOf(const int64_t& vertex) const
+{
+    int64_t lo = 0, hi = cellsPerSide_ * cellsPerSide_;
+    int64_t base = 0, count = vertices_;
+    uint64_t node = 1;
+    while (hi - lo > 1) {
+        int64_t left = split(node, lo, hi, count);
+        if (vertex - base < left) {
+            hi = lo + (hi - lo) / 2;
+            count = left;
+            node = 2 * node;
+        } else {
+            lo = lo + (hi - lo) / 2;
+            base += left;
+            count -= left;
+            node = 2 * node + 1;
+        }
+    }
+    return lo;
+}
+
+int64_t Generator::firstOf(const int64_t& cell) const
+{
+    int64_t lo = 0, hi = cellsPerSide_ * cellsPerSide_;
+    if (cell >= hi) {
+        return vertices_;
+    }
+    int64_t base = 0, count = vertices_;
+    uint64_t node = 1;
+    while (hi - lo > 1) {
+        int64_t left = split(node, lo, hi, count);
+        if (cell < lo + (hi - lo) / 2) {
+            hi = lo + (hi - lo) / 2;
+            count = left;
+            node = 2 * node;
+        } else {
+            lo = lo + (hi - lo) / 2;
+            base += left;
+            count -= left;
+            node = 2 * node + 1;
+        }
+    }
+    return base;
+}
+
+/**
+ * @brief The first vertices of the cells [low, low + firsts.size() - 1)
+ *        under the halving node of the cells [lo, hi), whose first vertex
+ *        is base and that hold count vertices, in a single walk of the
+ *        halvings instead of one per cell
+ */
+void Generator::cellFirsts(const uint64_t& node, const int64_t& lo,
+                           const int64_t& hi, const int64_t& base,
+                           const int64_t& count, const int64_t& low,
+                           vector<int64_t>& firsts) const
+{
+    const int64_t high = low + firsts.size() - 1;
+    if (hi <= low || lo >= high) {
+        return;
+    }
+    if (hi - lo == 1) {
+        firsts[lo - low] = base;
+        return;
+    }
+    const int64_t mid = lo + (hi - lo) / 2;
+    const int64_t left = split(node, lo, hi, count);
+    cellFirsts(2 * node, lo, mid, base, left, low, firsts);
+    cellFirsts(2 * node + 1, mid, hi, base + left, count - left, low, firsts);
+}
+
+pair<double, double> Generator::point(const int64_t& vertex,
+                                      const int64_t& cell) const
+{
+    const double k = cellsPerSide_;
+    return make_pair((cell % cellsPerSide_ + uniform(vertex, 0)) / k,
+                     (cell / cellsPerSide_ + uniform(vertex, 1)) / k);
+}
@@ -0,0 +1,504 @@
+/**
+ * @file kernels.cc
+ * @brief SIMD vector kernels with runtime dispatch
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "kernels.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define KERNELS_X86_
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+/**
+ * @brief Scalar kernels, also handle the tails of the SIMD kernels
+ */
+
+template <typename S, typename T>
+static T dotScalar(const S* x, const T* y, int n)
+{
+    T sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+template <typename T>
+static T updateScalar(T* w, const T* v1, const T* v0, T alpha, T beta, int n)
+{
+    T sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        w[i] = w[i] - alpha * v1[i] - beta * v0[i];
+        sum += w[i] * w[i];
+    }
+    return sum;
+}
+
+template <typename S, typename T>
+static void axpyScalar(T* y, const S* x, T a, int n)
+{
+    for (int i = 0; i < n; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+template <typename T>
+static void scaleScalar(T* y, const T* x, T a, int n)
+{
+    for (int i = 0; i < n; i++) {
+        y[i] = a * x[i];
+    }
+}
+
+template <typename S, typename T>
+static void convertScalar(S* y, const T* x, int n)
+{
+    for (int i = 0; i < n; i++) {
+        y[i] = x[i];
+    }
+}
+
+#ifdef KERNELS_X86_
+
+/**
+ * @brief AVX2 kernels, 4 doubles or 8 floats per register
+ */
+
+TARGET_AVX2 static double dotAVX2(const double* x, const double* y, int n)
+{
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i),
+                               sum0);
+        sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4),
+                               _mm256_loadu_pd(y + i + 4), sum1);
+    }
+    double buf[4];
+    _mm256_storeu_pd(buf, _mm256_add_pd(sum0, sum1));
+    return buf[0] + buf[1] + buf[2] + buf[3] + dotScalar(x + i, y + i, n - i);
+}
+
+TARGET_AVX2 static float dotAVX2(const float* x, const float* y, int n)
+{
+    __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i),
+                               sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8),
+                               _mm256_loadu_ps(y + i + 8), sum1);
+    }
+    float buf[8];
+    _mm256_storeu_ps(buf, _mm256_add_ps(sum0, sum1));
+    float sum = 0.0;
+    for (int j = 0; j < 8; j++) sum += buf[j];
+    return sum + dotScalar(x + i, y + i, n - i);
+}
+
+TARGET_AVX2 static double updateAVX2(double* w, const double* v1,
+                                     const double* v0, double alpha,
+                                     double beta, int n)
+{
+    __m256d a = _mm256_set1_pd(alpha), b = _mm256_set1_pd(beta);
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d wi = _mm256_loadu_pd(w + i);
+        wi = _mm256_fnmadd_pd(a, _mm256_loadu_pd(v1 + i), wi);
+        wi = _mm256_fnmadd_pd(b, _mm256_loadu_pd(v0 + i), wi);
+        _mm256_storeu_pd(w + i, wi);
+        sum = _mm256_fmadd_pd(wi, wi, sum);
+    }
+    double buf[4];
+    _mm256_storeu_pd(buf, sum);
+    return buf[0] + buf[1] + buf[2] + buf[3] +
+           updateScalar(w + i, v1 + i, v0 + i, alpha, beta, n - i);
+}
+
+TARGET_AVX2 static float updateAVX2(float* w, const float* v1, const float* v0,
+                                    float alpha, float beta, int n)
+{
+    __m256 a = _mm256_set1_ps(alpha), b = _mm256_set1_ps(beta);
+    __m256 sum = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 wi = _mm256_loadu_ps(w + i);
+        wi = _mm256_fnmadd_ps(a, _mm256_loadu_ps(v1 + i), wi);
+        wi = _mm256_fnmadd_ps(b, _mm256_loadu_ps(v0 + i), wi);
+        _mm256_storeu_ps(w + i, wi);
+        sum = _mm256_fmadd_ps(wi, wi, sum);
+    }
+    float buf[8], total = 0.0;
+    _mm256_storeu_ps(buf, sum);
+    for (int j = 0; j < 8; j++) total += buf[j];
+    return total + updateScalar(w + i, v1 + i, v0 + i, alpha, beta, n - i);
+}
+
+TARGET_AVX2 static void axpyAVX2(double* y, const double* x, double a, int n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i),
+                                                _mm256_loadu_pd(y + i)));
+    }
+    axpyScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX2 static void axpyAVX2(float* y, const float* x, float a, int n)
+{
+    __m256 va = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i),
+                                                _mm256_loadu_ps(y + i)));
+    }
+    axpyScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX2 static void scaleAVX2(double* y, const double* x, double a, int n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_mul_pd(va, _mm256_loadu_pd(x + i)));
+    }
+    scaleScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX2 static void scaleAVX2(float* y, const float* x, float a, int n)
+{
+    __m256 va = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(va, _mm256_loadu_ps(x + i)));
+    }
+    scaleScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX2 static double dotAVX2(const float* x, const double* y, int n)
+{
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i)),
+                               _mm256_loadu_pd(y + i), sum0);
+        sum1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i + 4)),
+                               _mm256_loadu_pd(y + i + 4), sum1);
+    }
+    double buf[4];
+    _mm256_storeu_pd(buf, _mm256_add_pd(sum0, sum1));
+    return buf[0] + buf[1] + buf[2] + buf[3] + dotScalar(x + i, y + i, n - i);
+}
+
+TARGET_AVX2 static void axpyAVX2(double* y, const float* x, double a, int n)
+{
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(
+            y + i, _mm256_fmadd_pd(va, _mm256_cvtps_pd(_mm_loadu_ps(x + i)),
+                                   _mm256_loadu_pd(y + i)));
+    }
+    axpyScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX2 static void convertAVX2(float* y, const double* x, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(y + i, _mm256_cvtpd_ps(_mm256_loadu_pd(x + i)));
+    }
+    convertScalar(y + i, x + i, n - i);
+}
+
+/**
+ * @brief AVX-512 kernels, 8 doubles or 16 floats per register
+ */
+
+TARGET_AVX512 static double reduceAVX512(__m512d sum)
+{
+    double buf[8], total = 0.0;
+    _mm512_storeu_pd(buf, sum);
+    for (int j = 0; j < 8; j++) total += buf[j];
+    return total;
+}
+
+TARGET_AVX512 static float reduceAVX512(__m512 sum)
+{
+    float buf[16], total = 0.0;
+    _mm512_storeu_ps(buf, sum);
+    for (int j = 0; j < 16; j++) total += buf[j];
+    return total;
+}
+
+TARGET_AVX512 static double dotAVX512(const double* x, const double* y, int n)
+{
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i),
+                               sum0);
+        sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8),
+                               _mm512_loadu_pd(y + i + 8), sum1);
+    }
+    return reduceAVX512(_mm512_add_pd(sum0, sum1)) +
+           dotScalar(x + i, y + i, n - i);
+}
+
+TARGET_AVX512 static float dotAVX512(const float* x, const float* y, int n)
+{
+    __m512 sum0 = _mm512_setzero_ps(), sum1 = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i),
+                               sum0);
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16),
+                               _mm512_loadu_ps(y + i + 16), sum1);
+    }
+    return reduceAVX512(_mm512_add_ps(sum0, sum1)) +
+           dotScalar(x + i, y + i, n - i);
+}
+
+TARGET_AVX512 static double updateAVX512(double* w, const double* v1,
+                                         const double* v0, double alpha,
+                                         double beta, int n)
+{
+    __m512d a = _mm512_set1_pd(alpha), b = _mm512_set1_pd(beta);
+    __m512d sum = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d wi = _mm512_loadu_pd(w + i);
+        wi = _mm512_fnmadd_pd(a, _mm512_loadu_pd(v1 + i), wi);
+        wi = _mm512_fnmadd_pd(b, _mm512_loadu_pd(v0 + i), wi);
+        _mm512_storeu_pd(w + i, wi);
+        sum = _mm512_fmadd_pd(wi, wi, sum);
+    }
+    return reduceAVX512(sum) +
+           updateScalar(w + i, v1 + i, v0 + i, alpha, beta, n - i);
+}
+
+TARGET_AVX512 static float updateAVX512(float* w, const float* v1,
+                                        const float* v0, float alpha,
+                                        float beta, int n)
+{
+    __m512 a = _mm512_set1_ps(alpha), b = _mm512_set1_ps(beta);
+    __m512 sum = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 wi = _mm512_loadu_ps(w + i);
+        wi = _mm512_fnmadd_ps(a, _mm512_loadu_ps(v1 + i), wi);
+        wi = _mm512_fnmadd_ps(b, _mm512_loadu_ps(v0 + i), wi);
+        _mm512_storeu_ps(w + i, wi);
+        sum = _mm512_fmadd_ps(wi, wi, sum);
+    }
+    return reduceAVX512(sum) +
+           updateScalar(w + i, v1 + i, v0 + i, alpha, beta, n - i);
+}
+
+TARGET_AVX512 static void axpyAVX512(double* y, const double* x, double a,
+                                     int n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i),
+                                                _mm512_loadu_pd(y + i)));
+    }
+    axpyScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX512 static void axpyAVX512(float* y, const float* x, float a, int n)
+{
+    __m512 va = _mm512_set1_ps(a);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i),
+                                                _mm512_loadu_ps(y + i)));
+    }
+    axpyScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX512 static void scaleAVX512(double* y, const double* x, double a,
+                                      int n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_mul_pd(va, _mm512_loadu_pd(x + i)));
+    }
+    scaleScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX512 static void scaleAVX512(float* y, const float* x, float a, int n)
+{
+    __m512 va = _mm512_set1_ps(a);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_mul_ps(va, _mm512_loadu_ps(x + i)));
+    }
+    scaleScalar(y + i, x + i, a, n - i);
+}
+
+// The masked conversions avoid _mm512_undefined_*, which GCC 12 reports as
+// uninitialised.
+TARGET_AVX512 static inline __m512d widenAVX512(const float* x)
+{
+    return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(x));
+}
+
+TARGET_AVX512 static double dotAVX512(const float* x, const double* y, int n)
+{
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm512_fmadd_pd(widenAVX512(x + i), _mm512_loadu_pd(y + i),
+                               sum0);
+        sum1 = _mm512_fmadd_pd(widenAVX512(x + i + 8),
+                               _mm512_loadu_pd(y + i + 8), sum1);
+    }
+    return reduceAVX512(_mm512_add_pd(sum0, sum1)) +
+           dotScalar(x + i, y + i, n - i);
+}
+
+TARGET_AVX512 static void axpyAVX512(double* y, const float* x, double a,
+                                     int n)
+{
+    __m512d va = _mm512_set1_pd(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, widenAVX512(x + i),
+                                                _mm512_loadu_pd(y + i)));
+    }
+    axpyScalar(y + i, x + i, a, n - i);
+}
+
+TARGET_AVX512 static void convertAVX512(float* y, const double* x, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i,
+                         _mm512_maskz_cvtpd_ps(0xFF, _mm512_loadu_pd(x + i)));
+    }
+    convertScalar(y + i, x + i, n - i);
+}
+
+#endif
+
+/**
+ * @brief Runtime dispatch
+ */
+
+static Kernels::ISA detectISA()
+{
+#ifdef KERNELS_X86_
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Kernels::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return Kernels::AVX2;
+#endif
+    return Kernels::Scalar;
+}
+
+static Kernels::ISA currentISA = detectISA();
+
+Kernels::ISA Kernels::isa() { return currentISA; }
+
+Kernels::ISA Kernels::supportedISA()
+{
+    static const ISA supported = detectISA();
+    return supported;
+}
+
+void Kernels::setISA(ISA isa)
+{
+    currentISA = isa < supportedISA() ? isa : supportedISA();
+}
+
+const char* Kernels::isaName()
+{
+    switch (currentISA) {
+        case AVX512:
+            return "AVX-512";
+        case AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+#ifdef KERNELS_X86_
+#define DISPATCH(name, ...)                                           \
+    switch (currentISA) {                                             \
+        case AVX512:                                                  \
+            return name##AVX512(__VA_ARGS__);                         \
+        case AVX2:                                                    \
+            return name##AVX2(__VA_ARGS__);                           \
+        default:                                                      \
+            return name##Scalar(__VA_ARGS__);                         \
+    }
+#else
+#define DISPATCH(name, ...) return name##Scalar(__VA_ARGS__);
+#endif
+
+double Kernels::dot(const double* x, const double* y, int n)
+{
+    DISPATCH(dot, x, y, n);
+}
+
+float Kernels::dot(const float* x, const float* y, int n)
+{
+    DISPATCH(dot, x, y, n);
+}
+
+double Kernels::update(double* w, const double* v1, const double* v0,
+                       double alpha, double beta, int n)
+{
+    DISPATCH(update, w, v1, v0, alpha, beta, n);
+}
+
+float Kernels::update(float* w, const float* v1, const float* v0, float alpha,
+                      float beta, int n)
+{
+    DISPATCH(update, w, v1, v0, alpha, beta, n);
+}
+
+void Kernels::axpy(double* y, const double* x, double a, int n)
+{
+    DISPATCH(axpy, y, x, a, n);
+}
+
+void Kernels::axpy(float* y, const float* x, float a, int n)
+{
+    DISPATCH(axpy, y, x, a, n);
+}
+
+void Kernels::scale(double* y, const double* x, double a, int n)
+{
+    DISPATCH(scale, y, x, a, n);
+}
+
+void Kernels::scale(float* y, const float* x, float a, int n)
+{
+    DISPATCH(scale, y, x, a, n);
+}
+
+double Kernels::dot(const float* x, const double* y, int n)
+{
+    DISPATCH(dot, x, y, n);
+}
+
+void Kernels::axpy(double* y, const float* x, double a, int n)
+{
+    DISPATCH(axpy, y, x, a, n);
+}
+
+void Kernels::convert(float* y, const double* x, int n)
+{
+    DISPATCH(convert, y, x, n);
+}
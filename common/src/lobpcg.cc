@@ -0,0 +1,301 @@
+/**
+ * @file lobpcg.cc
+ * @brief LOBPCG eigensolver
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef LOBPCG_CC_
+#define LOBPCG_CC_
+
+#include "lobpcg.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include "kernels.h"
+#include "solver_log.h"
+#include "tqli.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+template <typename Vector, typename T, typename Index>
+typename Lobpcg<Vector, T, Index>::Preconditioner
+Lobpcg<Vector, T, Index>::preconditioner(const std::string& name)
+{
+    if (name == "none") {
+        return None;
+    } else if (name == "jacobi") {
+        return Jacobi;
+    } else if (name == "smoother") {
+        return Smoother;
+    }
+    throw std::invalid_argument("Unknown preconditioner: " + name);
+}
+
+/**
+ * @brief Find the smallest eigenpairs of the Laplacian matrix orthogonal to
+ *        the constant vector, each iteration does Rayleigh-Ritz on
+ *        span{X, W, P}
+ * @param g The (local) graph
+ * @param num_of_eigenvec Number of eigenpairs k
+ * @param preconditioner Jacobi divides the residuals by the degrees, Smoother
+ *        adds two damped Jacobi sweeps on L w = r (the smoother of a
+ *        multigrid cycle without the coarse levels)
+ * @param max_iter Maximum number of iterations
+ * @param tol Converged if ||L x - lambda x|| <= tol * max(1, lambda) for all
+ *        the eigenpairs
+ * @param start Eigenvectors of a previous run to start X from, the rest of
+ *        X is random
+ */
+template <typename Vector, typename T, typename Index>
+Lobpcg<Vector, T, Index>::Lobpcg(const BasicGraph<Index>& g,
+                                 const int& num_of_eigenvec,
+                                 Preconditioner preconditioner,
+                                 const int& max_iter, const T& tol,
+                                 const std::vector<Vector>& start)
+    : iterations(0),
+      converged(false),
+      laplacian(g),
+      preconditioner_(preconditioner)
+{
+#ifdef VT_
+    VT_TRACER("Lobpcg::Lobpcg");
+#endif
+    const Index size = laplacian.size();
+    const int k = std::max<Index>(
+        1, std::min<Index>(num_of_eigenvec, laplacian.globalSize() - 1));
+    inverse_diagonal = laplacian.diagonal();
+    for (auto& d : inverse_diagonal) {
+        d = d > 0 ? 1.0 / d : 1.0;
+    }
+
+    std::default_random_engine generator(1 + laplacian.rank());
+    std::uniform_real_distribution<double> gen(-1.0, 1.0);
+    Block x(k, Vector(size)), ax, p, s;
+    for (int c = 0; c < k; c++) {
+        if (c < (int)start.size()) {
+            x[c] = start[c];
+        } else {
+            for (auto& entry : x[c]) {
+                entry = gen(generator);
+            }
+        }
+        deflate(x[c]);
+    }
+    orthonormalise(x);
+    s = x;
+
+    std::vector<std::vector<double>> gram, ritz_vecs;
+    std::vector<double> ritz_values;
+    for (;; iterations++) {
+        // Rayleigh-Ritz on the orthonormal basis s = [X, W, P]
+        Block as = multiply(s);
+        const int m = s.size();
+        std::vector<T> gram_local(m * m);
+        for (int i = 0; i < m; i++) {
+            for (int j = i; j < m; j++) {
+                gram_local[i * m + j] = VectorOps<Vector, T>::dot(s[i], as[j]);
+            }
+        }
+        laplacian.reduce(gram_local);
+        gram.assign(m, std::vector<double>(m));
+        for (int i = 0; i < m; i++) {
+            for (int j = i; j < m; j++) {
+                gram[i][j] = gram[j][i] = gram_local[i * m + j];
+            }
+        }
+        symmetricEigen(gram, ritz_values, ritz_vecs);
+        std::vector<int> order(m);
+        for (int i = 0; i < m; i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return ritz_values[a] < ritz_values[b];
+        });
+        order.resize(std::min(k, m));
+
+        const int num_x = x.size();
+        x = combine(s, ritz_vecs, order, 0);
+        ax = combine(as, ritz_vecs, order, 0);
+        p = m > num_x ? combine(s, ritz_vecs, order, num_x) : Block();
+        eigenvalues.clear();
+        for (const int& i : order) {
+            eigenvalues.push_back(ritz_values[i]);
+        }
+
+        // Residuals R = L X - X Lambda
+        Block r = ax;
+        std::vector<T> norms(r.size());
+        for (unsigned int i = 0; i < r.size(); i++) {
+            VectorOps<Vector, T>::axpy(r[i], x[i], -eigenvalues[i]);
+            norms[i] = VectorOps<Vector, T>::dot(r[i], r[i]);
+        }
+        laplacian.reduce(norms);
+        converged = true;
+        for (unsigned int i = 0; i < r.size(); i++) {
+            if (std::sqrt(norms[i]) >
+                tol * std::max<T>(1.0, std::abs(eigenvalues[i]))) {
+                converged = false;
+            }
+        }
+        if (converged || iterations == max_iter) {
+            break;
+        }
+
+        Block w = precondition(r);
+        for (auto& v : w) {
+            deflate(v);
+        }
+        s = x;
+        s.insert(s.end(), w.begin(), w.end());
+        s.insert(s.end(), p.begin(), p.end());
+        orthonormalise(s);
+    }
+    eigenvectors = x;
+    if (laplacian.rank() == 0) {
+        SolverLog::out() << "LOBPCG is done, number of iterations = "
+                         << iterations << (converged ? "" : " (not converged)")
+                         << std::endl;
+    }
+}
+
+template <typename Vector, typename T, typename Index>
+T Lobpcg<Vector, T, Index>::dot(const Vector& x, const Vector& y)
+{
+    std::vector<T> sum(1, VectorOps<Vector, T>::dot(x, y));
+    laplacian.reduce(sum);
+    return sum[0];
+}
+
+/**
+ * @brief Project out the constant vector, the eigenvector of eigenvalue 0
+ * @param x Local part of the vector
+ */
+template <typename Vector, typename T, typename Index>
+void Lobpcg<Vector, T, Index>::deflate(Vector& x)
+{
+    std::vector<T> sum(1, 0.0);
+    for (const auto& entry : x) {
+        sum[0] += entry;
+    }
+    laplacian.reduce(sum);
+    T mean = sum[0] / laplacian.globalSize();
+    for (auto& entry : x) {
+        entry -= mean;
+    }
+}
+
+/**
+ * @brief Gram-Schmidt applied twice to each vector in order, the vectors
+ *        (nearly) dependent on the previous ones are dropped
+ * @param s The vectors, returns the orthonormal basis of their span
+ */
+template <typename Vector, typename T, typename Index>
+void Lobpcg<Vector, T, Index>::orthonormalise(Block& s)
+{
+    Block q;
+    q.reserve(s.size());
+    for (auto& v : s) {
+        T before = std::sqrt(dot(v, v));
+        for (int pass = 0; pass < 2; pass++) {
+            std::vector<T> d(q.size());
+            for (unsigned int i = 0; i < q.size(); i++) {
+                d[i] = VectorOps<Vector, T>::dot(q[i], v);
+            }
+            laplacian.reduce(d);
+            for (unsigned int i = 0; i < q.size(); i++) {
+                VectorOps<Vector, T>::axpy(v, q[i], -d[i]);
+            }
+        }
+        T after = std::sqrt(dot(v, v));
+        if (after > 1e-8 * before) {
+            VectorOps<Vector, T>::scale(v, v, 1.0 / after);
+            q.push_back(std::move(v));
+        }
+    }
+    s.swap(q);
+}
+
+/**
+ * @brief L * s with all the vectors in one pass over the graph
+ */
+template <typename Vector, typename T, typename Index>
+typename Lobpcg<Vector, T, Index>::Block Lobpcg<Vector, T, Index>::multiply(
+    const Block& s)
+{
+    const int width = s.size();
+    const Index size = laplacian.size();
+    Vector x(size * width), y;
+    for (int c = 0; c < width; c++) {
+        for (Index i = 0; i < size; i++) {
+            x[i * width + c] = s[c][i];
+        }
+    }
+    laplacian.multiply(x, y, width);
+    Block as(width, Vector(size));
+    for (int c = 0; c < width; c++) {
+        for (Index i = 0; i < size; i++) {
+            as[c][i] = y[i * width + c];
+        }
+    }
+    return as;
+}
+
+template <typename Vector, typename T, typename Index>
+typename Lobpcg<Vector, T, Index>::Block Lobpcg<Vector, T, Index>::precondition(
+    const Block& r)
+{
+    const T omega = 2.0 / 3.0;
+    Block w = r;
+    if (preconditioner_ == None) {
+        return w;
+    }
+    for (auto& v : w) {
+        for (unsigned int i = 0; i < v.size(); i++) {
+            v[i] *= inverse_diagonal[i];
+        }
+    }
+    if (preconditioner_ == Smoother) {
+        for (auto& v : w) {
+            VectorOps<Vector, T>::scale(v, v, omega);
+        }
+        for (int sweep = 0; sweep < 2; sweep++) {
+            // w = w + omega * D^-1 (r - L w)
+            Block lw = multiply(w);
+            for (unsigned int c = 0; c < w.size(); c++) {
+                for (unsigned int i = 0; i < w[c].size(); i++) {
+                    w[c][i] +=
+                        omega * inverse_diagonal[i] * (r[c][i] - lw[c][i]);
+                }
+            }
+        }
+    }
+    return w;
+}
+
+/**
+ * @brief Linear combinations of the vectors
+ * @param s The vectors
+ * @param c The coefficients, c[row][column]
+ * @param columns The columns of c to use
+ * @param first Only use s[first..] and the rows first.. of c
+ * @return sum_r s[r] * c[r][column] for each column
+ */
+template <typename Vector, typename T, typename Index>
+typename Lobpcg<Vector, T, Index>::Block Lobpcg<Vector, T, Index>::combine(
+    const Block& s, const std::vector<std::vector<double>>& c,
+    const std::vector<int>& columns, const int& first)
+{
+    Block result(columns.size(), Vector(laplacian.size(), 0.0));
+    for (unsigned int j = 0; j < columns.size(); j++) {
+        for (unsigned int r = first; r < s.size(); r++) {
+            VectorOps<Vector, T>::axpy(result[j], s[r], c[r][columns[j]]);
+        }
+    }
+    return result;
+}
+
+#endif
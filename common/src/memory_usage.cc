@@ -0,0 +1,160 @@
+/**
+ * @file memory_usage.cc
+ * @brief Size accounting of the large structures and the peak resident set
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "memory_usage.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+static MemoryUsage::Entries registry;
+static mutex registry_mutex;  // Components are partitioned on threads
+
+void MemoryUsage::record(const string& name, const size_t& bytes)
+{
+    lock_guard<mutex> lock(registry_mutex);
+    size_t& peak = registry[name];
+    peak = max(peak, bytes);
+}
+
+const MemoryUsage::Entries& MemoryUsage::entries() { return registry; }
+
+void MemoryUsage::reset() { registry.clear(); }
+
+size_t MemoryUsage::peakRss()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (size_t)usage.ru_maxrss * 1024;  // Kilobytes on Linux
+}
+
+/**
+ * @brief The chunk glibc malloc takes for a request, the size word added
+ *        and rounded up to 16 bytes, at least 32
+ */
+size_t MemoryUsage::allocation(const size_t& bytes)
+{
+    return max<size_t>(32, (bytes + sizeof(size_t) + 15) / 16 * 16);
+}
+
+/**
+ * @brief The bucket array of an unordered container of size elements at
+ *        most, libstdc++ starts with 13 buckets and at least doubles them
+ *        when the size passes the count, so max(13, 2 size + 1) bounds it
+ */
+static size_t buckets(const size_t& size)
+{
+    return max<size_t>(13, 2 * size + 1);
+}
+
+/**
+ * @brief Every process is taken to hold the even share of the vertices and
+ *        of the edges, both directions of an edge are stored. The buckets
+ *        are the bound of the growth, 13 + 2 degree per set of neighbours
+ *        sums to 13 n + 2 entries whatever the degrees. The Lanczos
+ *        vectors (rows padded to 64 bytes), the tridiagonal eigenvectors z
+ *        (m x m) and the eigenvectors of the colouring are the ones of
+ *        Partition with the default options.
+ */
+MemoryUsage::Entries MemoryUsage::estimate(const int64_t& vertices,
+                                           const int64_t& edges, const int& m,
+                                           const int& eigenvectors,
+                                           const int& processes,
+                                           const size_t& basisBytes,
+                                           bool distributed)
+{
+    const size_t n = (vertices + processes - 1) / processes;
+    const size_t entries = (2 * edges + processes - 1) / processes;
+    typedef pair<void*, pair<int, unordered_set<int>>> VertexNode;
+    typedef pair<void*, int> NeighbourNode;
+
+    Entries estimated;
+    estimated["graph/adjacency"] =
+        buckets(n) * sizeof(void*) + n * allocation(sizeof(VertexNode)) +
+        (13 * n + 2 * entries) * sizeof(void*) +
+        entries * allocation(sizeof(NeighbourNode));
+    if (distributed) {
+        estimated["graph/index"] = n * sizeof(int);
+        estimated["graph/local_index"] = vertices * sizeof(int);
+        estimated["graph/rank_map"] = vertices * sizeof(int);
+        estimated["laplacian/v_halo"] = vertices * sizeof(double);
+    }
+    estimated["lanczos/basis"] = m * ((n * basisBytes + 63) / 64 * 64);
+    estimated["tqli/z"] =
+        (size_t)m * (m * sizeof(double) + sizeof(vector<double>));
+    estimated["partition/eigenvectors"] =
+        eigenvectors * (n * sizeof(double) + sizeof(vector<double>));
+    return estimated;
+}
+
+/**
+ * @brief A process without an entry counts as 0, no resident set is given
+ *        for an estimate of one process
+ */
+void MemoryUsage::report(ostream& out, const vector<Entries>& processes,
+                         const vector<size_t>& rss)
+{
+    const double MB = 1024.0 * 1024.0;
+    set<string> names;
+    for (const auto& entries : processes) {
+        for (const auto& it : entries) {
+            names.insert(it.first);
+        }
+    }
+    auto row = [&](const string& name, const vector<size_t>& bytes) {
+        size_t total = 0;
+        for (const size_t& b : bytes) {
+            total += b;
+        }
+        out << left << setw(26) << name << right << setw(12)
+            << *min_element(bytes.begin(), bytes.end()) / MB << setw(12)
+            << *max_element(bytes.begin(), bytes.end()) / MB << setw(12)
+            << total / MB / bytes.size() << endl;
+    };
+
+    out << fixed << setprecision(3);
+    out << "/*----------------------------------------------------------------"
+           "-------------"
+        << endl;
+    if (rss.empty()) {
+        out << " * Estimated memory of the largest structures (MB) per "
+               "process"
+            << endl;
+    } else {
+        out << " * Memory of the largest structures (MB) over "
+            << processes.size() << " processes" << endl;
+    }
+    out << "/*----------------------------------------------------------------"
+           "-------------"
+        << endl;
+    out << left << setw(26) << "" << right << setw(12) << "min" << setw(12)
+        << "max" << setw(12) << "avg" << endl;
+    vector<size_t> totals(processes.size(), 0);
+    for (const string& name : names) {
+        vector<size_t> bytes;
+        for (size_t p = 0; p < processes.size(); p++) {
+            auto it = processes[p].find(name);
+            bytes.push_back(it == processes[p].end() ? 0 : it->second);
+            totals[p] += bytes.back();
+        }
+        row(name, bytes);
+    }
+    row("total", totals);
+    if (!rss.empty()) {
+        row("rss high-water mark", rss);
+        out << "rss high-water mark of each rank:";
+        for (const size_t& bytes : rss) {
+            out << " " << bytes / MB;
+        }
+        out << endl;
+    }
+    out << defaultfloat << setprecision(6);
+}
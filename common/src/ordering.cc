@@ -0,0 +1,147 @@
+/**
+ * @file ordering.cc
+ * @brief Vertex orderings to improve the locality of the graph
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "ordering.h"
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+
+using namespace std;
+
+template <typename Index>
+using Adjacency = std::vector<std::vector<Index>>;
+
+/**
+ * @brief Visit the vertices component by component in breadth first order.
+ * @param adjacency adjacency[vertex] contains the neighbours of the vertex
+ * @param byDegree Start from the vertex with minimum degree in each component
+ *        and visit the neighbours in increasing order of degree (Cuthill-McKee)
+ * @return order[new_index] = old_index
+ */
+template <typename Index>
+static vector<Index> breadthFirst(const Adjacency<Index>& adjacency,
+                                  bool byDegree)
+{
+    Index size = adjacency.size();
+    vector<Index> order, starts(size);
+    vector<bool> visited(size, false);
+    order.reserve(size);
+
+    for (Index vertex = 0; vertex < size; vertex++) {
+        starts[vertex] = vertex;
+    }
+    auto lessDegree = [&adjacency](const Index& a, const Index& b) {
+        return adjacency[a].size() < adjacency[b].size();
+    };
+    if (byDegree) {
+        stable_sort(starts.begin(), starts.end(), lessDegree);
+    }
+
+    vector<Index> neighbours;
+    for (const Index& start : starts) {
+        if (visited[start]) continue;
+        queue<Index> frontier;
+        frontier.push(start);
+        visited[start] = true;
+        while (!frontier.empty()) {
+            Index vertex = frontier.front();
+            frontier.pop();
+            order.push_back(vertex);
+            neighbours.clear();
+            for (const Index& neighbour : adjacency[vertex]) {
+                if (!visited[neighbour]) {
+                    visited[neighbour] = true;
+                    neighbours.push_back(neighbour);
+                }
+            }
+            if (byDegree) {
+                stable_sort(neighbours.begin(), neighbours.end(), lessDegree);
+            } else {
+                sort(neighbours.begin(), neighbours.end());
+            }
+            for (const Index& neighbour : neighbours) {
+                frontier.push(neighbour);
+            }
+        }
+    }
+    return order;
+}
+
+/**
+ * @brief Reverse Cuthill-McKee, reduce the bandwidth of the Laplacian matrix
+ * @param adjacency adjacency[vertex] contains the neighbours of the vertex
+ * @return order[new_index] = old_index
+ */
+template <typename Index>
+vector<Index> reverseCuthillMcKee(const Adjacency<Index>& adjacency)
+{
+    vector<Index> order = breadthFirst(adjacency, true);
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+/**
+ * @brief Breadth first search from vertex 0, neighbours get close indices
+ * @param adjacency adjacency[vertex] contains the neighbours of the vertex
+ * @return order[new_index] = old_index
+ */
+template <typename Index>
+vector<Index> breadthFirstOrdering(const Adjacency<Index>& adjacency)
+{
+    return breadthFirst(adjacency, false);
+}
+
+/**
+ * @brief Sort the vertices by decreasing degree, such that the vertices with
+ *        similar degree are stored in blocks and the hubs stay in cache
+ * @param adjacency adjacency[vertex] contains the neighbours of the vertex
+ * @return order[new_index] = old_index
+ */
+template <typename Index>
+vector<Index> degreeOrdering(const Adjacency<Index>& adjacency)
+{
+    Index size = adjacency.size();
+    vector<Index> order(size);
+    for (Index vertex = 0; vertex < size; vertex++) {
+        order[vertex] = vertex;
+    }
+    stable_sort(order.begin(), order.end(),
+                [&adjacency](const Index& a, const Index& b) {
+                    return adjacency[a].size() > adjacency[b].size();
+                });
+    return order;
+}
+
+/**
+ * @brief Select the ordering by name
+ * @param method "rcm", "bfs" or "degree"
+ * @param adjacency adjacency[vertex] contains the neighbours of the vertex
+ * @return order[new_index] = old_index
+ */
+template <typename Index>
+vector<Index> vertexOrdering(const string& method,
+                             const Adjacency<Index>& adjacency)
+{
+    if (method == "rcm") {
+        return reverseCuthillMcKee(adjacency);
+    } else if (method == "bfs") {
+        return breadthFirstOrdering(adjacency);
+    } else if (method == "degree") {
+        return degreeOrdering(adjacency);
+    }
+    throw std::invalid_argument("Unknown vertex ordering: " + method);
+}
+
+template vector<int32_t> reverseCuthillMcKee(const Adjacency<int32_t>&);
+template vector<int64_t> reverseCuthillMcKee(const Adjacency<int64_t>&);
+template vector<int32_t> breadthFirstOrdering(const Adjacency<int32_t>&);
+template vector<int64_t> breadthFirstOrdering(const Adjacency<int64_t>&);
+template vector<int32_t> degreeOrdering(const Adjacency<int32_t>&);
+template vector<int64_t> degreeOrdering(const Adjacency<int64_t>&);
+template vector<int32_t> vertexOrdering(const string&,
+                                        const Adjacency<int32_t>&);
+template vector<int64_t> vertexOrdering(const string&,
+                                        const Adjacency<int64_t>&);
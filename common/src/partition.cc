@@ -5,14 +5,27 @@
  */
 
 #include "partition.h"
+#include "kernels.h"
 #include "lanczos.h"
+#include "lobpcg.h"
+#include "memory_usage.h"
+#include "random_stream.h"
+#include "solver_log.h"
+#include "timers.h"
 #include "tqli.h"
 
 #include <algorithm>
-#include <boost/timer.hpp>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -33,33 +46,310 @@ using DenseMatrix = std::vector<std::vector<double>>;
  * @param numOfSubGraphs The number of subgraphs to partition to
  * @param enableGramSchmidt Enable GramSchmidt
  */
-Partition::Partition(const Graph& g, const int& numOfSubGraphs, bool enableGramSchmidt)
+template <typename Index>
+Partition::Partition(const BasicGraph<Index>& g, const int& numOfSubGraphs,
+                     bool enableGramSchmidt)
+    : Partition(g, numOfSubGraphs, PartitionOptions(enableGramSchmidt))
+{
+}
+
+/**
+ * @brief Partition the graph with the given options of the eigensolver
+ * @param g The graph to partition
+ * @param numOfSubGraphs The number of subgraphs to partition to
+ * @param options Options of the eigensolver
+ */
+template <typename Index>
+Partition::Partition(const BasicGraph<Index>& g, const int& numOfSubGraphs,
+                     const PartitionOptions& options)
 {
 #ifdef VT_
     VT_TRACER("Partition::Partition");
 #endif
-    boost::timer timer_partition;
+    Timers::Scope timer_partition("partition");
+    for (const auto& v : options.startVectors) {
+        if ((Index)v.size() != g.size()) {
+            throw invalid_argument("The start vectors do not match the graph");
+        }
+    }
+    g.recordMemory();
+    if (options.minComponentSize > 0) {
+        partitionByComponents(g, numOfSubGraphs, options);
+    } else {
+        partitionConnected(g, numOfSubGraphs, options);
+    }
+    MemoryUsage::record("partition/eigenvectors",
+                        MemoryUsage::bytes(laplacianEigenMatrix_));
+
+    double t_par = timer_partition.stop();
+    times.push_back(t_par);
+}
+
+/**
+ * @brief Partition each connected component that has at least
+ *        minComponentSize vertices on its own, the largest one always. The
+ *        components are independent, they are partitioned concurrently on
+ *        BasicGraph::solverThreads() threads, or in turn on the calling thread
+ *        when each spans the processes. The smaller components are not
+ *        split, each is given to the colour with the fewest vertices so far,
+ *        largest component first. The eigenvectors of the components are
+ *        put together, 0 on the small ones.
+ * @param g The graph to partition
+ * @param numOfSubGraphs The number of subgraphs to partition to
+ * @param options Options of the eigensolver
+ */
+template <typename Index>
+void Partition::partitionByComponents(const BasicGraph<Index>& g,
+                                      const int& numOfSubGraphs,
+                                      const PartitionOptions& options)
+{
+    Timers::Scope timer("components");
+    std::vector<Index> component = g.components();
+    std::map<Index, Index> sizes = g.globalCounts(component);
+    timer.stop();
+    PartitionOptions connected = options;
+    connected.minComponentSize = 0;
+    if (sizes.size() <= 1) {
+        partitionConnected(g, numOfSubGraphs, connected);
+        return;
+    }
+
+    // Local vertices of each, none on a process for some of them
+    std::map<Index, std::vector<Index>> members;
+    for (const auto& it : sizes) {
+        members[it.first];
+    }
+    for (Index vertex = 0; vertex < g.size(); vertex++) {
+        members[component[vertex]].push_back(vertex);
+    }
+    Index largest = sizes.begin()->first;
+    for (const auto& it : sizes) {
+        if (it.second > sizes[largest]) {
+            largest = it.first;
+        }
+    }
+
+    // Every process goes through the components in the same order
+    std::vector<std::pair<Index, Index>> tiny;  // <size, label>
+    std::vector<Index> large;
+    for (const auto& it : sizes) {
+        if (it.second < options.minComponentSize && it.first != largest) {
+            tiny.push_back({it.second, it.first});
+        } else {
+            large.push_back(it.first);
+        }
+    }
+    std::vector<Partition> parts(large.size());
+    std::vector<std::vector<int>> partColours(large.size());
+    auto solve = [&](int c) {
+        const std::vector<Index>& vertices = members.at(large[c]);
+        BasicGraph<Index> sub = g.subgraph(vertices);
+        PartitionOptions own = connected;
+        own.startVectors.assign(options.startVectors.size(),
+                                std::vector<double>());
+        for (unsigned int r = 0; r < options.startVectors.size(); r++) {
+            for (const Index& vertex : vertices) {
+                own.startVectors[r].push_back(options.startVectors[r][vertex]);
+            }
+        }
+        parts[c] = Partition(sub, numOfSubGraphs, own);
+        for (Index subVertex = 0; subVertex < sub.size(); subVertex++) {
+            partColours[c].push_back(sub.getColour(sub.globalIndex(subVertex)));
+        }
+    };
+
+    const int threads =
+        std::min<int>(BasicGraph<Index>::solverThreads(), large.size());
+    if (threads == 0) {
+        for (unsigned int c = 0; c < large.size(); c++) {
+            solve(c);
+        }
+    } else {
+        // The seeds are drawn in turn, a run is reproduced whichever thread
+        // partitions a component
+        std::vector<long> seeds(large.size());
+        for (long& seed : seeds) {
+            seed = lrand48();
+        }
+        std::atomic<int> next(0);
+        std::vector<std::ostringstream> logs(large.size());
+        std::vector<Timers::Entries> timers(threads);
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++) {
+            pool.emplace_back([&, t]() {
+                try {
+                    for (int c = next++; c < (int)large.size(); c = next++) {
+                        RandomStream::seedThread(seeds[c]);
+                        SolverLog::redirect(&logs[c]);
+                        solve(c);
+                    }
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+                timers[t] = Timers::entries();
+            });
+        }
+        for (auto& worker : pool) {
+            worker.join();
+        }
+        for (const auto& report : logs) {
+            std::cout << report.str();  // In the order of the components
+        }
+        for (int t = 0; t < threads; t++) {
+            Timers::merge(timers[t]);
+            if (errors[t]) {
+                std::rethrow_exception(errors[t]);
+            }
+        }
+    }
+
+    times.assign(2, 0.0);
+    laplacianEigenMatrix_.assign(log2(numOfSubGraphs),
+                                 std::vector<double>(g.size(), 0.0));
+    for (unsigned int c = 0; c < large.size(); c++) {
+        const std::vector<Index>& vertices = members[large[c]];
+        const Partition& part = parts[c];
+        for (unsigned int i = 0; i < vertices.size(); i++) {
+            Index vertex = vertices[i];
+            g.setColour(g.globalIndex(vertex), partColours[c][i]);
+            for (unsigned int r = 0; r < part.laplacianEigenMatrix_.size() &&
+                                     r < laplacianEigenMatrix_.size();
+                 r++) {
+                laplacianEigenMatrix_[r][vertices[i]] =
+                    part.laplacianEigenMatrix_[r][i];
+            }
+        }
+        times[0] += part.times[0];
+        times[1] += part.times[1];
+        if (large[c] == largest) {
+            ritzValues = part.ritzValues;
+            laplacianEigenvalues_ = part.laplacianEigenvalues_;
+        }
+    }
+
+    std::vector<Index> colours;
+    for (Index vertex = 0; vertex < g.size(); vertex++) {
+        if (sizes[component[vertex]] >= options.minComponentSize ||
+            component[vertex] == largest) {
+            colours.push_back(g.getColour(g.globalIndex(vertex)));
+        }
+    }
+    std::map<Index, Index> colourSizes = g.globalCounts(colours);
+    for (int colour = 0; colour < numOfSubGraphs; colour++) {
+        colourSizes[colour] += 0;
+    }
+    sort(tiny.begin(), tiny.end(), greater<std::pair<Index, Index>>());
+    for (const auto& it : tiny) {
+        auto smallest = colourSizes.begin();
+        for (auto c = colourSizes.begin(); c != colourSizes.end(); ++c) {
+            if (c->second < smallest->second) {
+                smallest = c;
+            }
+        }
+        smallest->second += it.first;
+        for (const Index& vertex : members[it.second]) {
+            g.setColour(g.globalIndex(vertex), smallest->first);
+        }
+    }
+}
+
+/**
+ * @brief Partition a connected graph by the eigenvectors of its Laplacian
+ * @param g The graph to partition
+ * @param numOfSubGraphs The number of subgraphs to partition to
+ * @param options Options of the eigensolver
+ */
+template <typename Index>
+void Partition::partitionConnected(const BasicGraph<Index>& g,
+                                   const int& numOfSubGraphs,
+                                   const PartitionOptions& options)
+{
     int numOfEigenvectors = log2(numOfSubGraphs);
 
+    if (options.eigensolver == "lobpcg") {
+        if (options.laplacian != "combinatorial") {
+            throw invalid_argument("LOBPCG only uses the combinatorial "
+                                   "Laplacian");
+        }
+        partitionByLobpcg(g, numOfEigenvectors, options);
+    } else if (options.eigensolver != "lanczos") {
+        throw invalid_argument("Unknown eigensolver: " + options.eigensolver);
+    } else if (options.laplacian == "combinatorial") {
+        partitionByLanczos<Combinatorial>(g, numOfEigenvectors, options);
+    } else if (options.laplacian == "normalised") {
+        partitionByLanczos<SymmetricNormalised>(g, numOfEigenvectors, options);
+    } else if (options.laplacian == "random-walk") {
+        partitionByLanczos<RandomWalk>(g, numOfEigenvectors, options);
+    } else {
+        throw invalid_argument("Unknown Laplacian: " + options.laplacian);
+    }
+    colour(g, numOfEigenvectors);
+}
+
+/**
+ * @brief Lanczos on the Laplacian of the Operator policy, the Lanczos
+ *        vectors are stored in float with mixed precision
+ * @param g The graph to partition
+ * @param numOfEigenvectors The number of eigenvectors to calculate
+ * @param options Options of the eigensolver
+ */
+template <typename Operator, typename Index>
+void Partition::partitionByLanczos(const BasicGraph<Index>& g,
+                                   const int& numOfEigenvectors,
+                                   const PartitionOptions& options)
+{
+    if (options.mixedPrecision) {
+        lanczosEigenvectors<std::vector<float>, Operator>(g, numOfEigenvectors,
+                                                          options);
+    } else {
+        lanczosEigenvectors<std::vector<double>, Operator>(
+            g, numOfEigenvectors, options);
+    }
+}
+
+/**
+ * @brief Lanczos with the Lanczos vectors stored in Basis, the recurrence is
+ *        always done in double
+ * @param g The graph to partition
+ * @param numOfEigenvectors The number of eigenvectors to calculate
+ * @param options Options of the eigensolver
+ */
+template <typename Basis, typename Operator, typename Index>
+void Partition::lanczosEigenvectors(const BasicGraph<Index>& g,
+                                    const int& numOfEigenvectors,
+                                    const PartitionOptions& options)
+{
     // Construct tridiagonal matrix using Lanczos algorithm
-    boost::timer lanczosTimer;
-    Lanczos<std::vector<double>, double> lanczos(g, numOfEigenvectors, enableGramSchmidt);
-    double t_lan = lanczosTimer.elapsed();
+    Timers::Scope lanczosTimer("lanczos");
+    Lanczos<std::vector<double>, double, Basis, Operator, Index> lanczos(
+        g, numOfEigenvectors, options.gramSchmidt, options.spillDirectory,
+        options.blockSize, options.chebyshevDegree, options.startVectors);
+    double t_lan = lanczosTimer.stop();
     times.push_back(t_lan);
-    laplacianEigenvalues_ = lanczos.alpha;
-    std::vector<double> beta = lanczos.beta;
 
     // Define an identity matrix as the input for TQLI algorithm
     DenseMatrix tridiagonalEigenvectors;
 
     // Calculate the eigenvalues and eigenvectors of the tridiagonal matrix
-    boost::timer tqliTimer;
-    tqli(laplacianEigenvalues_, beta, tridiagonalEigenvectors);
-    double t_tqli = tqliTimer.elapsed();
+    Timers::Scope tqliTimer("tqli");
+    if (lanczos.block_size > 1) {
+        symmetricEigen(lanczos.block_tri, laplacianEigenvalues_,
+                       tridiagonalEigenvectors);
+    } else {
+        laplacianEigenvalues_ = lanczos.alpha;
+        std::vector<double> beta = lanczos.beta;
+        tqli(laplacianEigenvalues_, beta, tridiagonalEigenvectors);
+    }
+    double t_tqli = tqliTimer.stop();
     times.push_back(t_tqli);
+    MemoryUsage::record("tqli/z", MemoryUsage::bytes(tridiagonalEigenvectors));
 
     // Find the index of the nth smallest eigenvalue (fiedler vector) of the
-    // eigenvalues vector "alpha"
+    // eigenvalues vector "alpha". The zero eigenvalue of the constant vector
+    // is deflated, only the ones of other connected components are skipped,
+    // zero up to the rounding of the tridiagonal solve. The Fiedler value of
+    // a large sparse graph is small, any fixed cutoff above that skips it.
     int vectorIndex = 0;
 
     int m = laplacianEigenvalues_.size();
@@ -69,12 +359,14 @@ Partition::Partition(const Graph& g, const int& numOfSubGraphs, bool enableGramS
     }
     std::vector<double> auxiliaryVector = laplacianEigenvalues_;
     sort(auxiliaryVector.begin(), auxiliaryVector.end());
+    const double zero = numeric_limits<double>::epsilon() * m *
+                        max(abs(auxiliaryVector.front()),
+                            abs(auxiliaryVector.back()));
 
-#ifndef Median_
-    int fielderIndex = 1;
+    int fielderIndex = 0;
     for (int i = 0; i < numOfEigenvectors; i++) {
         auto it = hashmap.find(auxiliaryVector[fielderIndex]);
-        while (abs(it->first) < 1e-2) {
+        while (abs(it->first) < zero && fielderIndex + 1 < m) {
             fielderIndex++;
             it = hashmap.find(auxiliaryVector[fielderIndex]);
         }
@@ -85,8 +377,52 @@ Partition::Partition(const Graph& g, const int& numOfSubGraphs, bool enableGramS
         laplacianEigenMatrix_.push_back(getOneLapEigenVec(
             lanczos.lanczos_vecs, tridiagonalEigenvectors, vectorIndex));
     }
+    if (Operator::randomWalk) {
+        Laplacian<std::vector<double>, double, Operator, Index> laplacian(g);
+        for (auto& eigenvector : laplacianEigenMatrix_) {
+            laplacian.toEigenvector(eigenvector);
+        }
+    }
+}
+
+/**
+ * @brief LOBPCG finds the eigenvectors directly, there is no tridiagonal
+ *        matrix to solve, its time is recorded as 0
+ * @param g The graph to partition
+ * @param numOfEigenvectors The number of eigenvectors to calculate
+ * @param options Options of the eigensolver
+ */
+template <typename Index>
+void Partition::partitionByLobpcg(const BasicGraph<Index>& g,
+                                  const int& numOfEigenvectors,
+                                  const PartitionOptions& options)
+{
+    typedef Lobpcg<std::vector<double>, double, Index> Solver;
+    typename Solver::Preconditioner preconditioner =
+        Solver::preconditioner(options.preconditioner);
+    Timers::Scope lobpcgTimer("lobpcg");
+    Solver lobpcg(g, numOfEigenvectors, preconditioner, 500, 1e-6,
+                  options.startVectors);
+    times.push_back(lobpcgTimer.stop());
+    times.push_back(0.0);
+
+    laplacianEigenvalues_ = lobpcg.eigenvalues;
+    ritzValues = lobpcg.eigenvalues;
+    laplacianEigenMatrix_ = lobpcg.eigenvectors;
+}
 
-    for (int vertex = 0; vertex < g.size(); vertex++) {
+/**
+ * @brief Colour each vertex by the signs of its entries in the eigenvectors
+ *        (or whether they are above the median of each eigenvector)
+ * @param g The graph to colour
+ * @param numOfEigenvectors The number of eigenvectors
+ */
+template <typename Index>
+void Partition::colour(const BasicGraph<Index>& g, const int& numOfEigenvectors)
+{
+    Timers::Scope timer("colour");
+#ifndef Median_
+    for (Index vertex = 0; vertex < g.size(); vertex++) {
         int colour = 0;
         for (int row = 0; row < numOfEigenvectors; row++) {
             colour += pow(2, row) * Sign(laplacianEigenMatrix_[row][vertex]);
@@ -98,20 +434,7 @@ Partition::Partition(const Graph& g, const int& numOfSubGraphs, bool enableGramS
 #ifdef Median_
     std::vector<double> medianVector;
     double median = 0.0;
-    int fielderIndex = 1;
     for (int i = 0; i < numOfEigenvectors; i++) {
-        auto it = hashmap.find(auxiliaryVector[fielderIndex]);
-        while (abs(it->first) < 1e-2) {
-            fielderIndex++;
-            it = hashmap.find(auxiliaryVector[fielderIndex]);
-        }
-        fielderIndex++;
-        vectorIndex = it->second;
-        ritzValues.push_back(it->first);
-        hashmap.erase(it);  // Deal with identical eigenvalues
-        laplacianEigenMatrix_.push_back(getOneLapEigenVec(
-            lanczos.lanczos_vecs, tridiagonalEigenvectors, vectorIndex));
-
         // Calculate the median for each eigenvector
         std::vector<double> auxiliaryVector2 = laplacianEigenMatrix_[i];
         sort(auxiliaryVector2.begin(), auxiliaryVector2.end());
@@ -125,7 +448,7 @@ Partition::Partition(const Graph& g, const int& numOfSubGraphs, bool enableGramS
         }
         medianVector.push_back(median);
     }
-    for (int vertex = 0; vertex < g.size(); vertex++) {
+    for (Index vertex = 0; vertex < g.size(); vertex++) {
         int colour = 0;
         for (int row = 0; row < numOfEigenvectors; row++) {
             colour +=
@@ -135,9 +458,28 @@ Partition::Partition(const Graph& g, const int& numOfSubGraphs, bool enableGramS
         g.setColour(g.globalIndex(vertex), colour);
     }
 #endif
+}
 
-    double t_par = timer_partition.elapsed();
-    times.push_back(t_par);
+/**
+ * @brief Start vectors from a colouring, e.g. of a previous run, the signs
+ *        of vector r follow bit r of the colours as the eigenvectors did
+ * @param colours colour[local index], -1 for no colour
+ * @param numOfSubGraphs The number of colours
+ * @return vectors[r][local index]
+ */
+DenseMatrix Partition::colourVectors(const std::vector<int>& colours,
+                                     const int& numOfSubGraphs)
+{
+    DenseMatrix vectors(log2(numOfSubGraphs),
+                        std::vector<double>(colours.size(), 0.0));
+    for (unsigned int r = 0; r < vectors.size(); r++) {
+        for (unsigned int vertex = 0; vertex < colours.size(); vertex++) {
+            if (colours[vertex] >= 0) {
+                vectors[r][vertex] = (colours[vertex] >> r) & 1 ? 1.0 : -1.0;
+            }
+        }
+    }
+    return vectors;
 }
 
 inline int Partition::signMedian(double entry, double median)
@@ -191,36 +533,45 @@ void Partition::outputLapEigenvalues()
  * @param vectorIndex
  * @return laplacianVectors
  */
-std::vector<double> Partition::getOneLapEigenVec(DenseMatrix& lanczosVectors,
-                                    DenseMatrix& tridiagonalEigenvectors,
-                                    const int& vectorIndex)
+template <typename T>
+std::vector<double> Partition::getOneLapEigenVec(
+    const LanczosBasis<T>& lanczosVectors,
+    const DenseMatrix& tridiagonalEigenvectors, const int& vectorIndex)
 {
 #ifdef VT_
     VT_TRACER("Partition::getOneLapEigenVec");
 #endif
-    // Find the eigenvector from the vector matrix of the Tridiagonal
-    // eigenvector matrix (each column represents a vector)
-    int size = tridiagonalEigenvectors.size();  // Size of vertices/vectors
-    std::vector<double> vec(size, 0);
-    for (int row = 0; row < size; row++) {
-        for (int col = 0; col < size; col++) {
-            if (col == vectorIndex) {
-                vec[row] = tridiagonalEigenvectors[row][col];
-            }
-        }
-    }
+    Timers::Scope timer("ritz_vector");
     // Calculate the corresponding Laplacian vector by Lanczos vectors(each row
-    // represents a vector, need transposing)
-    // lanczos vector - m * n, tridiagonalEigenvectors - m * m, Ritz - m * n, Ritz_vector
-    // - n
-    int col_size = lanczosVectors[0].size();
+    // represents a vector), the column vectorIndex of the Tridiagonal
+    // eigenvector matrix gives the coefficients.
+    // lanczos vector - m * n, tridiagonalEigenvectors - m * m, Ritz_vector - n
+    // Each Lanczos vector is streamed once in its own precision.
+    int col_size = lanczosVectors.cols();
     int row_size = lanczosVectors.size();
     std::vector<double> laplacianVector(col_size, 0);
-    for (int col = 0; col < col_size; col++) {
-        for (int row = 0; row < row_size; row++) {
-            laplacianVector[col] +=
-                lanczosVectors[row][col] * vec[row];
-        }
+    for (int row = 0; row < row_size; row++) {
+        Kernels::axpy(laplacianVector.data(), lanczosVectors[row].data(),
+                      tridiagonalEigenvectors[row][vectorIndex], col_size);
     }
     return laplacianVector;
 }
+
+template std::vector<double> Partition::getOneLapEigenVec(
+    const LanczosBasis<double>& lanczosVectors,
+    const DenseMatrix& tridiagonalEigenvectors, const int& vectorIndex);
+template std::vector<double> Partition::getOneLapEigenVec(
+    const LanczosBasis<float>& lanczosVectors,
+    const DenseMatrix& tridiagonalEigenvectors, const int& vectorIndex);
+template Partition::Partition(const BasicGraph<int32_t>& g,
+                              const int& numOfSubGraphs,
+                              bool enableGramSchmidt);
+template Partition::Partition(const BasicGraph<int64_t>& g,
+                              const int& numOfSubGraphs,
+                              bool enableGramSchmidt);
+template Partition::Partition(const BasicGraph<int32_t>& g,
+                              const int& numOfSubGraphs,
+                              const PartitionOptions& options);
+template Partition::Partition(const BasicGraph<int64_t>& g,
+                              const int& numOfSubGraphs,
+                              const PartitionOptions& options);
@@ -0,0 +1,92 @@
+/**
+ * @file reorthogonalisation.cc
+ * @brief Partial reorthogonalisation of Lanczos vectors by the omega recurrence
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "reorthogonalisation.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+PartialReorthogonalisation::PartialReorthogonalisation(double eps)
+    : eps_(eps), anorm_(0.0), repeat_(false), steps_(0), vectors_(0)
+{
+}
+
+/**
+ * @brief One step of the omega recurrence (Simon 1984)
+ *        beta_j w_(j+1,k) = beta_k w_(j,k+1) + (alpha_k - alpha_j) w_(j,k)
+ *                           + beta_(k-1) w_(j,k-1) - beta_(j-1) w_(j-1,k)
+ *        plus a rounding term of eps * ||T||
+ * @param alpha alpha_j
+ * @param beta beta_j
+ * @return Indices of the vectors to orthogonalise q_(j+1) against, empty if
+ *         the orthogonality is good enough
+ */
+const vector<int>& PartialReorthogonalisation::next(double alpha, double beta)
+{
+    int j = alpha_.size();
+    double betaPrev = j > 0 ? beta_[j - 1] : 0.0;
+    alpha_.push_back(alpha);
+    beta_.push_back(beta);
+    anorm_ = max(anorm_, abs(alpha) + beta + betaPrev);
+    if (j == 0) {
+        omegaCur_.assign(1, 1.0);
+    }
+
+    // omegaCur_ has j + 1 entries with omegaCur_[j] = 1
+    vector<double> omega(j + 2);
+    double noise = eps_ * anorm_;
+    for (int k = 0; k < j; k++) {
+        double sum = beta_[k] * omegaCur_[k + 1] +
+                     (alpha_[k] - alpha) * omegaCur_[k] -
+                     betaPrev * omegaPrev_[k];
+        if (k > 0) {
+            sum += beta_[k - 1] * omegaCur_[k - 1];
+        }
+        sum += sum >= 0.0 ? noise : -noise;
+        omega[k] = sum / beta;
+    }
+    omega[j] = noise / beta;
+    omega[j + 1] = 1.0;
+    omegaPrev_.swap(omegaCur_);
+    omegaCur_.swap(omega);
+
+    // The vector after a reorthogonalised one inherits its loss of
+    // orthogonality through the three-term recurrence, repeat the same set
+    if (repeat_) {
+        repeat_ = false;
+        return against_;
+    }
+    against_.clear();
+    double maxOmega = 0.0;
+    for (int k = 0; k <= j; k++) {
+        maxOmega = max(maxOmega, abs(omegaCur_[k]));
+    }
+    if (maxOmega > sqrt(eps_)) {
+        double eta = pow(eps_, 0.75);
+        for (int k = 0; k <= j; k++) {
+            if (abs(omegaCur_[k]) > eta) {
+                against_.push_back(k);
+            }
+        }
+        repeat_ = true;
+    }
+    return against_;
+}
+
+/**
+ * @brief Reset the estimates of the vectors q_(j+1) was orthogonalised against
+ * @param beta The norm of q_(j+1) after orthogonalisation
+ */
+void PartialReorthogonalisation::orthogonalised(double beta)
+{
+    for (const int& k : against_) {
+        omegaCur_[k] = eps_;
+    }
+    beta_.back() = beta;
+    steps_++;
+    vectors_ += against_.size();
+}
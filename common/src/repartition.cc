@@ -0,0 +1,147 @@
+/**
+ * @file repartition.cc
+ * @brief Incremental partitioning of a graph under edge updates
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "repartition.h"
+#include <map>
+#include <unordered_set>
+#include "analysis.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+using namespace std;
+
+/**
+ * @brief Partition the graph once with the eigensolver
+ * @param g The graph, its edges are updated by update
+ * @param numOfSubGraphs The number of subgraphs to partition to
+ * @param options Options of the eigensolver
+ * @param tolerance Recompute when the cut edge percent is above
+ *        (1 + tolerance) times the one of the last full partition
+ * @param imbalance A colour may have up to (1 + imbalance) * |V| / colours
+ *        vertices after refinement
+ */
+Repartition::Repartition(Graph& g, const int& numOfSubGraphs,
+                         const PartitionOptions& options,
+                         const double& tolerance, const double& imbalance)
+    : moves(0),
+      recomputes(0),
+      g_(g),
+      numOfSubGraphs_(numOfSubGraphs),
+      options_(options),
+      tolerance_(tolerance),
+      imbalance_(imbalance)
+{
+    partition();
+}
+
+/**
+ * @brief Spectral partition warm started from the eigenvectors of the last
+ *        one, the vertices do not change so they still match
+ */
+void Repartition::partition()
+{
+    Partition part(g_, numOfSubGraphs_, options_);
+    options_.startVectors = part.eigenvectors();
+    g_.updateHaloColours();
+    cut_ = baseline_ = Analysis::cutEdgePercent(g_);
+}
+
+/**
+ * @brief Apply a batch of edge updates, refine the colours around it and
+ *        recompute if the cut has grown past the tolerance
+ * @param inserted Edges to insert, the vertices have to exist
+ * @param removed Edges to remove
+ * @return true if the partition was recomputed
+ */
+bool Repartition::update(const Edges& inserted, const Edges& removed)
+{
+#ifdef VT_
+    VT_TRACER("Repartition::update");
+#endif
+    g_.removeEdges(removed);
+    g_.insertEdges(inserted);
+    refine(inserted, removed);
+    g_.updateHaloColours();
+    cut_ = Analysis::cutEdgePercent(g_);
+
+    // Any process over the threshold recomputes on all of them
+    vector<int> over(1, cut_ > (1.0 + tolerance_) * baseline_ ? 1 : 0);
+    if (g_.globalCounts(over)[1] == 0) {
+        return false;
+    }
+    partition();
+    recomputes++;
+    return true;
+}
+
+/**
+ * @brief Greedy boundary refinement starting from the ends of the updated
+ *        edges, the neighbours of a moved vertex are visited next, up to
+ *        three rounds. A move into a colour over the capacity is still
+ *        allowed if it is smaller than the colour left. Each process moves
+ *        its own vertices with the colours of the halo vertices as of the
+ *        start of the update.
+ */
+void Repartition::refine(const Edges& inserted, const Edges& removed)
+{
+    g_.updateHaloColours();
+    vector<int> colours;
+    for (auto it = g_.cbegin(); it != g_.cend(); ++it) {
+        colours.push_back(g_.getColour(it->first));
+    }
+    map<int, int> sizes = g_.globalCounts(colours);
+    int vertices = 0;
+    for (const auto& it : sizes) {
+        vertices += it.second;
+    }
+    const double capacity = (1.0 + imbalance_) * vertices / numOfSubGraphs_;
+
+    unordered_set<int> frontier, next;
+    for (const Edges* edges : {&inserted, &removed}) {
+        for (const auto& edge : *edges) {
+            for (int vertex : {edge.first, edge.second}) {
+                if (g_.find(vertex) != g_.cend()) {
+                    frontier.insert(vertex);
+                }
+            }
+        }
+    }
+    for (int round = 0; round < 3 && !frontier.empty(); round++) {
+        next.clear();
+        for (const int& vertex : frontier) {
+            auto it = g_.find(vertex);
+            int own = g_.getColour(vertex), best = own;
+            map<int, int> count;  // <colour, neighbours of the colour>
+            count[own] = 0;
+            for (const int& neighbour : it->second) {
+                count[g_.getColour(neighbour)]++;
+            }
+            for (const auto& c : count) {
+                // Within the capacity, or at least no worse balanced
+                bool fits = sizes[c.first] + 1 <= capacity ||
+                            sizes[c.first] + 1 < sizes[own];
+                if (c.second > count[best] && fits) {
+                    best = c.first;
+                }
+            }
+            if (best == own) {
+                continue;
+            }
+            g_.setColour(vertex, best);
+            sizes[own]--;
+            sizes[best]++;
+            moves++;
+            for (const int& neighbour : it->second) {
+                if (g_.find(neighbour) != g_.cend()) {
+                    next.insert(neighbour);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
+}
@@ -0,0 +1,157 @@
+/**
+ * @file timers.cc
+ * @brief Nested wall-clock timers of the phases
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "timers.h"
+#include "trace.h"
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <string>
+
+using namespace std;
+
+struct TimerNode {
+    string name;
+    int parent;
+    vector<int> children;
+    double seconds;
+    long long calls;
+};
+
+// Node 0 is the root above the outermost scopes
+static thread_local vector<TimerNode> nodes(1, TimerNode{"", -1, {}, 0, 0});
+static thread_local int running = 0;  // Node of the innermost running scope
+static thread_local Timers::Entries snapshot;
+
+/**
+ * @brief The node of the name under the parent, added the first time only
+ */
+static int intern(int parent, const char* name)
+{
+    for (const int& child : nodes[parent].children) {
+        if (nodes[child].name == name) {
+            return child;
+        }
+    }
+    nodes.push_back(TimerNode{name, parent, {}, 0.0, 0});
+    nodes[parent].children.push_back(nodes.size() - 1);
+    return nodes.size() - 1;
+}
+
+Timers::Scope::Scope(const char* name)
+    : start_(chrono::steady_clock::now()),
+      name_(name),
+      node_(intern(running, name)),
+      parent_(running),
+      running_(true)
+{
+    running = node_;
+}
+
+double Timers::Scope::elapsed() const
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start_)
+        .count();
+}
+
+/**
+ * @brief Add the time so far to the node of the scope, once
+ * @return The seconds recorded
+ */
+double Timers::Scope::stop()
+{
+    auto end = chrono::steady_clock::now();
+    double seconds = chrono::duration<double>(end - start_).count();
+    if (running_) {
+        running_ = false;
+#ifdef Trace_
+        Trace::record(name_, start_, end);
+#endif
+        if (running == node_) {
+            running = parent_;
+        }
+        nodes[node_].seconds += seconds;
+        nodes[node_].calls++;
+    }
+    return seconds;
+}
+
+/**
+ * @brief The paths are built here, the nodes never called are left out
+ */
+const Timers::Entries& Timers::entries()
+{
+    snapshot.clear();
+    vector<string> paths(nodes.size());
+    for (unsigned int i = 1; i < nodes.size(); i++) {
+        const TimerNode& node = nodes[i];  // Added after its parent
+        paths[i] = node.parent == 0 ? node.name
+                                    : paths[node.parent] + "/" + node.name;
+        if (node.calls > 0) {
+            snapshot[paths[i]] = make_pair(node.seconds, node.calls);
+        }
+    }
+    return snapshot;
+}
+
+/**
+ * @brief The nodes are kept, the running scopes still add to them
+ */
+void Timers::reset()
+{
+    for (TimerNode& node : nodes) {
+        node.seconds = 0.0;
+        node.calls = 0;
+    }
+}
+
+void Timers::merge(const Entries& entries)
+{
+    for (const auto& it : entries) {
+        int node = running;
+        size_t begin = 0, end;
+        do {
+            end = it.first.find('/', begin);
+            node = intern(node, it.first.substr(begin, end - begin).c_str());
+            begin = end + 1;
+        } while (end != string::npos);
+        nodes[node].seconds += it.second.first;
+        nodes[node].calls += it.second.second;
+    }
+}
+
+void Timers::report(ostream& out, const vector<Entries>& processes)
+{
+    set<string> paths;
+    for (const auto& entries : processes) {
+        for (const auto& it : entries) {
+            paths.insert(it.first);
+        }
+    }
+    out << "{\n  \"processes\": " << processes.size() << ",\n  \"timers\": [";
+    bool first = true;
+    for (const string& path : paths) {
+        double min_seconds = numeric_limits<double>::max(), max_seconds = 0.0,
+               sum = 0.0;
+        long long calls = 0;
+        for (const auto& entries : processes) {
+            auto it = entries.find(path);
+            double seconds = it == entries.end() ? 0.0 : it->second.first;
+            if (it != entries.end()) {
+                calls = max(calls, it->second.second);
+            }
+            min_seconds = min(min_seconds, seconds);
+            max_seconds = max(max_seconds, seconds);
+            sum += seconds;
+        }
+        out << (first ? "\n" : ",\n") << "    {\"name\": \"" << path
+            << "\", \"calls\": " << calls << ", \"min\": " << min_seconds
+            << ", \"max\": " << max_seconds
+            << ", \"avg\": " << sum / processes.size() << "}";
+        first = false;
+    }
+    out << "\n  ]\n}" << endl;
+}
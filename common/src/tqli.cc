@@ -5,6 +5,7 @@
  */
 
 #include "tqli.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -22,6 +23,8 @@ using namespace std;
 
 double SQR(double a);
 double pythag(double a, double b);
+static void qlImplicit(vector<double>& d, vector<double>& e,
+                       vector<vector<double>>& z);
 
 // Square a double value
 static double sqrarg;
@@ -55,6 +58,208 @@ double pythag(double a, double b)
  *        column of z returns the normalized eigenvector corresponding to d[k].
  */
 void tqli(vector<double>& d, vector<double>& e, vector<vector<double>>& z)
+{
+    int n = d.size();
+    z.resize(n, vector<double>(n, 0));
+    for (int i = 0; i < n; i++) z[i][i] = 1;
+    e.push_back(0.0);
+    qlImplicit(d, e, z);
+}
+
+/**
+ * @brief Eigenvalues and the last entry of each eigenvector of a symmetric
+ *        tridiagonal matrix, the rotations are only applied to the last row
+ *        of z, O(n^2) instead of O(n^3)
+ * @param d[0..n-1] contains the diagonal elements, the eigenvalues will be
+ *        written
+ * @param e[0..n-2] inputs the subdiagonal elements
+ * @param last[0..n-1] returns the last entry of the eigenvector of d[k]
+ */
+void tqliLastRow(vector<double>& d, vector<double>& e, vector<double>& last)
+{
+    int n = d.size();
+    vector<vector<double>> z(1, vector<double>(n, 0.0));
+    if (n > 0) z[0][n - 1] = 1.0;
+    e.resize(n, 0.0);
+    qlImplicit(d, e, z);
+    last.swap(z[0]);
+}
+
+/**
+ * @brief Whether the smallest Ritz pairs of Lanczos have converged, the
+ *        residual ||L y - theta y|| of a Ritz pair is beta_j times the last
+ *        entry of its eigenvector of the tridiagonal matrix
+ * @param alpha[0..j-1] The diagonal of the tridiagonal matrix
+ * @param beta[0..j-2] The subdiagonal
+ * @param next_beta beta_j, the norm of the next Lanczos vector
+ * @param num Number of the smallest Ritz pairs to check
+ * @param tol Converged if the residual <= tol * max(1, |theta|)
+ */
+bool ritzConverged(const vector<double>& alpha, const vector<double>& beta,
+                   const double& next_beta, const int& num, const double& tol)
+{
+    vector<double> d = alpha, e = beta, last;
+    tqliLastRow(d, e, last);
+    vector<int> order(d.size());
+    for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(),
+         [&](int a, int b) { return d[a] < d[b]; });
+    for (int i = 0; i < num && i < (int)order.size(); i++) {
+        double theta = d[order[i]];
+        if (next_beta * fabs(last[order[i]]) > tol * max(1.0, fabs(theta)))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Whether the smallest Ritz pairs of block Lanczos have converged,
+ *        the residual of a Ritz pair is ||B_j s_j|| with s_j the last block
+ *        of its eigenvector of the block tridiagonal matrix
+ * @param block_tri The block tridiagonal matrix, only the leading n * n
+ *        part is used
+ * @param n Number of Lanczos vectors so far, a multiple of b
+ * @param next_beta B_j, b * b row major, coupling the next block
+ * @param b The block size
+ * @param num Number of the smallest Ritz pairs to check
+ * @param tol Converged if the residual <= tol * max(1, |theta|)
+ */
+bool blockRitzConverged(const vector<vector<double>>& block_tri, const int& n,
+                        const vector<double>& next_beta, const int& b,
+                        const int& num, const double& tol)
+{
+    vector<vector<double>> a(n), z;
+    for (int i = 0; i < n; i++) {
+        a[i].assign(block_tri[i].begin(), block_tri[i].begin() + n);
+    }
+    vector<double> d;
+    symmetricEigen(a, d, z);
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    sort(order.begin(), order.end(),
+         [&](int x, int y) { return d[x] < d[y]; });
+    for (int i = 0; i < num && i < n; i++) {
+        double residual = 0.0;
+        for (int r = 0; r < b; r++) {
+            double entry = 0.0;
+            for (int c = 0; c < b; c++) {
+                entry += next_beta[r * b + c] * z[n - b + c][order[i]];
+            }
+            residual += entry * entry;
+        }
+        double theta = d[order[i]];
+        if (sqrt(residual) > tol * max(1.0, fabs(theta))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Eigenvalues and eigenvectors of a dense symmetric matrix, e.g. the
+ *        block tridiagonal matrix of block Lanczos, by Householder reduction
+ *        to tridiagonal form (tred2) followed by implicit QL
+ * @param a[0..n-1][0..n-1] The symmetric matrix
+ * @param d[0..n-1] returns the eigenvalues
+ * @param z[0..n-1][0..n-1] the kth column returns the normalized eigenvector
+ *        corresponding to d[k]
+ */
+void symmetricEigen(const vector<vector<double>>& a, vector<double>& d,
+                    vector<vector<double>>& z)
+{
+    vector<double> e;
+    z = a;
+    tred2(z, d, e);
+    qlImplicit(d, e, z);
+}
+
+/**
+ * @brief Householder reduction of a real symmetric matrix to tridiagonal
+ *        form
+ * @param z[0..n-1][0..n-1] inputs the matrix, returns the orthogonal matrix
+ *        Q with Q^T A Q tridiagonal
+ * @param d[0..n-1] returns the diagonal elements of the tridiagonal matrix
+ * @param e[0..n-1] returns the subdiagonal elements, e[i] couples i and
+ *        i + 1 and e[n-1] = 0
+ */
+void tred2(vector<vector<double>>& z, vector<double>& d, vector<double>& e)
+{
+#ifdef VT_
+    VT_TRACER("TRED2");
+#endif
+    int l, k, j, i;
+    double scale, hh, h, g, f;
+
+    int n = z.size();
+    d.assign(n, 0.0);
+    e.assign(n, 0.0);
+    for (i = n - 1; i > 0; i--) {
+        l = i - 1;
+        h = scale = 0.0;
+        if (l > 0) {
+            for (k = 0; k < i; k++) scale += fabs(z[i][k]);
+            if (scale == 0.0) {
+                e[i] = z[i][l];
+            } else {
+                for (k = 0; k < i; k++) {
+                    z[i][k] /= scale;
+                    h += z[i][k] * z[i][k];
+                }
+                f = z[i][l];
+                g = (f >= 0.0 ? -sqrt(h) : sqrt(h));
+                e[i] = scale * g;
+                h -= f * g;
+                z[i][l] = f - g;
+                f = 0.0;
+                for (j = 0; j < i; j++) {
+                    z[j][i] = z[i][j] / h;
+                    g = 0.0;
+                    for (k = 0; k < j + 1; k++) g += z[j][k] * z[i][k];
+                    for (k = j + 1; k < i; k++) g += z[k][j] * z[i][k];
+                    e[j] = g / h;
+                    f += e[j] * z[i][j];
+                }
+                hh = f / (h + h);
+                for (j = 0; j < i; j++) {
+                    f = z[i][j];
+                    e[j] = g = e[j] - hh * f;
+                    for (k = 0; k < j + 1; k++)
+                        z[j][k] -= (f * e[k] + g * z[i][k]);
+                }
+            }
+        } else {
+            e[i] = z[i][l];
+        }
+        d[i] = h;
+    }
+    d[0] = 0.0;
+    e[0] = 0.0;
+    // Accumulate the transformations
+    for (i = 0; i < n; i++) {
+        if (d[i] != 0.0) {
+            for (j = 0; j < i; j++) {
+                g = 0.0;
+                for (k = 0; k < i; k++) g += z[i][k] * z[k][j];
+                for (k = 0; k < i; k++) z[k][j] -= g * z[k][i];
+            }
+        }
+        d[i] = z[i][i];
+        z[i][i] = 1.0;
+        for (j = 0; j < i; j++) z[j][i] = z[i][j] = 0.0;
+    }
+    // e[i] couples i - 1 and i above, shift it for qlImplicit
+    for (i = 1; i < n; i++) e[i - 1] = e[i];
+    if (n > 0) e[n - 1] = 0.0;
+}
+
+/**
+ * @brief Implicit QL with shifts on a tridiagonal matrix
+ * @param d[0..n-1] the diagonal, returns the eigenvalues
+ * @param e[0..n-1] the subdiagonal, e[i] couples i and i + 1
+ * @param z[0..n-1][0..n-1] inputs the accumulated transformations (the
+ *        identity for a tridiagonal matrix), returns the eigenvectors. Only
+ *        the rows of z given are rotated, e.g. a single row.
+ */
+static void qlImplicit(vector<double>& d, vector<double>& e,
+                       vector<vector<double>>& z)
 {
 #ifdef VT_
     VT_TRACER("TQLI");
@@ -64,9 +269,6 @@ void tqli(vector<double>& d, vector<double>& e, vector<vector<double>>& z)
     const double EPS = numeric_limits<double>::epsilon();
 
     int n = d.size();
-    z.resize(n, vector<double>(n, 0));
-    for (int i = 0; i < n; i++) z[i][i] = 1;
-    e.push_back(0.0);
 
     for (l = 0; l < n; l++) {
         iter = 0;
@@ -107,7 +309,7 @@ void tqli(vector<double>& d, vector<double>& e, vector<vector<double>>& z)
                     // Next loop can be omitted if eigenvectors not wanted
                     // Form eigenvectors.
 
-                    for (k = 0; k < n; k++) {
+                    for (k = 0; k < (int)z.size(); k++) {
                         // VT_TRACER("TQLI - Form eigenvectors");
                         f = z[k][i + 1];
                         z[k][i + 1] = s * z[k][i] + c * f;
@@ -0,0 +1,100 @@
+/**
+ * @file trace.cc
+ * @brief Chrome trace timeline of the solver phases
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#include "trace.h"
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+static vector<Trace::Event> ring;
+static atomic<uint64_t> next_event(0);
+static Trace::Clock::time_point origin;
+static atomic<int> threads_seen(0);
+
+static int threadId()
+{
+    static thread_local int id = threads_seen++;
+    return id;
+}
+
+void Trace::start(const size_t& capacity)
+{
+    ring.assign(capacity, Event());
+    next_event = 0;
+    threadId();
+    origin = Clock::now();
+}
+
+/**
+ * @brief Lock free, the slot is claimed by one atomic increment
+ */
+void Trace::record(const char* name, const Clock::time_point& begin,
+                   const Clock::time_point& end)
+{
+    if (ring.empty()) {
+        return;
+    }
+    uint64_t slot = next_event.fetch_add(1, memory_order_relaxed);
+    Event& event = ring[slot % ring.size()];
+    event.name = name;
+    event.begin =
+        chrono::duration_cast<chrono::nanoseconds>(begin - origin).count();
+    event.end =
+        chrono::duration_cast<chrono::nanoseconds>(end - origin).count();
+    event.thread = threadId();
+}
+
+vector<Trace::Event> Trace::events()
+{
+    uint64_t count = next_event, capacity = ring.size();
+    vector<Trace::Event> ordered;
+    if (count <= capacity) {
+        ordered.assign(ring.begin(), ring.begin() + count);
+    } else {
+        auto first = ring.begin() + count % capacity;
+        ordered.assign(first, ring.end());
+        ordered.insert(ordered.end(), ring.begin(), first);
+    }
+    return ordered;
+}
+
+uint64_t Trace::dropped()
+{
+    uint64_t count = next_event;
+    return count > ring.size() ? count - ring.size() : 0;
+}
+
+/**
+ * @brief The times are in microseconds, a metadata event names the process
+ *        "rank <process>" and counts the dropped events
+ */
+string Trace::json(const int& process)
+{
+    stringstream out;
+    out << fixed << setprecision(3);
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << process
+        << ", \"args\": {\"name\": \"rank " << process
+        << "\", \"dropped\": " << dropped() << "}}";
+    for (const Event& event : events()) {
+        out << ",\n{\"name\": \"" << event.name
+            << "\", \"ph\": \"X\", \"pid\": " << process
+            << ", \"tid\": " << event.thread
+            << ", \"ts\": " << event.begin / 1000.0
+            << ", \"dur\": " << (event.end - event.begin) / 1000.0 << "}";
+    }
+    return out.str();
+}
+
+void Trace::write(ostream& out, const vector<string>& processes)
+{
+    out << "{\"traceEvents\": [\n";
+    for (size_t p = 0; p < processes.size(); p++) {
+        out << (p > 0 ? ",\n" : "") << processes[p];
+    }
+    out << "\n], \"displayTimeUnit\": \"ms\"}" << endl;
+}
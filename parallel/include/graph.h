@@ -6,8 +6,9 @@
 
 /*
  * =====================================================================================
- *        Class:  Graph
- *  Description:  Class to create a new graph object
+ *        Class:  BasicGraph
+ *  Description:  Class to create a new graph object, Index is the type of
+ *                the vertex ids
  * =====================================================================================
  */
 
@@ -15,57 +16,137 @@
 #define GRAPH_H_
 
 #include <boost/mpi.hpp>
+#include <cstdint>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
+#include "generator.h"
 
-class Graph
+template <typename Index>
+class BasicGraph
 {
 private:
     boost::mpi::communicator world;
-    typedef std::unordered_set<int> SetOfNeighbours;
-    std::unordered_map<int, SetOfNeighbours> G;
+    typedef std::unordered_set<Index> SetOfNeighbours;
+    std::unordered_map<Index, SetOfNeighbours> G;
 
-    int local_size_;
-    int global_size_;
+    Index local_size_;
+    Index global_size_;
     int rank_;
-    std::vector<int> global_index_;
-    std::vector<int> local_index_;
+    std::vector<Index> global_index_;
+    std::vector<Index> local_index_;
+    std::vector<Index> original_index_;  // <new index, index in the input>
 
-    mutable std::unordered_map<int, int> Colour;
-    void addEdge(int src, int dest);
+    mutable std::unordered_map<Index, int> Colour;
+    // Both directions of an undirected edge, the smaller id first
+    typedef std::pair<Index, Index> EdgeKey;
+    struct EdgeHash {
+        std::size_t operator()(const EdgeKey& key) const
+        {
+            return std::hash<Index>()(key.first) * 31 +
+                   std::hash<Index>()(key.second);
+        }
+    };
+    static EdgeKey edgeKey(Index src, Index dest);
+    // <edge key, weight> of the edges of the local vertices, only the
+    // weights other than 1 are kept
+    std::unordered_map<EdgeKey, double, EdgeHash> Weight;
+    void addEdge(Index src, Index dest, double weight = 1.0);
+    void indexOwnedVertices();
+    void readOwnedEdges(const std::string& filename);
 
 public:
-    Graph() {}
-    Graph(int n);  // Construct a random graph with n vertices
-    typedef std::unordered_map<int, std::unordered_set<int>>::const_iterator
+    typedef Index index_type;
+
+    BasicGraph() {}
+    BasicGraph(Index n);  // Construct a random graph with n vertices
+    typedef typename std::unordered_map<Index, SetOfNeighbours>::const_iterator
         const_iterator;
-    const const_iterator find(int vertex) const;
+    const const_iterator find(Index vertex) const;
     const const_iterator cbegin() const;
     const const_iterator cend() const;
 
-    const int edgesNum() const;
+    const int64_t edgesNum() const;  // 64-bit, may exceed 2^31
+    const int64_t haloEdgesNum() const;
     const int subgraphsNum() const;
 
-    void setColour(int vertex, int colour) const;
-    const int getColour(int vertex) const;
+    void setColour(Index vertex, int colour) const;
+    const int getColour(Index vertex) const;
+    const double getWeight(Index src, Index dest) const;  // 1 if not weighted
+    // Any local weight other than 1, the Laplacian uses the weighted kernel
+    bool weighted() const { return !Weight.empty(); }
 
-    void readDotFormat(const std::string& filename, const int& global_size);
+    void readDotFormat(const std::string& filename, const Index& global_size);
+    void readDotFormatBalanced(const std::string& filename,
+                               const Index& global_size);
+    // Replace the graph by the one of the generator with the even
+    // assignment, each process generates its slice over threads (0 for the
+    // hardware concurrency), throw std::out_of_range beyond Index ids
+    void generate(const Generator& generator, const int& threads = 0);
     void readDotFormatWithColour(const std::string& filename);
     void readDotFormatByColour(const std::string& filename,
-                               const int& global_size);
+                               const Index& global_size);
+    bool rebalance(const double& tolerance);
+    void reorder(const std::string& ordering);
+    void restoreOrder();
+
+    // component[local index] = smallest global index in its connected
+    // component
+    std::vector<Index> components() const;
+    // <label, number of vertices with the label over all the processes>,
+    // label[local index]
+    std::map<Index, Index> globalCounts(const std::vector<Index>& label) const;
+    // The graph induced by the local vertices given by every process,
+    // relabelled 0.. in the order of the processes, each process keeps its
+    // vertices
+    BasicGraph subgraph(const std::vector<Index>& vertices) const;
+    // Every component spans the processes, they are partitioned in turn on
+    // the calling thread
+    static int solverThreads() { return 0; }
+    // Batched updates of the adjacency sets, no other structure is rebuilt.
+    // Every process is given the whole batch and updates the vertices it
+    // owns, throw std::out_of_range for a vertex not in the graph
+    void insertEdges(const std::vector<std::pair<Index, Index>>& edges);
+    void removeEdges(const std::vector<std::pair<Index, Index>>& edges);
+    // Copy the colours of the halo vertices from their owners, getColour
+    // works for the neighbours then. Every process has to call it.
+    void updateHaloColours() const;
+
+    // vectors[r][local index] to a file by the indices in the input, e.g.
+    // the eigenvectors for a warm start, written by rank 0
+    void outputVectors(const std::string& filename,
+                       const std::vector<std::vector<double>>& vectors) const;
+    // vectors[r][local index] of outputVectors, 0 for the vertices not in
+    // the file
+    std::vector<std::vector<double>> readVectors(
+        const std::string& filename) const;
+    // colour[local index] of a dot file with colours, -1 if a vertex has none
+    std::vector<int> readColours(const std::string& filename) const;
     void outputDotFormat(const std::string& filename) const;
     void printDotFormat() const;
     void printLaplacianMat() const;
+    // Record the sizes of the adjacency, the weights and the index maps in
+    // MemoryUsage
+    void recordMemory() const;
 
-    const int globalSize() const;
-    const int size() const;  // local_size
+    const Index globalSize() const;
+    const Index size() const;  // local_size
     const int rank() const;
-    const int globalIndex(int local_index) const;
-    const int localIndex(int global_index) const;
+    const Index globalIndex(Index local_index) const;
+    const Index localIndex(Index global_index) const;
     std::vector<int> global_rank_map;
 };
 
+// 32-bit ids keep the adjacency compact, 64-bit ids go beyond 2^31
+// vertices, both are instantiated in graph.cc
+typedef BasicGraph<int32_t> Graph;
+typedef BasicGraph<int64_t> Graph64;
+extern template class BasicGraph<int32_t>;
+extern template class BasicGraph<int64_t>;
+
 #endif
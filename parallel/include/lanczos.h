@@ -8,36 +8,106 @@
 #define LANCZOS_H_
 
 #include <boost/mpi.hpp>
+#include <cstdint>
 #include <unordered_map>
+#include <string>
 #include <vector>
+#include "basis.h"
+#include "chebyshev.h"
 #include "graph.h"
+#include "laplacian.h"
 
-template <typename Vector, typename T>
+/*
+ * =====================================================================================
+ *        Class:  Lanczos
+ *  Description:  Vector is the type of the working vectors with entries of T,
+ *                Basis is the type to store the Lanczos vectors, e.g.
+ *                std::vector<float> halves the memory of the basis while the
+ *                recurrence and reductions are still done in T. The basis
+ *                is kept in a file in spill_dir when it is not empty.
+ *                With block > 1 block Lanczos is used, the result is
+ *                block_tri instead of alpha and beta.
+ *                The start vectors are Chebyshev filtered with
+ *                filter_degree > 0.
+ *                A warm start takes the start vector from the eigenvectors
+ *                of a previous run (their sum, or the first block), and
+ *                stops as soon as the smallest Ritz pairs have converged
+ *                instead of after the fixed number of iterations.
+ *                The constant vector is projected out of the start vector
+ *                and every iterate, the Ritz values are the non-trivial
+ *                eigenvalues only.
+ *                Operator is the policy of normalisation.h, the null
+ *                vector D^1/2 1 is projected out instead for a normalised
+ *                one. Index is the vertex type of the graph, the local
+ *                Lanczos vectors are indexed by int either way.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T, typename Basis = Vector,
+          typename Operator = Combinatorial, typename Index = int32_t>
 class Lanczos
 {
 private:
     boost::mpi::communicator world;
-    Vector init(const Graph& g);
-    Vector multGraphVec(const Graph& g, const Vector& vec);
-    inline T dot(const Vector& v1, const Vector& v2);
+    // Random, orthogonal to the constant
+    Vector init(const BasicGraph<Index>& g);
+    Vector init(const std::vector<Vector>& start, const BasicGraph<Index>& g);
+    void deflate(Vector& x, const int& width = 1);
+    Vector null_;  // Unit null vector of the operator, empty if constant
+    template <typename V>
+    inline T dot(const V& v1, const Vector& v2);
     inline T norm(const Vector& vec);
-    inline void gramSchmidt(const int& iter, Vector& v);
-    const int getIteration(const int& num_of_eigenvec, const int& global_size);
+    inline T reorthogonalise(const std::vector<int>& against, Vector& w);
+
+    static int basisSize(const BasicGraph<Index>& g);
 
-    std::unordered_map<int, std::vector<int>>
-        halo_recv;  // <rank, halo_neighbours to receive>
-    std::unordered_map<int, std::vector<int>>
-        halo_send;  // <rank, halo_neighbours to send>
-    void haloInit(const Graph& g);
-    void haloUpdate(const Graph& g, Vector& v_local, Vector& v_halo);
+    void blockLanczos(const BasicGraph<Index>& g,
+                      Laplacian<Vector, T, Operator, Index>& laplacian,
+                      ChebyshevFilter<Vector, T, Operator, Index>& filter,
+                      const int& num_of_eigenvec, const int& m, bool SO,
+                      const std::string& spill_dir,
+                      const std::vector<Vector>& start);
+    std::vector<T> orthonormalise(const BasicGraph<Index>& g, Vector& x);
+    void reorthogonaliseBlock(Vector& w);
+    void storeBlock(const Vector& x);
+    // Where the next Lanczos vector is written: in place into the basis when
+    // it is in T, otherwise into buffer, then stored in lower precision by
+    // storeVector
+    static T* nextVector(LanczosBasis<T>& basis, Vector& buffer)
+    {
+        return basis.append();
+    }
+    template <typename S>
+    static T* nextVector(LanczosBasis<S>& basis, Vector& buffer)
+    {
+        return buffer.data();
+    }
+    static void storeVector(LanczosBasis<T>& basis, const Vector& buffer) {}
+    template <typename S>
+    static void storeVector(LanczosBasis<S>& basis, const Vector& buffer)
+    {
+        basis.push_back(buffer);
+    }
+    void reduce(std::vector<T>& local);  // Sum over processes, in place
 
 public:
-    Lanczos(const Graph& g, const int& num_of_eigenvec, bool GramSchmidt);
+    Lanczos(const BasicGraph<Index>& g, const int& num_of_eigenvec,
+            bool GramSchmidt, const std::string& spill_dir = std::string(),
+            const int& block = 1, const int& filter_degree = 0,
+            const std::vector<Vector>& start = std::vector<Vector>());
 
     Vector alpha;
     Vector beta;
-    std::vector<Vector> lanczos_vecs;
+    LanczosBasis<typename Basis::value_type> lanczos_vecs;
+    int reorthogonalisations;  // Steps that needed reorthogonalisation
+    int block_size;
+    bool converged;  // The Ritz pairs of a warm start have converged
+    std::vector<Vector> block_tri;  // If block_size > 1
     void print_tri_mat();
+    // Number of iterations for the eigenvectors of a graph of size vertices,
+    // throw std::out_of_range if it does not fit in int
+    static const int getIteration(const int& num_of_eigenvec,
+                                  const int64_t& global_size);
 };
 
 #include "../src/lanczos.cc"
@@ -0,0 +1,81 @@
+/**
+ * @file laplacian.h
+ * @brief The interface of the Laplacian matrix
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef LAPLACIAN_H_
+#define LAPLACIAN_H_
+
+#include <boost/mpi.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "graph.h"
+#include "normalisation.h"
+
+/*
+ * =====================================================================================
+ *        Class:  Laplacian
+ *  Description:  L = D - A of the local (weighted) graph, multiplies width
+ *                vectors stored row by row (entry (i, c) at x[i * width + c])
+ *                and exchanges the halo with the other processes. A
+ *                normalised Operator multiplies by D^-1/2 L D^-1/2.
+ *                Index is the type of the vertex ids of the graph.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T, typename Operator = Combinatorial,
+          typename Index = int32_t>
+class Laplacian
+{
+private:
+    const BasicGraph<Index>& g;
+    boost::mpi::communicator world;
+    std::unordered_map<int, std::vector<Index>>
+        halo_recv;  // <rank, halo_neighbours to receive>
+    std::unordered_map<int, std::vector<Index>>
+        halo_send;  // <rank, halo_neighbours to send>
+    Vector v_halo;  // Indexed by global index * width
+    // The packed halo values of each process and the requests, kept
+    // between the exchanges
+    std::unordered_map<int, std::vector<T>> buf_send, buf_recv;
+    std::vector<boost::mpi::request> requests;
+    // Weights in the order the local rows and their neighbours are visited,
+    // empty for an unweighted graph
+    std::vector<T> weights;
+    // D^-1/2 of each local and halo vertex by global index for a normalised
+    // operator, 0 if isolated
+    std::vector<T> scale;
+    template <bool Weighted, bool Normalised>
+    void multiplyRows(T* y, const int& width);
+    // Sum of the edge weights
+    T degree(typename BasicGraph<Index>::const_iterator it) const;
+
+public:
+    explicit Laplacian(const BasicGraph<Index>& graph);
+
+    void multiply(const Vector& x, Vector& y, const int& width = 1);
+    // Into y of size() * width entries given by the caller, e.g. a row of
+    // the Lanczos basis
+    void multiply(const T* x, T* y, const int& width = 1);
+    // Copy the entries of the halo vertices from their owners into the halo
+    // vector, multiply does it first
+    void haloUpdate(const Vector& v_local, const int& width);
+    void haloUpdate(const T* v_local, const int& width);
+    void reduce(std::vector<T>& local);  // Sum over processes, in place
+    Index size() const { return g.size(); }
+    Index globalSize() const { return g.globalSize(); }
+    int rank() const { return g.rank(); }
+    Vector diagonal() const;  // Weighted degrees of the local vertices
+    T spectralBound() const;  // Upper bound of the eigenvalues, 2 * max degree
+    // Local part of the unit eigenvector of eigenvalue 0 of a normalised
+    // operator, D^1/2 1 normalised, empty for the combinatorial one
+    Vector nullVector();
+    // Map a (local) eigenvector of the operator multiply applies to one of
+    // Operator, D^-1/2 u for the random walk Laplacian
+    void toEigenvector(Vector& u);
+};
+
+#include "../src/laplacian.cc"
+#endif
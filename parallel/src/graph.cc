@@ -1,20 +1,59 @@
 /**
  * @file graph.cc
- * @brief Member functions for Class Graph.hpp
+ * @brief Member functions for Class BasicGraph
  * @author Ken Hu, xnchnhu@gmail.com
  */
 
+#include <algorithm>
 #include <chrono>
 #include <climits>
+#include <cstdint>
+#include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
 #include "graph.h"
+#include "memory_usage.h"
+#include "ordering.h"
 
+namespace mpi = boost::mpi;
 using namespace std;
-typedef std::unordered_map<int, std::unordered_set<int>>::const_iterator
-    const_iterator;
+
+/**
+ * @brief Key of an undirected edge, the same for both directions
+ */
+template <typename Index>
+typename BasicGraph<Index>::EdgeKey BasicGraph<Index>::edgeKey(Index src,
+                                                               Index dest)
+{
+    if (src > dest) swap(src, dest);
+    return EdgeKey(src, dest);
+}
+
+/**
+ * @brief Read the rest of an edge line, "[weight=w] ;" or " ;"
+ * @return The weight, 1 if the line has none
+ */
+static double readWeight(istream& In)
+{
+    string rest;
+    getline(In, rest);
+    size_t at = rest.find("weight=");
+    if (at == string::npos) return 1.0;
+    double weight = atof(rest.c_str() + at + 7);
+    if (weight < 0.0) {
+        std::cerr << "ERROR: Negative edge weight " << weight << endl;
+        exit(-1);
+    }
+    return weight;
+}
 
 /**
  * @brief Generate random graphs with the addEdge function
@@ -22,18 +61,18 @@ typedef std::unordered_map<int, std::unordered_set<int>>::const_iterator
  * @return FILL-ME-IN
  */
 
-Graph::Graph(int num_of_vertex)
+template <typename Index>
+BasicGraph<Index>::BasicGraph(Index num_of_vertex)
 {
     unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
     std::default_random_engine rng(seed);
     uniform_int_distribution<int> num_of_neigh(1, 3);
 
-    for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
         int num_of_neighbour = num_of_neigh(rng);
-        uniform_int_distribution<int> randneigh(0, num_of_vertex - 1);
-        unordered_set<int> neighbours;
+        uniform_int_distribution<Index> randneigh(0, num_of_vertex - 1);
         for (int neighbour = 0; neighbour < num_of_neighbour; neighbour++) {
-            int rand_neighbour = 0;
+            Index rand_neighbour = 0;
             int trials = 1000;
             do {
                 rand_neighbour = randneigh(rng);
@@ -44,21 +83,29 @@ Graph::Graph(int num_of_vertex)
             addEdge(vertex, rand_neighbour);
         }
     }
-    if (G.size() != (unsigned)num_of_vertex)
+    if ((Index)G.size() != num_of_vertex)
         throw std::length_error("The size of generated graph is incorrect.");
     cout << "Graph generation is done." << endl;
 }
 
-void Graph::addEdge(int src, int dest)
+template <typename Index>
+void BasicGraph<Index>::addEdge(Index src, Index dest, double weight)
 {
     // Avoid the self circle
     if (src == dest) return;
+    // Only the weights other than 1 are kept, a weight of 1 drops the one
+    // of an earlier insertion
+    if (weight != 1.0) {
+        Weight[edgeKey(src, dest)] = weight;
+    } else if (!Weight.empty()) {
+        Weight.erase(edgeKey(src, dest));
+    }
     // Add edge src->edge
     auto it = G.find(src);
     if (it != G.end())
         it->second.insert(dest);
     else {
-        unordered_set<int> edges;
+        SetOfNeighbours edges;
         edges.insert(dest);
         G.insert({src, edges});
     }
@@ -70,9 +117,14 @@ void Graph::addEdge(int src, int dest)
  * @return FILL-ME-IN
  */
 
-void Graph::setColour(int vertex, int colour) const { Colour[vertex] = colour; }
+template <typename Index>
+void BasicGraph<Index>::setColour(Index vertex, int colour) const
+{
+    Colour[vertex] = colour;
+}
 
-const int Graph::getColour(int vertex) const
+template <typename Index>
+const int BasicGraph<Index>::getColour(Index vertex) const
 {
     if (Colour.size() == 0) {
         return 0;
@@ -80,63 +132,132 @@ const int Graph::getColour(int vertex) const
     return Colour.at(vertex);
 }
 
+template <typename Index>
+const double BasicGraph<Index>::getWeight(Index src, Index dest) const
+{
+    if (Weight.empty()) return 1.0;
+    auto it = Weight.find(edgeKey(src, dest));
+    return it != Weight.end() ? it->second : 1.0;
+}
+
 /**
  * @brief Functions to return graph properties
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
 
-const int Graph::edgesNum() const
+template <typename Index>
+const int64_t BasicGraph<Index>::edgesNum() const
 {
-    int edges = 0;
+    int64_t edges = 0;
     for (auto& it : G) {
         edges += it.second.size();
     }
     return edges / 2;
 }
 
-const int Graph::subgraphsNum() const
+template <typename Index>
+const int64_t BasicGraph<Index>::haloEdgesNum() const
+{
+    int64_t edges = 0;
+    for (auto& it : G) {
+        for (const Index& neighbour : it.second) {
+            if (global_rank_map[neighbour] != rank_) edges++;
+        }
+    }
+    return edges;
+}
+
+template <typename Index>
+const int BasicGraph<Index>::subgraphsNum() const
 {
     if (Colour.size() == 0) {
         cout << "WARNING:The graph hasn't been partitioned." << endl;
         return 1;
     }
-    unordered_map<int, int> reverse_vertex_set;
+    unordered_map<int, Index> reverse_vertex_set;
     for (const auto& it : Colour) {
         reverse_vertex_set.insert({it.second, it.first});
     }
     return reverse_vertex_set.size();
 }
 
-const const_iterator Graph::find(int vertex) const { return G.find(vertex); }
+template <typename Index>
+const typename BasicGraph<Index>::const_iterator BasicGraph<Index>::find(
+    Index vertex) const
+{
+    return G.find(vertex);
+}
 
-const const_iterator Graph::cbegin() const { return G.cbegin(); }
+template <typename Index>
+const typename BasicGraph<Index>::const_iterator BasicGraph<Index>::cbegin()
+    const
+{
+    return G.cbegin();
+}
 
-const const_iterator Graph::cend() const { return G.cend(); }
+template <typename Index>
+const typename BasicGraph<Index>::const_iterator BasicGraph<Index>::cend()
+    const
+{
+    return G.cend();
+}
 
-const int Graph::globalSize() const { return global_size_; }
+template <typename Index>
+const Index BasicGraph<Index>::globalSize() const
+{
+    return global_size_;
+}
 
-const int Graph::size() const { return local_size_; }
+template <typename Index>
+const Index BasicGraph<Index>::size() const
+{
+    return local_size_;
+}
 
-const int Graph::rank() const { return rank_; }
+template <typename Index>
+const int BasicGraph<Index>::rank() const
+{
+    return rank_;
+}
 
-const int Graph::globalIndex(int local_index) const
+template <typename Index>
+const Index BasicGraph<Index>::globalIndex(Index local_index) const
 {
     return global_index_[local_index];
 }
 
-const int Graph::localIndex(int global_index) const
+template <typename Index>
+const Index BasicGraph<Index>::localIndex(Index global_index) const
 {
     return local_index_.at(global_index);
 }
 
+/**
+ * @brief local_index_ and global_rank_map have an entry for every vertex of
+ *        the graph in every process
+ */
+template <typename Index>
+void BasicGraph<Index>::recordMemory() const
+{
+    MemoryUsage::record("graph/adjacency", MemoryUsage::bytes(G));
+    if (weighted()) {
+        MemoryUsage::record("graph/weights", MemoryUsage::bytes(Weight));
+    }
+    MemoryUsage::record("graph/index", MemoryUsage::bytes(global_index_) +
+                                           MemoryUsage::bytes(original_index_));
+    MemoryUsage::record("graph/local_index", MemoryUsage::bytes(local_index_));
+    MemoryUsage::record("graph/rank_map", MemoryUsage::bytes(global_rank_map));
+}
+
 /**
  * @brief Write graph in DOT format
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
 
-void Graph::outputDotFormat(const string& filename) const
+template <typename Index>
+void BasicGraph<Index>::outputDotFormat(const string& filename) const
 {
     ofstream Output(filename, ios::out | ios::trunc);
     Output << "Undirected Graph {" << endl;
@@ -151,8 +272,13 @@ void Graph::outputDotFormat(const string& filename) const
         }
     }
     for (auto it = G.cbegin(); it != G.cend(); ++it) {
-        for (const int& neighbour : it->second) {
-            Output << it->first << "--" << neighbour << " ;" << endl;
+        for (const Index& neighbour : it->second) {
+            Output << it->first << "--" << neighbour;
+            if (weighted()) {
+                Output << " [weight=" << getWeight(it->first, neighbour)
+                       << "]";
+            }
+            Output << " ;" << endl;
         }
     }
     Output << "}" << endl;
@@ -164,23 +290,24 @@ void Graph::outputDotFormat(const string& filename) const
  * @return FILL-ME-IN
  */
 
-void Graph::printDotFormat() const
+template <typename Index>
+void BasicGraph<Index>::printDotFormat() const
 {
-    int num_of_vertex = G.size();
+    Index num_of_vertex = G.size();
     cout << "Undirected Graph {" << endl;
     if (Colour.size() == 0) {
-        for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+        for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
             cout << globalIndex(vertex) << ";" << endl;
         }
     } else {
-        for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+        for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
             cout << globalIndex(vertex)
                  << "[C=" << getColour(globalIndex(vertex)) << "];" << endl;
         }
     }
-    for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
         auto it = G.find(globalIndex(vertex));
-        for (const int& neighbour : it->second)
+        for (const Index& neighbour : it->second)
             cout << globalIndex(vertex) << "--" << neighbour << " ;" << endl;
     }
     cout << "}" << endl;
@@ -192,24 +319,25 @@ void Graph::printDotFormat() const
  * @return FILL-ME-IN
  */
 
-void Graph::printLaplacianMat() const
+template <typename Index>
+void BasicGraph<Index>::printLaplacianMat() const
 {
-    int num_of_vertex = G.size();
+    Index num_of_vertex = G.size();
 
-    int start = rank_ * num_of_vertex;
-    int end = start + num_of_vertex;
+    Index start = rank_ * num_of_vertex;
+    Index end = start + num_of_vertex;
 
     cout << "Laplacian Matrix:" << endl;
-    for (int vertex = 0; vertex < end; vertex++) {
+    for (Index vertex = 0; vertex < end; vertex++) {
         cout << "\t";
         if (vertex >= start) cout << vertex;
     }
     cout << endl;
 
-    for (int row = 0; row < num_of_vertex; row++) {
+    for (Index row = 0; row < num_of_vertex; row++) {
         cout << globalIndex(row) << "\t";
         auto it = G.find(globalIndex(row));
-        for (int col = 0; col < global_size_; col++) {
+        for (Index col = 0; col < global_size_; col++) {
             if (col == globalIndex(row))
                 cout << G.at(globalIndex(row)).size() << "\t";
             else if (it->second.find(col) != it->second.end())
@@ -223,19 +351,49 @@ void Graph::printLaplacianMat() const
 
 /**
  * @brief Even assignment: Load the equal number of vertices to each process
- * from Dot file
+ * from Dot file, the remainder is spread over the processes
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
 
-void Graph::readDotFormat(const string& filename, const int& global_size)
+template <typename Index>
+void BasicGraph<Index>::readDotFormat(const string& filename,
+                                      const Index& global_size)
+{
+    global_size_ = global_size;
+    rank_ = world.rank();
+
+    long long procs = world.size();
+    global_rank_map.resize(global_size);
+    for (Index vertex = 0; vertex < global_size; vertex++) {
+        global_rank_map[vertex] = vertex * procs / global_size;
+    }
+    readOwnedEdges(filename);
+}
+
+/**
+ * @brief Balanced assignment: Split the vertices into contiguous ranges with
+ * equal number of non-zeros (vertices + edges) using the prefix sum of the
+ * degrees, such that each process does the same amount of work in SpMV
+ * @param FILL-ME-IN
+ * @return FILL-ME-IN
+ */
+
+template <typename Index>
+void BasicGraph<Index>::readDotFormatBalanced(const string& filename,
+                                              const Index& global_size)
 {
     ifstream In(filename);
     if (!In.is_open()) {
         std::cerr << "ERROR: Can't open the file" << endl;
         exit(-1);
     }
-    int from, to, local_index = 0;
+    global_size_ = global_size;
+    rank_ = world.rank();
+
+    // First pass: count the degree of each vertex
+    std::vector<Index> degree(global_size, 0);
+    Index from, to;
     In.ignore(INT_MAX, '{');  // Ignore the chars before the value of colour
     In >> from;               // the first vertex
     In.ignore(INT_MAX, '-');
@@ -244,35 +402,139 @@ void Graph::readDotFormat(const string& filename, const int& global_size)
     In.ignore(INT_MAX,
               '\n');  // Ignore other chars before end of line, go to next line
 
-    global_size_ = global_size;
-    local_size_ = global_size / world.size();
-    rank_ = world.rank();
-    global_index_.resize(local_size_, 0);
-    local_index_.resize(global_size, 0);
-
     while (In.good()) {
-        if (from >= rank_ * local_size_ &&
-            from <= (rank_ + 1) * local_size_ - 1) {
-            addEdge(from, to);
-            global_index_[local_index] = from;
-            local_index_[from] = local_index;
-            In >> from;
-            if (from != global_index_[local_index]) {
-                local_index++;
+        for (const Index& vertex : {from, to}) {
+            if (vertex < 0 || vertex >= global_size) {
+                std::cerr << "ERROR: Vertex " << vertex
+                          << " is out of range of the number of vertices"
+                          << endl;
+                exit(-1);
             }
-            In.ignore(2);  // Ignore "--"
-            In >> to;
-            In.ignore(INT_MAX, '\n');
-        } else {
-            In >> from;
-            In.ignore(2);  // Ignore "--"
-            In >> to;
-            In.ignore(INT_MAX, '\n');
-            // if (from > (rank_ + 1) * local_size_ - 1) break;
+        }
+        degree[from]++;
+        In >> from;
+        In.ignore(2);  // Ignore "--"
+        In >> to;
+        In.ignore(INT_MAX, '\n');
+    }
+    In.close();
+
+    // Cut the prefix sum of (1 + degree) into world.size() equal pieces
+    long long procs = world.size(), nnz = 0, prefix = 0;
+    for (const Index& d : degree) {
+        nnz += 1 + d;
+    }
+    global_rank_map.resize(global_size);
+    for (Index vertex = 0; vertex < global_size; vertex++) {
+        global_rank_map[vertex] = prefix * procs / nnz;
+        prefix += 1 + degree[vertex];
+    }
+    readOwnedEdges(filename);
+}
+
+/**
+ * @brief Build the local/global index of the vertices owned by this process
+ * according to global_rank_map, the vertices start without edges
+ */
+
+template <typename Index>
+void BasicGraph<Index>::indexOwnedVertices()
+{
+    local_size_ = 0;
+    global_index_.clear();
+    local_index_.assign(global_size_, 0);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        if (global_rank_map[vertex] == rank_) {
+            global_index_.push_back(vertex);
+            local_index_[vertex] = local_size_;
+            G.insert({vertex, SetOfNeighbours()});  // Keep isolated vertices
+            local_size_++;
         }
     }
-    for (int i = 0; i < global_size; i++) {
-        global_rank_map.push_back(i / local_size_);
+}
+
+/**
+ * @brief Generate a random graph over the processes without any file, the
+ * vertices are assigned evenly as readDotFormat does. Each process
+ * generates its slice of the edges and sends both directions of them to
+ * the owners of the sources.
+ * @param generator The model, size and seed of the graph
+ * @param threads Number of threads to generate the slice with
+ */
+
+template <typename Index>
+void BasicGraph<Index>::generate(const Generator& generator, const int& threads)
+{
+    if (generator.vertices() > numeric_limits<Index>::max()) {
+        throw out_of_range("Too many vertices for the graph");
+    }
+    global_size_ = generator.vertices();
+    rank_ = world.rank();
+    G.clear();
+    Colour.clear();
+    Weight.clear();
+    original_index_.clear();
+
+    long long procs = world.size();
+    global_rank_map.resize(global_size_);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        global_rank_map[vertex] = vertex * procs / global_size_;
+    }
+    indexOwnedVertices();
+
+    vector<vector<pair<Index, Index>>> send(procs), recv;
+    {
+        Generator::Edges edges = generator.edges(rank_, procs, threads);
+        for (const auto& edge : edges) {
+            send[global_rank_map[edge.first]].emplace_back(edge.first,
+                                                           edge.second);
+            send[global_rank_map[edge.second]].emplace_back(edge.second,
+                                                            edge.first);
+        }
+    }
+    mpi::all_to_all(world, send, recv);
+    vector<vector<pair<Index, Index>>>().swap(send);
+    for (const auto& edges : recv) {
+        for (const auto& edge : edges) {
+            addEdge(edge.first, edge.second);
+        }
+    }
+}
+
+/**
+ * @brief Build the local/global index of the vertices owned by this process
+ * according to global_rank_map, and load their edges from Dot file
+ * @param FILL-ME-IN
+ * @return FILL-ME-IN
+ */
+
+template <typename Index>
+void BasicGraph<Index>::readOwnedEdges(const string& filename)
+{
+    ifstream In(filename);
+    if (!In.is_open()) {
+        std::cerr << "ERROR: Can't open the file" << endl;
+        exit(-1);
+    }
+    indexOwnedVertices();
+
+    Index from, to;
+    In.ignore(INT_MAX, '{');  // Ignore the chars before the value of colour
+    In >> from;               // the first vertex
+    In.ignore(INT_MAX, '-');
+    In.ignore(1);  // Skip the second '-'
+    In >> to;
+    double weight = readWeight(In);  // The rest of the line
+
+    while (In.good()) {
+        if (from >= 0 && from < global_size_ &&
+            global_rank_map[from] == rank_) {
+            addEdge(from, to, weight);
+        }
+        In >> from;
+        In.ignore(2);  // Ignore "--"
+        In >> to;
+        weight = readWeight(In);
     }
     In.close();
 }
@@ -283,17 +545,19 @@ void Graph::readDotFormat(const string& filename, const int& global_size)
  * @return FILL-ME-IN
  */
 
-void Graph::readDotFormatWithColour(const string& filename)
+template <typename Index>
+void BasicGraph<Index>::readDotFormatWithColour(const string& filename)
 {
     ifstream In(filename);
     if (!In.is_open()) {
         std::cerr << "ERROR: Can't open the file" << endl;
         exit(-1);
     }
-    int vertex, colour;
+    Index vertex;
+    int colour;
     In.ignore(INT_MAX, '{');  // Ignore the chars before the value of colour
     In >> vertex;
-    int first_vertex = vertex;
+    Index first_vertex = vertex;
     In.ignore(INT_MAX, '=');  // Ignore the chars before the value of colour
     In >> colour;
     In.ignore(INT_MAX,
@@ -310,16 +574,16 @@ void Graph::readDotFormatWithColour(const string& filename)
         In >> colour;
         In.ignore(INT_MAX, '\n');
     }
-    int from = first_vertex, to;
+    Index from = first_vertex, to;
     In.ignore(2);  // Ignore "--"
     In >> to;
-    In.ignore(INT_MAX, '\n');
+    double weight = readWeight(In);
     while (In.good()) {
-        addEdge(from, to);
+        addEdge(from, to, weight);
         In >> from;
         In.ignore(2);  // Ignore "--"
         In >> to;
-        In.ignore(INT_MAX, '\n');
+        weight = readWeight(In);
     }
     In.close();
 }
@@ -331,8 +595,9 @@ void Graph::readDotFormatWithColour(const string& filename)
  * @return FILL-ME-IN
  */
 
-void Graph::readDotFormatByColour(const string& filename,
-                                  const int& global_size)
+template <typename Index>
+void BasicGraph<Index>::readDotFormatByColour(const string& filename,
+                                              const Index& global_size)
 {
     ifstream In(filename);
     if (!In.is_open()) {
@@ -340,15 +605,16 @@ void Graph::readDotFormatByColour(const string& filename,
         exit(-1);
     }
     In.ignore(INT_MAX, '{');  // Ignore the chars before the value of colour
-    int vertex, colour;
+    Index vertex;
+    int colour;
     In >> vertex;
-    int first_vertex = vertex;
+    Index first_vertex = vertex;
     In.ignore(INT_MAX, '=');  // Ignore the chars before the value of colour
     In >> colour;
     In.ignore(INT_MAX,
               '\n');  // Ignore other chars before end of line, go to next line
 
-    unordered_set<int> vertex_set;  // vertices with same colour
+    unordered_set<Index> vertex_set;  // vertices with same colour
     global_size_ = global_size;
     local_size_ = 0;
     rank_ = world.rank();
@@ -369,23 +635,706 @@ void Graph::readDotFormatByColour(const string& filename,
         In >> colour;
         In.ignore(INT_MAX, '\n');
     }
-    int from = first_vertex, to;
+    Index from = first_vertex, to;
     In.ignore(2);  // Ignore "--"
     In >> to;
-    In.ignore(INT_MAX, '\n');
+    double weight = readWeight(In);
     while (In.good()) {
         if (vertex_set.find(from) != vertex_set.end()) {
-            addEdge(from, to);
+            addEdge(from, to, weight);
         }
         In >> from;
         In.ignore(2);  // Ignore "--"
         In >> to;
-        In.ignore(INT_MAX, '\n');
+        weight = readWeight(In);
     }
     In.close();
-    if (local_size_ == 0) {
-        std::cerr << "ERROR: Number of processes and colours should match."
-                  << endl;
+    for (const int& rank : global_rank_map) {
+        if (rank < 0 || rank >= world.size()) {
+            std::cerr << "ERROR: Number of processes is less than colours."
+                      << endl;
+            exit(-1);
+        }
+    }
+}
+
+/**
+ * @brief Dynamic load balancing: Migrate the vertices and their edges between
+ * processes, such that each process has nearly the same number of non-zeros
+ * (vertices + edges). The order of the vertices across the processes is kept,
+ * so the vertices with the same colour stay together and a large colour is
+ * spread over the consecutive processes.
+ * @param tolerance Only migrate if max/average of non-zeros exceeds it
+ * @return True if the vertices have been migrated
+ */
+
+template <typename Index>
+bool BasicGraph<Index>::rebalance(const double& tolerance)
+{
+    int procs = world.size();
+    std::vector<Index> local_cost(local_size_);
+    long long local_nnz = 0, max_nnz = 0, global_nnz = 0;
+    for (Index i = 0; i < local_size_; i++) {
+        local_cost[i] = 1 + G.at(global_index_[i]).size();
+        local_nnz += local_cost[i];
+    }
+    mpi::all_reduce(world, local_nnz, max_nnz, mpi::maximum<long long>());
+    mpi::all_reduce(world, local_nnz, global_nnz, std::plus<long long>());
+    if (global_nnz == 0 || max_nnz * procs <= tolerance * global_nnz) {
+        return false;
+    }
+
+    // Cut the prefix sum of the costs in the current order into equal pieces
+    std::vector<std::vector<Index>> all_vertices, all_costs;
+    mpi::all_gather(world, global_index_, all_vertices);
+    mpi::all_gather(world, local_cost, all_costs);
+    std::vector<int> new_rank_map(global_size_, 0);
+    long long prefix = 0;
+    for (int rank = 0; rank < procs; rank++) {
+        for (unsigned int i = 0; i < all_vertices[rank].size(); i++) {
+            new_rank_map[all_vertices[rank][i]] = prefix * procs / global_nnz;
+            prefix += all_costs[rank][i];
+        }
+    }
+
+    // Pack <vertex, colour, degree, neighbours...> for the leaving vertices,
+    // and <edge key, weight> of their weighted edges
+    std::vector<std::vector<Index>> buf_send(procs), buf_recv(procs);
+    std::vector<std::vector<std::pair<EdgeKey, double>>> weight_send(procs),
+        weight_recv(procs);
+    for (const Index& vertex : global_index_) {
+        int dest = new_rank_map[vertex];
+        if (dest == rank_) continue;
+        auto it = G.find(vertex);
+        auto colour_it = Colour.find(vertex);
+        buf_send[dest].push_back(vertex);
+        buf_send[dest].push_back(colour_it != Colour.end() ? colour_it->second
+                                                           : -1);
+        buf_send[dest].push_back(it->second.size());
+        for (const Index& neighbour : it->second) {
+            buf_send[dest].push_back(neighbour);
+            double weight = getWeight(vertex, neighbour);
+            if (weight != 1.0) {
+                weight_send[dest].push_back(
+                    {edgeKey(vertex, neighbour), weight});
+            }
+        }
+        G.erase(it);
+        if (colour_it != Colour.end()) Colour.erase(colour_it);
+    }
+    mpi::all_to_all(world, buf_send, buf_recv);
+    mpi::all_to_all(world, weight_send, weight_recv);
+    for (const auto& buf : weight_recv) {
+        Weight.insert(buf.begin(), buf.end());
+    }
+
+    // Unpack the arriving vertices
+    for (const auto& buf : buf_recv) {
+        unsigned int i = 0;
+        while (i < buf.size()) {
+            Index vertex = buf[i], colour = buf[i + 1], degree = buf[i + 2];
+            SetOfNeighbours neighbours(buf.begin() + i + 3,
+                                       buf.begin() + i + 3 + degree);
+            G[vertex] = neighbours;
+            if (colour >= 0) setColour(vertex, colour);
+            i += 3 + degree;
+        }
+    }
+
+    // Rebuild the local/global index in the kept order
+    global_rank_map = new_rank_map;
+    global_index_.clear();
+    local_size_ = 0;
+    for (int rank = 0; rank < procs; rank++) {
+        for (const Index& vertex : all_vertices[rank]) {
+            if (global_rank_map[vertex] == rank_) {
+                global_index_.push_back(vertex);
+                local_index_[vertex] = local_size_;
+                local_size_++;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Relabel the vertices to improve the locality of the neighbours, then
+ * load the equal number of vertices to each process by the new indices. Every
+ * process gathers the whole graph to compute the same ordering, so each holds
+ * O(edges) memory meanwhile. The colours and the distribution of the reading
+ * are dropped, the input indices are kept for restoreOrder.
+ * @param ordering "rcm", "bfs" or "degree"
+ */
+
+template <typename Index>
+void BasicGraph<Index>::reorder(const string& ordering)
+{
+    std::vector<Index> local_adjacency;  // <vertex, degree, neighbours...>
+    for (const auto& it : G) {
+        local_adjacency.push_back(it.first);
+        local_adjacency.push_back(it.second.size());
+        local_adjacency.insert(local_adjacency.end(), it.second.cbegin(),
+                               it.second.cend());
+    }
+    std::vector<std::vector<Index>> all_adjacency;
+    mpi::all_gather(world, local_adjacency, all_adjacency);
+    local_adjacency.clear();
+    std::vector<std::pair<EdgeKey, double>> local_weights(Weight.begin(),
+                                                          Weight.end());
+    std::vector<std::vector<std::pair<EdgeKey, double>>> all_weights;
+    mpi::all_gather(world, local_weights, all_weights);
+
+    std::vector<std::vector<Index>> adjacency(global_size_);
+    for (const auto& buf : all_adjacency) {
+        unsigned int i = 0;
+        while (i < buf.size()) {
+            Index vertex = buf[i], degree = buf[i + 1];
+            adjacency[vertex].assign(buf.begin() + i + 2,
+                                     buf.begin() + i + 2 + degree);
+            i += 2 + degree;
+        }
+    }
+    all_adjacency.clear();
+    // Neighbours are gathered from unordered sets, sort them to get the same
+    // ordering on every process
+    for (auto& neighbours : adjacency) {
+        sort(neighbours.begin(), neighbours.end());
+    }
+
+    std::vector<Index> order = vertexOrdering(ordering, adjacency);
+    std::vector<Index> new_index(global_size_);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        new_index[order[vertex]] = vertex;
+    }
+
+    long long procs = world.size();
+    G.clear();
+    Colour.clear();
+    global_index_.clear();
+    local_size_ = 0;
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        global_rank_map[vertex] = vertex * procs / global_size_;
+        if (global_rank_map[vertex] != rank_) continue;
+        SetOfNeighbours& neighbours = G[vertex];
+        for (const Index& neighbour : adjacency[order[vertex]]) {
+            neighbours.insert(new_index[neighbour]);
+        }
+        global_index_.push_back(vertex);
+        local_index_[vertex] = local_size_;
+        local_size_++;
+    }
+    Weight.clear();
+    for (const auto& weights : all_weights) {
+        for (const auto& it : weights) {
+            Index src = new_index[it.first.first];
+            Index dest = new_index[it.first.second];
+            if (global_rank_map[src] == rank_ ||
+                global_rank_map[dest] == rank_) {
+                Weight[edgeKey(src, dest)] = it.second;
+            }
+        }
+    }
+
+    if (!original_index_.empty()) {
+        for (auto& x : order) {
+            x = original_index_[x];
+        }
+    }
+    original_index_ = order;
+}
+
+/**
+ * @brief Map the vertices and colours back to the indices in the input
+ */
+
+template <typename Index>
+void BasicGraph<Index>::restoreOrder()
+{
+    if (original_index_.empty()) return;
+    const std::vector<Index>& new_index = original_index_;
+
+    unordered_map<Index, SetOfNeighbours> relabelled;
+    for (const auto& it : G) {
+        SetOfNeighbours& neighbours = relabelled[new_index[it.first]];
+        for (const Index& neighbour : it.second) {
+            neighbours.insert(new_index[neighbour]);
+        }
+    }
+    G.swap(relabelled);
+
+    unordered_map<Index, int> colour;
+    for (const auto& it : Colour) {
+        colour.insert({new_index[it.first], it.second});
+    }
+    Colour.swap(colour);
+
+    unordered_map<EdgeKey, double, EdgeHash> weight;
+    for (const auto& it : Weight) {
+        weight.insert({edgeKey(new_index[it.first.first],
+                               new_index[it.first.second]),
+                       it.second});
+    }
+    Weight.swap(weight);
+
+    std::vector<int> rank_map(global_size_);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        rank_map[new_index[vertex]] = global_rank_map[vertex];
+    }
+    global_rank_map.swap(rank_map);
+    for (unsigned int i = 0; i < global_index_.size(); i++) {
+        global_index_[i] = new_index[global_index_[i]];
+        local_index_[global_index_[i]] = i;
+    }
+    original_index_.clear();
+}
+
+/**
+ * @brief Union-find over the processes with pointer jumping (FastSV). Each
+ *        vertex points to a smaller vertex of its component, the local
+ *        edges are united first so a component within a process starts as
+ *        one tree. Each round fetches the grandparents from their owners,
+ *        hooks the tree of each vertex onto the smallest grandparent of its
+ *        neighbours and shortcuts every vertex to its grandparent, until no
+ *        grandparent changes. O(log n) rounds of O(nnz) each instead of one
+ *        round per hop of the longest path.
+ * @return component[local index] = smallest global index in its connected
+ *         component
+ */
+
+template <typename Index>
+vector<Index> BasicGraph<Index>::components() const
+{
+    int procs = world.size();
+    vector<Index> parent(local_size_);
+    for (Index i = 0; i < local_size_; i++) {
+        parent[i] = i;
+    }
+    auto find = [&parent](Index i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];  // Path halving
+            i = parent[i];
+        }
+        return i;
+    };
+    // Vertices to send to and halo vertices to receive from each process, in
+    // increasing order on both sides
+    vector<std::set<Index>> send_set(procs), recv_set(procs);
+    for (const auto& it : G) {
+        for (const Index& neighbour : it.second) {
+            int rank = global_rank_map[neighbour];
+            if (rank != rank_) {
+                send_set[rank].insert(it.first);
+                recv_set[rank].insert(neighbour);
+                continue;
+            }
+            Index a = find(local_index_[it.first]);
+            Index b = find(local_index_[neighbour]);
+            if (global_index_[a] < global_index_[b]) {
+                parent[b] = a;
+            } else if (global_index_[b] < global_index_[a]) {
+                parent[a] = b;
+            }
+        }
+    }
+    vector<Index> label(local_size_);  // The parent as a global index
+    for (Index i = 0; i < local_size_; i++) {
+        label[i] = global_index_[find(i)];
+    }
+
+    // The labels of the given vertices, asked from their owners
+    auto fetch = [&](const vector<Index>& vertices) {
+        vector<Index> asked(vertices);
+        sort(asked.begin(), asked.end());
+        asked.erase(unique(asked.begin(), asked.end()), asked.end());
+        vector<vector<Index>> ask(procs), requested, answer(procs), answered;
+        for (const Index& vertex : asked) {
+            ask[global_rank_map[vertex]].push_back(vertex);
+        }
+        mpi::all_to_all(world, ask, requested);
+        for (int rank = 0; rank < procs; rank++) {
+            for (const Index& vertex : requested[rank]) {
+                answer[rank].push_back(label[local_index_[vertex]]);
+            }
+        }
+        mpi::all_to_all(world, answer, answered);
+        unordered_map<Index, Index> value(asked.size());
+        for (int rank = 0; rank < procs; rank++) {
+            for (unsigned int i = 0; i < ask[rank].size(); i++) {
+                value[ask[rank][i]] = answered[rank][i];
+            }
+        }
+        vector<Index> labels(vertices.size());
+        for (unsigned int i = 0; i < vertices.size(); i++) {
+            labels[i] = value[vertices[i]];
+        }
+        return labels;
+    };
+
+    vector<Index> grandparent(local_size_, -1);
+    unordered_map<Index, Index> halo;  // Grandparents of the halo vertices
+    vector<vector<Index>> buf_send(procs), buf_recv(procs);
+    bool changed = true;
+    while (changed) {
+        vector<Index> next = fetch(label);
+        bool local_changed = next != grandparent;
+        grandparent.swap(next);
+
+        vector<mpi::request> reqs;
+        for (int rank = 0; rank < procs; rank++) {
+            if (!send_set[rank].empty()) {
+                buf_send[rank].clear();
+                for (const Index& vertex : send_set[rank]) {
+                    buf_send[rank].push_back(
+                        grandparent[local_index_[vertex]]);
+                }
+                reqs.push_back(world.isend(rank, 0, buf_send[rank]));
+            }
+            if (!recv_set[rank].empty()) {
+                reqs.push_back(world.irecv(rank, 0, buf_recv[rank]));
+            }
+        }
+        mpi::wait_all(reqs.begin(), reqs.end());
+        for (int rank = 0; rank < procs; rank++) {
+            int i = 0;
+            for (const Index& vertex : recv_set[rank]) {
+                halo[vertex] = buf_recv[rank][i++];
+            }
+        }
+
+        // Hook the trees onto the smallest grandparent of a neighbour, the
+        // parent of a vertex may be owned by another process
+        vector<Index> hooked(label);
+        unordered_map<Index, Index> hooks;  // <parent, smallest grandparent>
+        for (const auto& it : G) {
+            Index i = local_index_[it.first];
+            Index smallest = grandparent[i];
+            for (const Index& neighbour : it.second) {
+                Index other = global_rank_map[neighbour] == rank_
+                                ? grandparent[local_index_[neighbour]]
+                                : halo.at(neighbour);
+                smallest = min(smallest, other);
+            }
+            hooked[i] = min(hooked[i], smallest);  // Also shortcuts
+            if (smallest < grandparent[i]) {
+                auto hook = hooks.find(label[i]);
+                if (hook == hooks.end()) {
+                    hooks.insert({label[i], smallest});
+                } else {
+                    hook->second = min(hook->second, smallest);
+                }
+            }
+        }
+        vector<vector<Index>> hook_send(procs), hook_recv;  // <parent, label>
+        for (const auto& it : hooks) {
+            hook_send[global_rank_map[it.first]].push_back(it.first);
+            hook_send[global_rank_map[it.first]].push_back(it.second);
+        }
+        mpi::all_to_all(world, hook_send, hook_recv);
+        for (const auto& buf : hook_recv) {
+            for (unsigned int i = 0; i < buf.size(); i += 2) {
+                Index& target = hooked[local_index_[buf[i]]];
+                target = min(target, buf[i + 1]);
+            }
+        }
+        local_changed = local_changed || hooked != label;
+        label.swap(hooked);
+        mpi::all_reduce(world, local_changed, changed, std::logical_or<bool>());
+    }
+    return label;
+}
+
+template <typename Index>
+map<Index, Index> BasicGraph<Index>::globalCounts(
+    const vector<Index>& label) const
+{
+    map<Index, Index> local_counts, counts;
+    for (const Index& l : label) {
+        local_counts[l]++;
+    }
+    vector<Index> flat;  // <label, count> pairs
+    for (const auto& it : local_counts) {
+        flat.push_back(it.first);
+        flat.push_back(it.second);
+    }
+    vector<vector<Index>> all_flat;
+    mpi::all_gather(world, flat, all_flat);
+    for (const auto& buf : all_flat) {
+        for (unsigned int i = 0; i < buf.size(); i += 2) {
+            counts[buf[i]] += buf[i + 1];
+        }
+    }
+    return counts;
+}
+
+/**
+ * @brief Copy the vertices and the edges between them with their weights,
+ *        the colours are not copied. Every process has to call it.
+ * @param vertices Local indices of the vertices to keep on this process
+ */
+
+template <typename Index>
+BasicGraph<Index> BasicGraph<Index>::subgraph(
+    const vector<Index>& vertices) const
+{
+    vector<Index> counts;
+    mpi::all_gather(world, (Index)vertices.size(), counts);
+    Index offset = 0, sub_size = 0;
+    for (int rank = 0; rank < (int)counts.size(); rank++) {
+        if (rank < rank_) offset += counts[rank];
+        sub_size += counts[rank];
+    }
+
+    // new_index[old global index] = new global index, or -1
+    vector<Index> local_new(global_size_, -1), new_index(global_size_);
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        local_new[global_index_[vertices[i]]] = offset + i;
+    }
+    mpi::all_reduce(world, local_new.data(), global_size_, new_index.data(),
+                    mpi::maximum<Index>());
+
+    BasicGraph sub;
+    sub.rank_ = rank_;
+    sub.global_size_ = sub_size;
+    sub.local_size_ = vertices.size();
+    sub.global_rank_map.assign(sub_size, 0);
+    sub.local_index_.assign(sub_size, 0);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        if (new_index[vertex] >= 0) {
+            sub.global_rank_map[new_index[vertex]] = global_rank_map[vertex];
+        }
+    }
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        Index vertex = global_index_[vertices[i]];
+        sub.global_index_.push_back(offset + i);
+        sub.local_index_[offset + i] = i;
+        SetOfNeighbours& neighbours = sub.G[offset + i];
+        for (const Index& neighbour : G.at(vertex)) {
+            if (new_index[neighbour] >= 0) {
+                neighbours.insert(new_index[neighbour]);
+                double weight = getWeight(vertex, neighbour);
+                if (weight != 1.0) {
+                    sub.Weight[edgeKey(offset + i, new_index[neighbour])] =
+                        weight;
+                }
+            }
+        }
+    }
+    return sub;
+}
+
+/**
+ * @brief Write vectors over the vertices, one line per vertex with its index
+ *        in the input and its entry of each vector, e.g. the eigenvectors to
+ *        warm start the next run. The lines are gathered and written by
+ *        rank 0, every process has to call it.
+ * @param filename The file to write
+ * @param vectors vectors[r][local index]
+ */
+
+template <typename Index>
+void BasicGraph<Index>::outputVectors(const string& filename,
+                          const vector<vector<double>>& vectors) const
+{
+    vector<double> flat;  // <input index, entries> of each local vertex
+    for (Index i = 0; i < local_size_; i++) {
+        Index vertex = global_index_[i];
+        flat.push_back(original_index_.empty() ? vertex
+                                               : original_index_[vertex]);
+        for (const auto& v : vectors) {
+            flat.push_back(v[i]);
+        }
+    }
+    vector<vector<double>> all_flat;
+    mpi::gather(world, flat, all_flat, 0);
+    if (rank_ != 0) {
+        return;
+    }
+    ofstream Output(filename, ios::out | ios::trunc);
+    Output.precision(17);
+    const int width = vectors.size() + 1;
+    for (const auto& buf : all_flat) {
+        for (unsigned int i = 0; i < buf.size(); i += width) {
+            Output << static_cast<Index>(buf[i]);
+            for (int r = 1; r < width; r++) {
+                Output << " " << buf[i + r];
+            }
+            Output << endl;
+        }
+    }
+}
+
+/**
+ * @brief Every process reads the whole file of outputVectors and keeps its
+ *        own vertices, the input indices are mapped to the vertices after
+ *        reordering
+ * @param filename The file to read
+ * @return vectors[r][local index], 0 for the vertices not in the file
+ */
+
+template <typename Index>
+vector<vector<double>> BasicGraph<Index>::readVectors(const string& filename) const
+{
+    ifstream In(filename);
+    if (!In.is_open()) {
+        std::cerr << "ERROR: Can't open the file" << endl;
+        exit(-1);
+    }
+    vector<Index> current(global_size_);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        current[original_index_.empty() ? vertex : original_index_[vertex]] =
+            vertex;
+    }
+    vector<vector<double>> vectors;
+    string line;
+    while (getline(In, line)) {
+        istringstream entries(line);
+        Index input;
+        double entry;
+        if (!(entries >> input) || input < 0 || input >= global_size_) {
+            continue;
+        }
+        Index vertex = current[input];
+        bool own = global_rank_map[vertex] == rank_;
+        for (unsigned int r = 0; entries >> entry; r++) {
+            if (r == vectors.size()) {
+                vectors.emplace_back(local_size_, 0.0);
+            }
+            if (own) {
+                vectors[r][local_index_[vertex]] = entry;
+            }
+        }
+    }
+    return vectors;
+}
+
+/**
+ * @brief Every process reads the colours of its own vertices from a dot
+ *        file written by outputDotFormat, the input indices are mapped to
+ *        the vertices after reordering
+ * @param filename The file to read
+ * @return colour[local index], -1 for the vertices without a colour
+ */
+
+template <typename Index>
+vector<int> BasicGraph<Index>::readColours(const string& filename) const
+{
+    ifstream In(filename);
+    if (!In.is_open()) {
+        std::cerr << "ERROR: Can't open the file" << endl;
         exit(-1);
     }
+    vector<Index> current(global_size_);
+    for (Index vertex = 0; vertex < global_size_; vertex++) {
+        current[original_index_.empty() ? vertex : original_index_[vertex]] =
+            vertex;
+    }
+    vector<int> colours(local_size_, -1);
+    string line;
+    while (getline(In, line)) {
+        size_t at = line.find("[C=");
+        if (at == string::npos) {
+            continue;
+        }
+        int64_t input = stoll(line.substr(0, at));
+        if (input < 0 || input >= global_size_) {
+            continue;
+        }
+        Index vertex = current[input];
+        if (global_rank_map[vertex] == rank_) {
+            colours[local_index_[vertex]] = stoi(line.substr(at + 3));
+        }
+    }
+    return colours;
 }
+
+/**
+ * @brief Insert a batch of edges, each process adds the ends it owns, the
+ *        vertices have to exist already
+ * @param edges <src, dest> pairs, the same on every process
+ */
+
+template <typename Index>
+void BasicGraph<Index>::insertEdges(const vector<pair<Index, Index>>& edges)
+{
+    for (const auto& edge : edges) {
+        if (edge.first < 0 || edge.first >= global_size_ ||
+            edge.second < 0 || edge.second >= global_size_) {
+            throw out_of_range("Edge " + to_string(edge.first) + "--" +
+                               to_string(edge.second) + " is not in the graph");
+        }
+        if (global_rank_map[edge.first] == rank_) {
+            addEdge(edge.first, edge.second);
+        }
+        if (global_rank_map[edge.second] == rank_) {
+            addEdge(edge.second, edge.first);
+        }
+    }
+}
+
+/**
+ * @brief Remove a batch of edges, each process removes the ends it owns
+ * @param edges <src, dest> pairs, the same on every process
+ */
+
+template <typename Index>
+void BasicGraph<Index>::removeEdges(const vector<pair<Index, Index>>& edges)
+{
+    for (const auto& edge : edges) {
+        if (edge.first < 0 || edge.first >= global_size_ ||
+            edge.second < 0 || edge.second >= global_size_) {
+            throw out_of_range("Edge " + to_string(edge.first) + "--" +
+                               to_string(edge.second) + " is not in the graph");
+        }
+        if (global_rank_map[edge.first] == rank_) {
+            G[edge.first].erase(edge.second);
+        }
+        if (global_rank_map[edge.second] == rank_) {
+            G[edge.second].erase(edge.first);
+        }
+        Weight.erase(edgeKey(edge.first, edge.second));
+    }
+}
+
+/**
+ * @brief Send the colours of the boundary vertices to the processes that
+ *        have them as halo vertices, in increasing order on both sides
+ */
+
+template <typename Index>
+void BasicGraph<Index>::updateHaloColours() const
+{
+    int procs = world.size();
+    vector<std::set<Index>> send_set(procs), recv_set(procs);
+    for (const auto& it : G) {
+        for (const Index& neighbour : it.second) {
+            int rank = global_rank_map[neighbour];
+            if (rank != rank_) {
+                send_set[rank].insert(it.first);
+                recv_set[rank].insert(neighbour);
+            }
+        }
+    }
+    vector<vector<int>> buf_send(procs), buf_recv(procs);
+    vector<mpi::request> reqs;
+    for (int rank = 0; rank < procs; rank++) {
+        if (!send_set[rank].empty()) {
+            for (const Index& vertex : send_set[rank]) {
+                buf_send[rank].push_back(getColour(vertex));
+            }
+            reqs.push_back(world.isend(rank, 0, buf_send[rank]));
+        }
+        if (!recv_set[rank].empty()) {
+            reqs.push_back(world.irecv(rank, 0, buf_recv[rank]));
+        }
+    }
+    mpi::wait_all(reqs.begin(), reqs.end());
+    for (int rank = 0; rank < procs; rank++) {
+        int i = 0;
+        for (const Index& vertex : recv_set[rank]) {
+            Colour[vertex] = buf_recv[rank][i++];
+        }
+    }
+}
+
+template class BasicGraph<int32_t>;
+template class BasicGraph<int64_t>;
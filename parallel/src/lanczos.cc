@@ -8,15 +8,22 @@
 #define LANCZOS_CC_
 
 #include "lanczos.h"
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <exception>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <random>
-#include <set>
 #include <utility>
 
 #include <boost/serialization/serialization.hpp>
+#include "kernels.h"
+#include "reorthogonalisation.h"
+#include "timers.h"
+#include "tqli.h"
+#include "trace.h"
 #ifdef VT_
 #include "vt_user.h"
 #endif
@@ -26,7 +33,7 @@ using std::cout;
 using std::endl;
 
 /**
- * @brief Lanczos algorithm with selective orthogonalisation
+ * @brief Lanczos algorithm with partial reorthogonalisation
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
@@ -46,273 +53,445 @@ using std::endl;
  *represents a local lanczos vector
  *-----------------------------------------------------------------------------*/
 
-template <typename Vector, typename T>
-Lanczos<Vector, T>::Lanczos(const Graph& g_local, const int& num_of_eigenvec,
-                            bool SO)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+Lanczos<Vector, T, Basis, Operator, Index>::Lanczos(
+    const BasicGraph<Index>& g_local, const int& num_of_eigenvec, bool SO,
+    const std::string& spill_dir, const int& block, const int& filter_degree,
+    const std::vector<Vector>& start)
+    : reorthogonalisations(0),
+      block_size(std::max<Index>(
+          1, std::min<Index>(block, g_local.globalSize() - 1))),
+      converged(false)
 {
 #ifdef VT_
     VT_TRACER("Lanczos::Lanczos");
 #endif
-    int local_size = g_local.size();
-    int global_size = g_local.globalSize();
-    int m, t = 0;
-    double tol = 1e-6;
-    m = getIteration(num_of_eigenvec, global_size);
+    const Index global_size = g_local.globalSize();
+    // The constant vector is projected out, it leaves global_size - 1
+    // dimensions
+    int m = std::min<Index>(getIteration(num_of_eigenvec, global_size),
+                            global_size - 1);
+    m = std::max(m, 1);
+    Laplacian<Vector, T, Operator, Index> laplacian(g_local);
+    ChebyshevFilter<Vector, T, Operator, Index> filter(laplacian,
+                                                       filter_degree);
+    null_ = laplacian.nullVector();
+    if (block_size > 1) {
+        blockLanczos(g_local, laplacian, filter, num_of_eigenvec, m, SO,
+                     spill_dir, start);
+        return;
+    }
 
-    Vector v1_halo(global_size);
-    Vector v0_local = init(g_local);
+    // The Lanczos vectors are written in place into the basis, v0 and v1
+    // view its last two rows. A basis in lower precision stores copies of
+    // the two spare vectors instead, written in turn.
+    const int size = basisSize(g_local);
+    Vector spare[2];
+    spare[0] = start.empty() ? init(g_local) : init(start, g_local);
+    if (filter.degree() > 0) {
+        filter.apply(spare[0]);
+        deflate(spare[0]);
+        VectorOps<Vector, T>::scale(spare[0], spare[0],
+                                    1.0 / sqrt(dot(spare[0], spare[0])));
+    }
 
-    Vector v1_local = v0_local, w_local, v0_start = v0_local;
     T alpha_val_global = 0.0, beta_val_global = 0.0;
-
-    lanczos_vecs.resize(m);
-    lanczos_vecs[0] = v1_local;
-    haloInit(g_local);
-
-    for (int iter = 1; iter < m; iter++) {
-        haloUpdate(g_local, v1_local, v1_halo);
-        w_local = multGraphVec(g_local, v1_halo);
-        alpha_val_global = dot(v1_local, w_local);
+    const T breakdown = 1e-10 * laplacian.spectralBound();
+    PartialReorthogonalisation pro(
+        std::numeric_limits<typename Basis::value_type>::epsilon());
+    alpha.reserve(m);
+    beta.reserve(m);
+
+    lanczos_vecs.reserve(m, size, spill_dir);
+    T* next = nextVector(lanczos_vecs, spare[0]);
+    if (next != spare[0].data()) {
+        std::copy(spare[0].begin(), spare[0].end(), next);
+        Vector().swap(spare[0]);
+    } else {
+        spare[1].resize(size);
+    }
+    storeVector(lanczos_vecs, spare[0]);
+    BasisRow<T> v0_local(next, size), v1_local = v0_local;
+    Vector w_local(size);
+    std::vector<T> sums(2);
+
+    int iter = 1;
+    for (; iter < m; iter++) {
+        TRACE_SCOPE("lanczos_iteration");
+        laplacian.multiply(v1_local.data(), w_local.data());
+        // alpha and the sum of w in one reduction, the constant vector
+        // brought back by rounding errors is projected out of w
+        sums[0] = VectorOps<Vector, T>::dot(v1_local, w_local);
+        sums[1] = 0.0;
+        for (const auto& entry : w_local) {
+            sums[1] += entry;
+        }
+        reduce(sums);
+        for (auto& entry : w_local) {
+            entry -= sums[1] / global_size;
+        }
+        alpha_val_global = sums[0];
         alpha.push_back(alpha_val_global);
 
-        for (int i = 0; i < local_size; i++) {
-            w_local[i] = w_local[i] - alpha_val_global * v1_local[i] -
-                         beta_val_global * v0_local[i];
+        // w = w - alpha * v1 - beta * v0, fused with the local norm of w
+        T beta_val_local = VectorOps<Vector, T>::update(
+            w_local.data(), v1_local.data(), v0_local.data(),
+            alpha_val_global, beta_val_global, size);
+        {
+            Timers::Scope timer("reduce");
+            mpi::all_reduce(world, beta_val_local, beta_val_global,
+                            std::plus<T>());
         }
-        beta_val_global = sqrt(dot(w_local, w_local));
-        beta.push_back(beta_val_global);
-
-        for (int i = 0; i < local_size; i++) {
-            v1_local[i] = w_local[i] / beta_val_global;
+        beta_val_global = sqrt(beta_val_global);
+        if (SO) {
+            const std::vector<int>& against =
+                pro.next(alpha_val_global, beta_val_global);
+            if (!against.empty()) {
+                beta_val_global = reorthogonalise(against, w_local);
+                pro.orthogonalised(beta_val_global);
+            }
+        }
+        if (beta_val_global < breakdown) {  // An invariant subspace is found
+            break;
         }
-        if (SO && std::abs(dot(v0_start, v1_local)) >= tol) {
-            gramSchmidt(iter, v1_local);
-            t++;
+        // Check a warm start every iter / 10 steps, O(iter^2) each, alpha
+        // and beta are the same on every process
+        if (!start.empty() && iter >= num_of_eigenvec &&
+            iter % std::max(1, iter / 10) == 0 &&
+            ritzConverged(std::vector<double>(alpha.begin(), alpha.end()),
+                          std::vector<double>(beta.begin(), beta.end()),
+                          beta_val_global, num_of_eigenvec, 1e-6)) {
+            converged = true;
+            break;
         }
+        beta.push_back(beta_val_global);
 
-        lanczos_vecs[iter] = v1_local;
-        v0_local = lanczos_vecs[iter - 1];
+        Vector& buffer = spare[iter % 2];
+        next = nextVector(lanczos_vecs, buffer);
+        VectorOps<Vector, T>::scale(next, w_local.data(),
+                                    1.0 / beta_val_global, size);
+        storeVector(lanczos_vecs, buffer);
+        v0_local = v1_local;
+        v1_local = BasisRow<T>(next, size);
+    }
+    if (iter == m) {
+        laplacian.multiply(v1_local.data(), w_local.data());
+        alpha_val_global = dot(v1_local, w_local);
+        alpha.push_back(alpha_val_global);
     }
-    haloUpdate(g_local, v1_local, v1_halo);
-    w_local = multGraphVec(g_local, v1_halo);
-    alpha_val_global = dot(v1_local, w_local);
-    alpha.push_back(alpha_val_global);
 
+    reorthogonalisations = pro.steps();
     if (g_local.rank() == 0) {
-        cout << "number of iterations = " << m
-             << ", number of Orthogonalisation = " << t << endl;
+        cout << "number of iterations = " << iter
+             << ", number of Orthogonalisation = " << pro.steps()
+             << " (against " << pro.vectors() << " vectors)"
+             << (converged ? ", converged" : "") << endl;
     }
     if (SO && g_local.rank() == 0) {
-        cout << "Lanczos algorithm WITH Selective Orthogonalisation is done."
+        cout << "Lanczos algorithm WITH Partial Reorthogonalisation is done."
              << endl;
     } else if (g_local.rank() == 0) {
-        cout << "Lanczos algorithm WITHOUT Selective Orthogonalisation is done."
+        cout << "Lanczos algorithm WITHOUT Partial Reorthogonalisation is done."
              << endl;
     }
 }
 
 /**
- * @brief Calculate iterations for Lanczos algorithm
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @brief Block Lanczos, block_tri returns the block tridiagonal matrix with
+ *        the diagonal blocks A_j and subdiagonal blocks B_j of
+ *        L X_j = X_(j-1) B_(j-1)^T + X_j A_j + X_(j+1) B_j
+ * @param g The local graph
+ * @param laplacian The Laplacian matrix of g
+ * @param filter Chebyshev filter of the start block
+ * @param num_of_eigenvec Number of the Ritz pairs wanted
+ * @param m Number of Lanczos vectors, rounded up to a multiple of block_size
+ * @param SO Reorthogonalise each block against all the Lanczos vectors
+ * @param spill_dir Directory to keep the Lanczos vectors in, or empty
+ * @param start The first columns of the start block, stop once the Ritz
+ *        pairs have converged if not empty
  */
 
-template <typename Vector, typename T>
-const int Lanczos<Vector, T>::getIteration(const int& num_of_eigenvec,
-                                           const int& global_size)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::blockLanczos(
+    const BasicGraph<Index>& g,
+    Laplacian<Vector, T, Operator, Index>& laplacian,
+    ChebyshevFilter<Vector, T, Operator, Index>& filter,
+    const int& num_of_eigenvec, const int& m, bool SO,
+    const std::string& spill_dir, const std::vector<Vector>& start)
 {
-    int scale, m;
-    if (num_of_eigenvec == 1) {
-        scale = 4 * num_of_eigenvec;
-    } else if (num_of_eigenvec == 2) {
-        scale = 4 * (num_of_eigenvec - 1);
-    } else {
-        scale = num_of_eigenvec + 2;
+#ifdef VT_
+    VT_TRACER("Lanczos::blockLanczos");
+#endif
+    const int size = basisSize(g), b = block_size;
+    int steps = std::min<Index>((m + b - 1) / b, (g.globalSize() - 1) / b);
+    Vector x(size * b), x_prev, w, column;
+    for (int c = 0; c < b; c++) {
+        column = c < (int)start.size() ? start[c] : init(g);
+        for (int i = 0; i < size; i++) {
+            x[i * b + c] = column[i];
+        }
     }
-    if (round(log10(global_size)) > 3) {
-        scale -= round(log10(std::sqrt(global_size)));
-        scale = scale <= 0 ? 1 : scale;
+    lanczos_vecs.reserve(steps * b, size, spill_dir);
+    if (!start.empty()) {
+        deflate(x, b);
     }
-    m = scale * std::sqrt(global_size) < global_size
-            ? scale * std::sqrt(global_size)
-            : global_size;
-    return m;
-}
-
-/**
- * @brief Find out which rank and the corresponding data need to receive
- * @param FILL-ME-IN
- * @return FILL-ME-IN
- */
-
-template <typename Vector, typename T>
-void Lanczos<Vector, T>::haloInit(const Graph& g)
-{
-    // Find out which rank and the corresponding data need to receive
-    std::unordered_map<int, std::set<int>>
-        halo_recv_temp;  // <rank, halo_neighbours to receive>
-    std::unordered_map<int, std::set<int>>
-        halo_send_temp;  // <rank, halo_neighbours to send>
-    for (auto iter = g.cbegin(); iter != g.cend(); ++iter) {
-        if (!iter->second.empty()) {
-            for (const int& neighbour : iter->second) {
-                int rank = g.global_rank_map[neighbour];
-                if (rank != g.rank()) {
-                    auto it = halo_recv_temp.find(rank);
-                    if (it != halo_recv_temp.end()) {
-                        it->second.insert(neighbour);
-                    } else {
-                        std::set<int> halo_neighbours;
-                        halo_neighbours.insert(neighbour);
-                        halo_recv_temp.insert({rank, halo_neighbours});
-                    }
-                }
-                if (rank != g.rank()) {
-                    auto it = halo_send_temp.find(rank);
-                    if (it != halo_send_temp.end()) {
-                        it->second.insert(iter->first);
-                    } else {
-                        std::set<int> halo_neighbours;
-                        halo_neighbours.insert(iter->first);
-                        halo_send_temp.insert({rank, halo_neighbours});
-                    }
-                }
+    filter.apply(x, b);
+    orthonormalise(g, x);
+    storeBlock(x);
+
+    std::vector<T> beta_block;
+    block_tri.assign(steps * b, Vector(steps * b, 0.0));
+    for (int j = 0; j < steps; j++) {
+        TRACE_SCOPE("lanczos_iteration");
+        laplacian.multiply(x, w, b);
+        deflate(w, b);
+        if (j > 0) {
+            BlockOps<Vector, T>::subtract(w, x_prev, beta_block, b, true);
+        }
+        std::vector<T> alpha_block = BlockOps<Vector, T>::gram(x, w, b);
+        reduce(alpha_block);
+        BlockOps<Vector, T>::subtract(w, x, alpha_block, b, false);
+        for (int r = 0; r < b; r++) {
+            for (int c = 0; c < b; c++) {
+                block_tri[j * b + r][j * b + c] =
+                    0.5 * (alpha_block[r * b + c] + alpha_block[c * b + r]);
             }
         }
-    }
-    // Convert <int, set> to <int, vector> for efficient looking up in
-    // halo_update, cheaper than iterating a set.
-    for (auto& it : halo_send_temp) {
-        int rank = it.first;
-        std::vector<int> vector_send;
-        for (auto& x : it.second) {
-            vector_send.push_back(x);
+        if (j == steps - 1) {
+            break;
         }
-        halo_send.insert({rank, vector_send});
-    }
-    for (auto& it : halo_recv_temp) {
-        int rank = it.first;
-        std::vector<int> vector_recv;
-        for (auto& x : it.second) {
-            vector_recv.push_back(x);
+        if (SO) {
+            reorthogonaliseBlock(w);
+        }
+        beta_block = orthonormalise(g, w);
+        for (int r = 0; r < b; r++) {
+            for (int c = 0; c < b; c++) {
+                block_tri[(j + 1) * b + r][j * b + c] = beta_block[r * b + c];
+                block_tri[j * b + c][(j + 1) * b + r] = beta_block[r * b + c];
+            }
+        }
+        if (!start.empty() && (j + 1) * b >= num_of_eigenvec &&
+            (j + 1) % std::max(1, (j + 1) / 10) == 0 &&
+            blockRitzConverged(block_tri, (j + 1) * b, beta_block, b,
+                               num_of_eigenvec, 1e-6)) {
+            converged = true;
+            steps = j + 1;
+            break;
         }
-        halo_recv.insert({rank, vector_recv});
+        x_prev.swap(x);
+        x.swap(w);
+        storeBlock(x);
+    }
+    block_tri.resize(steps * b);
+    for (auto& row : block_tri) {
+        row.resize(steps * b);
+    }
+    if (g.rank() == 0) {
+        cout << "Block Lanczos algorithm (block size " << b << ") is done."
+             << endl;
+        cout << "number of iterations = " << steps
+             << ", number of Lanczos vectors = " << steps * b
+             << (converged ? ", converged" : "") << endl;
     }
 }
 
 /**
- * @brief Refresh the halo elements each iteration for Graph * Lanczos_Vec
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @brief QR factorisation of a block by Gram-Schmidt applied twice to each
+ *        column, a column in the span of the previous ones (e.g. an invariant
+ *        subspace is found) is replaced by a random orthogonal vector
+ * @param g The graph
+ * @param x The block, returns Q
+ * @return R, b * b row major
  */
 
-template <typename Vector, typename T>
-void Lanczos<Vector, T>::haloUpdate(const Graph& g, Vector& v_local,
-                                    Vector& v_halo)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+std::vector<T> Lanczos<Vector, T, Basis, Operator, Index>::orthonormalise(
+    const BasicGraph<Index>& g, Vector& x)
 {
-    // VT_TRACER("Lanczos::haloUpdate");
-    std::vector<mpi::request> reqs;
-    std::unordered_map<int, std::vector<T>> buf_send(
-        world.size());  // <global_index, value>;
-    std::unordered_map<int, std::vector<T>> buf_recv(world.size());
-
-    for (int rank = 0; rank < world.size(); rank++) {
-        if (rank != g.rank()) {
-            auto it = halo_send.find(rank);
-            if (it != halo_send.end()) {
-                std::vector<T> buf_temp;
-                for (const int& halo_neighbour : it->second) {
-                    buf_temp.push_back(v_local[g.localIndex(halo_neighbour)]);
+    const int b = block_size, size = x.size() / b;
+    std::vector<T> r(b * b, 0.0);
+    Vector column;
+    for (int c = 0; c < b; c++) {
+        BlockOps<Vector, T>::column(column, x, b, c);
+        T before = std::sqrt(dot(column, column));
+        for (int pass = 0; pass < 2; pass++) {
+            std::vector<T> d(c, 0.0);
+            for (int i = 0; i < size; i++) {
+                for (int k = 0; k < c; k++) {
+                    d[k] += x[i * b + k] * x[i * b + c];
                 }
-                buf_send.insert({rank, buf_temp});
-                reqs.push_back(world.isend(
-                    rank, 0, buf_send[rank]));  //(dest, tag, value to send)
             }
-        }
-    }
-    for (int rank = 0; rank < world.size(); rank++) {
-        if (rank != g.rank()) {
-            auto it = halo_recv.find(rank);
-            if (it != halo_recv.end()) {
-                reqs.push_back(world.irecv(
-                    rank, 0, buf_recv[rank]));  //(src, tag, store to value)
+            reduce(d);
+            for (int i = 0; i < size; i++) {
+                for (int k = 0; k < c; k++) {
+                    x[i * b + c] -= d[k] * x[i * b + k];
+                }
             }
-        } else {
-            for (int j = 0; j < g.size(); j++) {
-                v_halo[g.globalIndex(j)] = v_local[j];
+            for (int k = 0; k < c; k++) {
+                r[k * b + c] += d[k];
             }
         }
-    }
-    mpi::wait_all(reqs.begin(), reqs.end());
-    // Unpack the buffer to fill in to v_halo
-    for (int rank = 0; rank < world.size(); rank++) {
-        if (rank != g.rank()) {
-            std::vector<T> buf_temp;
-            buf_temp = buf_recv[rank];
-            auto it = halo_recv.find(rank);
-            if (it != halo_recv.end()) {
-                int i = 0;
-                for (const int& halo_neighbour : it->second) {
-                    v_halo[halo_neighbour] =
-                        buf_temp[i];  //(src, tag, store to value)
-                    i++;
+        BlockOps<Vector, T>::column(column, x, b, c);
+        T after = std::sqrt(dot(column, column));
+        if (after > 1e-8 * before) {
+            r[c * b + c] = after;
+        } else {
+            column = init(g);
+            Vector previous;
+            for (int pass = 0; pass < 2; pass++) {
+                for (int k = 0; k < lanczos_vecs.size(); k++) {
+                    auto basis_vec = lanczos_vecs[k];
+                    VectorOps<Vector, T>::axpy(column, basis_vec,
+                                               -dot(basis_vec, column));
+                }
+                for (int k = 0; k < c; k++) {
+                    BlockOps<Vector, T>::column(previous, x, b, k);
+                    VectorOps<Vector, T>::axpy(column, previous,
+                                               -dot(previous, column));
                 }
             }
+            after = std::sqrt(dot(column, column));
+            for (int i = 0; i < size; i++) {
+                x[i * b + c] = column[i];
+            }
+        }
+        for (int i = 0; i < size; i++) {
+            x[i * b + c] /= after;
         }
     }
+    return r;
 }
 
 /**
- * @brief The first component of Lanczos iteration fomular, Laplacian matrix *
- * vector
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @brief Orthogonalise a block against all the Lanczos vectors
+ * @param w The block
  */
 
-template <typename Vector, typename T>
-Vector Lanczos<Vector, T>::multGraphVec(const Graph& g, const Vector& vec)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::reorthogonaliseBlock(Vector& w)
 {
 #ifdef VT_
-    VT_TRACER("Lanczos::multGraphVec");
+    VT_TRACER("Lanczos::GramSchmidt");
 #endif
-    Vector prod(g.size());
-    for (auto it = g.cbegin(); it != g.cend(); ++it) {
-        T temp = 0.0;
-        if (!it->second.empty()) {
-            for (const int& neighbour : it->second) {
-                temp += vec[neighbour];
-            }
-        }
-        prod[g.localIndex(it->first)] =
-            it->second.size() * vec[it->first] - temp;
+    Timers::Scope timer("reorthogonalise");
+    const int b = block_size, vecs = lanczos_vecs.size();
+    std::vector<T> d(vecs * b);
+    for (int k = 0; k < vecs; k++) {
+        BlockOps<Vector, T>::dots(&d[k * b], lanczos_vecs[k], w, b);
+    }
+    reduce(d);
+    for (int k = 0; k < vecs; k++) {
+        BlockOps<Vector, T>::subtract(w, lanczos_vecs[k], &d[k * b], b);
     }
-    return prod;
+    reorthogonalisations++;
+}
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::storeBlock(const Vector& x)
+{
+    Vector column;
+    for (int c = 0; c < block_size; c++) {
+        BlockOps<Vector, T>::column(column, x, block_size, c);
+        lanczos_vecs.push_back(column);
+    }
+}
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::reduce(std::vector<T>& local)
+{
+    Timers::Scope timer("reduce");
+    std::vector<T> global(local.size());
+    mpi::all_reduce(world, local.data(), local.size(), global.data(),
+                    std::plus<T>());
+    local.swap(global);
 }
 
 /**
- * @brief GramSchmidt
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @brief Calculate iterations for Lanczos algorithm
+ * @param num_of_eigenvec Number of the eigenvectors wanted
+ * @param global_size Number of vertices, 64-bit for the estimates of --dry-run
+ * @return The number of iterations, at most global_size
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+const int Lanczos<Vector, T, Basis, Operator, Index>::getIteration(
+    const int& num_of_eigenvec, const int64_t& global_size)
+{
+    int scale;
+    if (num_of_eigenvec == 1) {
+        scale = 4 * num_of_eigenvec;
+    } else if (num_of_eigenvec == 2) {
+        scale = 4 * (num_of_eigenvec - 1);
+    } else {
+        scale = num_of_eigenvec + 2;
+    }
+    if (round(log10(global_size)) > 3) {
+        scale -= round(log10(std::sqrt(global_size)));
+        scale = scale <= 0 ? 1 : scale;
+    }
+    const double m =
+        std::min<double>(scale * std::sqrt(global_size), global_size);
+    if (m > std::numeric_limits<int>::max()) {
+        throw std::out_of_range("Too many Lanczos iterations for int");
+    }
+    return m;
+}
+
+/**
+ * @brief The length of the local Lanczos vectors, the basis is indexed by
+ *        int whatever the index type of the graph
+ * @param g The local graph
+ * @return The number of local vertices, throw std::out_of_range if it does
+ *         not fit in int
  */
 
-template <typename Vector, typename T>
-inline void Lanczos<Vector, T>::gramSchmidt(const int& k, Vector& v)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+int Lanczos<Vector, T, Basis, Operator, Index>::basisSize(
+    const BasicGraph<Index>& g)
+{
+    if (g.size() > std::numeric_limits<int>::max()) {
+        throw std::out_of_range("Too many vertices for the Lanczos basis");
+    }
+    return g.size();
+}
+
+/**
+ * @brief Classical GramSchmidt against the chosen Lanczos vectors, the dot
+ *        products are reduced together in one all_reduce
+ * @param against Indices of the Lanczos vectors
+ * @param w The unnormalised new Lanczos vector
+ * @return The global norm of w
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::reorthogonalise(
+    const std::vector<int>& against, Vector& w)
 {
 #ifdef VT_
     VT_TRACER("Lanczos::GramSchmidt");
 #endif
-    int local_size = lanczos_vecs[0].size();
-    for (int i = 0; i < k; i++) {
-        T dot_global = dot(lanczos_vecs[i], v);
-        for (int j = 0; j < local_size; j++) {
-            v[j] -= dot_global * lanczos_vecs[i][j];
-        }
+    Timers::Scope timer("reorthogonalise");
+    int n = against.size();
+    std::vector<T> dot_local(n), dot_global(n);
+    for (int i = 0; i < n; i++) {
+        dot_local[i] = VectorOps<Vector, T>::dot(lanczos_vecs[against[i]], w);
     }
-    // Normalise
-    T norm_global = std::sqrt(dot(v, v));
-    for (auto& x : v) {
-        x /= norm_global;
+    mpi::all_reduce(world, dot_local.data(), n, dot_global.data(),
+                    std::plus<T>());
+    for (int i = 0; i < n; i++) {
+        VectorOps<Vector, T>::axpy(w, lanczos_vecs[against[i]],
+                                   -dot_global[i]);
     }
+    return std::sqrt(dot(w, w));
 }
 
 /**
@@ -321,36 +500,75 @@ inline void Lanczos<Vector, T>::gramSchmidt(const int& k, Vector& v)
  * @return FILL-ME-IN
  */
 
-template <typename Vector, typename T>
-inline T Lanczos<Vector, T>::dot(const Vector& v1, const Vector& v2)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+template <typename V>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::dot(const V& v1,
+                                                         const Vector& v2)
 {
-    if (v1.size() != v2.size()) {
-        throw std::length_error("Lanczos - dot: The vector sizes don't match.");
-    }
-    int local_size = v1.size();
-    T dot_local = 0.0, dot_global;
-    for (int i = 0; i < local_size; i++) {
-        dot_local += v1[i] * v2[i];
-    }
+    T dot_local = VectorOps<Vector, T>::dot(v1, v2), dot_global;
+    Timers::Scope timer("reduce");
     mpi::all_reduce(world, dot_local, dot_global, std::plus<T>());
 
     return dot_global;
 }
 
-template <typename Vector, typename T>
-inline T Lanczos<Vector, T>::norm(const Vector& vec)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::norm(const Vector& vec)
 {
-    T norm_local = 0.0;
-    for (const auto& x : vec) {
-        norm_local += x * x;
+    return sqrt(VectorOps<Vector, T>::dot(vec, vec));
+}
+
+/**
+ * @brief Project the eigenvector of eigenvalue 0 out of each of the vectors,
+ *        the constant vector or null_ of a normalised operator
+ * @param x width vectors stored row by row
+ * @param width Number of vectors
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::deflate(Vector& x,
+                                                        const int& width)
+{
+    const int size = x.size() / width;
+    if (!null_.empty()) {
+        std::vector<T> dots(width, 0.0);
+        for (int i = 0; i < size; i++) {
+            for (int c = 0; c < width; c++) {
+                dots[c] += null_[i] * x[i * width + c];
+            }
+        }
+        reduce(dots);
+        for (int i = 0; i < size; i++) {
+            for (int c = 0; c < width; c++) {
+                x[i * width + c] -= dots[c] * null_[i];
+            }
+        }
+        return;
+    }
+    std::vector<T> sums(width + 1, 0.0);  // Column sums and number of rows
+    for (int i = 0; i < size; i++) {
+        for (int c = 0; c < width; c++) {
+            sums[c] += x[i * width + c];
+        }
+    }
+    sums[width] = size;
+    reduce(sums);
+    for (int i = 0; i < size; i++) {
+        for (int c = 0; c < width; c++) {
+            x[i * width + c] -= sums[c] / sums[width];
+        }
     }
-    return sqrt(norm_local);
 }
 
-template <typename Vector, typename T>
-Vector Lanczos<Vector, T>::init(const Graph& g)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+Vector Lanczos<Vector, T, Basis, Operator, Index>::init(
+    const BasicGraph<Index>& g)
 {
-    int local_size = g.size();
+    Index local_size = g.size();
     unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
     std::default_random_engine generator(seed);
     std::uniform_real_distribution<double> gen(0.0, 1.0);
@@ -359,17 +577,47 @@ Vector Lanczos<Vector, T>::init(const Graph& g)
     for (auto& x : vec) {
         x = gen(generator);
     }
-    T norm_local = norm(vec);
+    deflate(vec);
+    T norm_global = sqrt(dot(vec, vec));  // processes may own no vertex
     for (auto& x : vec) {
-        x /= norm_local;
-        x /= sqrt(world.size());  // vec[i]/=sqrt(procs), to make sure the
-                                  // global vector is normalised
+        x /= norm_global;
+    }
+    return vec;
+}
+
+/**
+ * @brief The start vector of a warm start, the sum of the normalised
+ *        previous eigenvectors orthogonal to the constant. Random if they
+ *        are (nearly) constant, e.g. all zero.
+ * @param start Local parts of the previous eigenvectors
+ * @param g The local graph
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+Vector Lanczos<Vector, T, Basis, Operator, Index>::init(
+    const std::vector<Vector>& start, const BasicGraph<Index>& g)
+{
+    Vector vec(g.size(), 0.0), x;
+    for (const auto& previous : start) {
+        x = previous;
+        deflate(x);
+        T length = sqrt(dot(x, x));
+        if (length > 0.0) {
+            VectorOps<Vector, T>::axpy(vec, x, 1.0 / length);
+        }
+    }
+    T length = sqrt(dot(vec, vec));
+    if (!(length > 1e-8)) {
+        return init(g);
     }
+    VectorOps<Vector, T>::scale(vec, vec, 1.0 / length);
     return vec;
 }
 
-template <typename Vector, typename T>
-void Lanczos<Vector, T>::print_tri_mat()
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::print_tri_mat()
 {
     int size = alpha.size();
     for (int row = 0; row < size; row++) {
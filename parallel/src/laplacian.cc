@@ -0,0 +1,368 @@
+/**
+ * @file laplacian.cc
+ * @brief The distributed Laplacian matrix of the graph
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef LAPLACIAN_CC_
+#define LAPLACIAN_CC_
+
+#include "laplacian.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include "memory_usage.h"
+#include "timers.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+namespace mpi = boost::mpi;
+
+/**
+ * @brief Find out which rank and the corresponding data need to receive
+ * @param graph The local graph, kept by reference
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+Laplacian<Vector, T, Operator, Index>::Laplacian(
+    const BasicGraph<Index>& graph)
+    : g(graph)
+{
+    Timers::Scope timer("halo_init");
+    // Find out which rank and the corresponding data need to receive
+    std::unordered_map<int, std::set<Index>>
+        halo_recv_temp;  // <rank, halo_neighbours to receive>
+    std::unordered_map<int, std::set<Index>>
+        halo_send_temp;  // <rank, halo_neighbours to send>
+    for (auto iter = g.cbegin(); iter != g.cend(); ++iter) {
+        if (!iter->second.empty()) {
+            for (const Index& neighbour : iter->second) {
+                int rank = g.global_rank_map[neighbour];
+                if (rank != g.rank()) {
+                    auto it = halo_recv_temp.find(rank);
+                    if (it != halo_recv_temp.end()) {
+                        it->second.insert(neighbour);
+                    } else {
+                        std::set<Index> halo_neighbours;
+                        halo_neighbours.insert(neighbour);
+                        halo_recv_temp.insert({rank, halo_neighbours});
+                    }
+                }
+                if (rank != g.rank()) {
+                    auto it = halo_send_temp.find(rank);
+                    if (it != halo_send_temp.end()) {
+                        it->second.insert(iter->first);
+                    } else {
+                        std::set<Index> halo_neighbours;
+                        halo_neighbours.insert(iter->first);
+                        halo_send_temp.insert({rank, halo_neighbours});
+                    }
+                }
+            }
+        }
+    }
+    // Convert <int, set> to <int, vector> for efficient looking up in
+    // halo_update, cheaper than iterating a set.
+    for (auto& it : halo_send_temp) {
+        int rank = it.first;
+        std::vector<Index> vector_send;
+        for (auto& x : it.second) {
+            vector_send.push_back(x);
+        }
+        halo_send.insert({rank, vector_send});
+    }
+    for (auto& it : halo_recv_temp) {
+        int rank = it.first;
+        std::vector<Index> vector_recv;
+        for (auto& x : it.second) {
+            vector_recv.push_back(x);
+        }
+        halo_recv.insert({rank, vector_recv});
+    }
+
+    // The weights in the order multiply visits the edges
+    if (g.weighted()) {
+        for (auto it = g.cbegin(); it != g.cend(); ++it) {
+            for (const Index& neighbour : it->second) {
+                weights.push_back(g.getWeight(it->first, neighbour));
+            }
+        }
+    }
+    // The scaling of the halo vertices comes from their owners once
+    if (Operator::normalised) {
+        Vector local_scale(g.size());
+        for (auto it = g.cbegin(); it != g.cend(); ++it) {
+            T d = degree(it);
+            local_scale[g.localIndex(it->first)] =
+                d > 0.0 ? 1.0 / std::sqrt(d) : 0.0;
+        }
+        haloUpdate(local_scale, 1);
+        scale.assign(v_halo.begin(), v_halo.end());
+    }
+}
+
+/**
+ * @brief Refresh the halo elements each iteration for Graph * Lanczos_Vec
+ * @param v_local The local vectors
+ * @param width Number of values per vertex
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::haloUpdate(
+    const Vector& v_local, const int& width)
+{
+    haloUpdate(v_local.data(), width);
+}
+
+/**
+ * @brief The buffers are allocated by the first exchange of a width, the
+ *        values go as arrays of T without serialisation
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::haloUpdate(const T* v_local,
+                                                       const int& width)
+{
+    // VT_TRACER("Laplacian::haloUpdate");
+    Timers::Scope timer("halo_update");
+    std::size_t capacity = v_halo.capacity();
+    v_halo.resize(g.globalSize() * width);
+    if (v_halo.capacity() != capacity) {
+        MemoryUsage::record("laplacian/v_halo", MemoryUsage::bytes(v_halo));
+    }
+
+    for (const auto& it : halo_send) {
+        std::vector<T>& buf = buf_send[it.first];
+        buf.resize(it.second.size() * width);
+        T* packed = buf.data();
+        for (const Index& halo_neighbour : it.second) {
+            const T* local = v_local + g.localIndex(halo_neighbour) * width;
+            for (int c = 0; c < width; c++) {
+                *packed++ = local[c];
+            }
+        }
+        requests.push_back(
+            world.isend(it.first, 0, buf.data(), (int)buf.size()));
+    }
+    for (const auto& it : halo_recv) {
+        std::vector<T>& buf = buf_recv[it.first];
+        buf.resize(it.second.size() * width);
+        requests.push_back(
+            world.irecv(it.first, 0, buf.data(), (int)buf.size()));
+    }
+    for (Index j = 0; j < g.size(); j++) {
+        for (int c = 0; c < width; c++) {
+            v_halo[g.globalIndex(j) * width + c] = v_local[j * width + c];
+        }
+    }
+    mpi::wait_all(requests.begin(), requests.end());
+    requests.clear();
+    // Unpack the buffers into v_halo
+    for (const auto& it : halo_recv) {
+        const T* packed = buf_recv[it.first].data();
+        for (const Index& halo_neighbour : it.second) {
+            for (int c = 0; c < width; c++) {
+                v_halo[halo_neighbour * width + c] = *packed++;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Laplacian matrix * vectors, each neighbour index is loaded once for
+ *        the width values of a vertex, the halo exchange sends the width
+ *        values of a vertex in the same message
+ * @param x The local vectors, row by row
+ * @param y Returns L * x, local
+ * @param width Number of vectors
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::multiply(const Vector& x,
+                                                     Vector& y,
+                                                     const int& width)
+{
+    y.resize(x.size());
+    multiply(x.data(), y.data(), width);
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::multiply(const T* x, T* y,
+                                                     const int& width)
+{
+#ifdef VT_
+    VT_TRACER("Laplacian::multiply");
+#endif
+    Timers::Scope timer("spmv");
+    haloUpdate(x, width);
+    if (weights.empty()) {
+        multiplyRows<false, Operator::normalised>(y, width);
+    } else {
+        multiplyRows<true, Operator::normalised>(y, width);
+    }
+}
+
+/**
+ * @brief The local rows of L * x from v_halo, the unweighted rows are
+ *        degree * x_i - sum x_j, the weighted ones sum w_ij * (x_i - x_j)
+ *        with the weights read in order from one array. The normalised rows
+ *        are x_i - s_i * sum w_ij * s_j * x_j with s = D^-1/2.
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+template <bool Weighted, bool Normalised>
+void Laplacian<Vector, T, Operator, Index>::multiplyRows(T* y,
+                                                         const int& width)
+{
+    const T* weight = weights.data();
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        T* row = &y[g.localIndex(it->first) * width];
+        const T* own_row = &v_halo[it->first * width];
+        if (Normalised) {
+            const T s = scale[it->first];
+            for (int c = 0; c < width; c++) {
+                row[c] = s > 0.0 ? own_row[c] : 0.0;
+            }
+            for (const Index& neighbour : it->second) {
+                const T* neighbour_row = &v_halo[neighbour * width];
+                T w = s * scale[neighbour];
+                if (Weighted) w *= *weight++;
+                for (int c = 0; c < width; c++) {
+                    row[c] -= w * neighbour_row[c];
+                }
+            }
+            continue;
+        }
+        if (Weighted) {
+            for (int c = 0; c < width; c++) {
+                row[c] = 0.0;
+            }
+            for (const Index& neighbour : it->second) {
+                const T* neighbour_row = &v_halo[neighbour * width];
+                const T w = *weight++;
+                for (int c = 0; c < width; c++) {
+                    row[c] += w * (own_row[c] - neighbour_row[c]);
+                }
+            }
+            continue;
+        }
+        const T degree = it->second.size();
+        for (int c = 0; c < width; c++) {
+            row[c] = degree * own_row[c];
+        }
+        for (const Index& neighbour : it->second) {
+            const T* neighbour_row = &v_halo[neighbour * width];
+            for (int c = 0; c < width; c++) {
+                row[c] -= neighbour_row[c];
+            }
+        }
+    }
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+T Laplacian<Vector, T, Operator, Index>::degree(
+    typename BasicGraph<Index>::const_iterator it) const
+{
+    if (!g.weighted()) {
+        return it->second.size();
+    }
+    T sum = 0.0;
+    for (const Index& neighbour : it->second) {
+        sum += g.getWeight(it->first, neighbour);
+    }
+    return sum;
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+Vector Laplacian<Vector, T, Operator, Index>::diagonal() const
+{
+    Vector degrees(g.size());
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        if (Operator::normalised) {
+            degrees[g.localIndex(it->first)] =
+                scale[it->first] > 0.0 ? 1.0 : 0.0;
+        } else {
+            degrees[g.localIndex(it->first)] = degree(it);
+        }
+    }
+    return degrees;
+}
+
+/**
+ * @brief Gershgorin bound of the largest eigenvalue over all the processes,
+ *        the normalised eigenvalues are at most 2
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+T Laplacian<Vector, T, Operator, Index>::spectralBound() const
+{
+    if (Operator::normalised) {
+        return 2.0;
+    }
+    T max_degree = 0.0, global_max_degree = 0.0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        max_degree = std::max<T>(max_degree, degree(it));
+    }
+    mpi::all_reduce(world, max_degree, global_max_degree, mpi::maximum<T>());
+    return 2.0 * global_max_degree;
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::reduce(std::vector<T>& local)
+{
+    Timers::Scope timer("reduce");
+    std::vector<T> global(local.size());
+    mpi::all_reduce(world, local.data(), local.size(), global.data(),
+                    std::plus<T>());
+    local.swap(global);
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+Vector Laplacian<Vector, T, Operator, Index>::nullVector()
+{
+    Vector null;
+    if (!Operator::normalised) {
+        return null;
+    }
+    null.resize(g.size());
+    std::vector<T> sum(1, 0.0);  // The volume of the graph
+    for (Index i = 0; i < g.size(); i++) {
+        T s = scale[g.globalIndex(i)];
+        null[i] = s > 0.0 ? 1.0 / s : 0.0;
+        sum[0] += null[i] * null[i];
+    }
+    reduce(sum);
+    for (auto& entry : null) {
+        entry /= std::sqrt(sum[0]);
+    }
+    return null;
+}
+
+/**
+ * @brief The random walk Laplacian D^-1 L = D^-1/2 (D^-1/2 L D^-1/2) D^1/2
+ *        has the eigenvectors D^-1/2 u, normalised again. Every process has
+ *        to call it.
+ * @param u Local part of an eigenvector of the symmetric normalised Laplacian
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::toEigenvector(Vector& u)
+{
+    if (!Operator::randomWalk) {
+        return;
+    }
+    std::vector<T> sum(1, 0.0);
+    for (unsigned int i = 0; i < u.size(); i++) {
+        u[i] *= scale[g.globalIndex(i)];
+        sum[0] += u[i] * u[i];
+    }
+    reduce(sum);
+    if (sum[0] > 0.0) {
+        for (auto& entry : u) {
+            entry /= std::sqrt(sum[0]);
+        }
+    }
+}
+#endif
@@ -4,17 +4,26 @@
  * @author Ken Hu, xnchnhu@gmail.com
  */
 
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
 #include <boost/mpi.hpp>
 #include <boost/program_options.hpp>
-#include <boost/timer.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include "analysis.h"
+#include "csr.h"
 #include "graph.h"
 #include "lanczos.h"
+#include "memory_usage.h"
 #include "partition.h"
+#include "timers.h"
+#include "trace.h"
 #include "tqli.h"
 #ifdef VT_
 #include "vt_user.h"
@@ -41,9 +50,31 @@ int main(int argc, char* argv[])
     ("output,o", ":output the partitioned graph into dot files")
     ("gram-schmidt,g", ":enable Gram Schmidt in Lanczos")
     ("read-by-colour,r", ":read dot format into different processes by colours")
+    ("balanced,b", ":read dot format into different processes balanced by vertices + edges")
+    ("rebalance,l", po::value<double>(), ":migrate vertices if max/average of vertices + edges per process exceeds the value")
     ("subgraphs,s", po::value<int>(), ":set number of subgraphs, has to be the power of 2")
     ("input-file,f", po::value<string>(), ":input file name")
-    ("vertices,v", po::value<int>(), ":number of vertices of the input file")
+    ("vertices,v", po::value<int>(), ":number of vertices of the input file or of --generate")
+    ("generate", po::value<string>(), ":generate a random graph of --vertices vertices: erdos-renyi, rmat or geometric")
+    ("edges", po::value<long long>(), ":number of edges of --generate")
+    ("seed", po::value<unsigned long long>(), ":seed of --generate")
+    ("threads", po::value<int>(), ":threads of --generate in each process, 0 for all cores")
+    ("times-file", po::value<string>(), ":write the wall time of each phase into the file, one \"phase seconds\" per line")
+    ("timers", po::value<string>(), ":write the min, max and average wall-clock times of the phases over the processes into the file as JSON")
+    ("dry-run", ":print the memory per process estimated from --vertices and --edges or the input file, nothing else is done")
+    ("trace", po::value<string>(), ":write the timeline of the phases of all processes into the file as a Chrome trace, needs cmake -DTrace_=ON")
+    ("reorder", po::value<string>(), ":relabel vertices for locality: rcm, bfs or degree, every process gathers the whole graph (memory of all the edges in each process) and the vertices are then distributed evenly, not with -r or -b")
+    ("mixed-precision", ":store the Lanczos vectors in float")
+    ("spill-dir", po::value<string>(), ":store the Lanczos vectors in a file in the directory")
+    ("block-size", po::value<int>(), ":block Lanczos with the given block size")
+    ("chebyshev-degree", po::value<int>(), ":Chebyshev filter the Lanczos start vector with the given degree")
+    ("min-component-size", po::value<int>(), ":partition the connected components with at least the given number of vertices on their own, assign the smaller ones whole, default: 0 (off)")
+    ("eigensolver", po::value<string>(), ":lanczos or lobpcg")
+    ("preconditioner", po::value<string>(), ":preconditioner of LOBPCG: none, jacobi or smoother")
+    ("laplacian", po::value<string>(), ":operator of Lanczos: combinatorial, normalised or random-walk")
+    ("warm-start", po::value<string>(), ":start the eigensolver from the vectors in the file of --save-vectors and stop once converged")
+    ("warm-start-colours", po::value<string>(), ":start the eigensolver from the colours in the dot file of --output and stop once converged")
+    ("save-vectors", po::value<string>(), ":save the eigenvectors into the file for --warm-start")
     ;
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -56,12 +87,56 @@ int main(int argc, char* argv[])
 
     bool read_graph = vm.count("input-file") && vm.count("vertices"),
          read_by_colour = vm.count("read-by-colour"),
+         balanced = vm.count("balanced"), rebalance = vm.count("rebalance"),
          sub_graphs = vm.count("subgraphs"), output = vm.count("output"),
-         gram_schmidt = vm.count("gram-schmidt");
+         gram_schmidt = vm.count("gram-schmidt"),
+         mixed_precision = vm.count("mixed-precision");
+
+    if (vm.count("reorder") && (read_by_colour || balanced)) {
+        if (world.rank() == 0) {
+            cout << "ERROR: --reorder distributes the vertices evenly, it "
+                    "cannot be used with --read-by-colour or --balanced"
+                 << endl;
+        }
+        return 1;
+    }
 
     Graph* g;
 
-    boost::timer timer_io_input;
+    if (vm.count("dry-run")) {
+        if (world.rank() == 0) {
+            int64_t n = vm.count("vertices") ? vm["vertices"].as<int>() : 0;
+            int64_t edges =
+                vm.count("edges") ? vm["edges"].as<long long>() : 8 * n;
+            if (vm.count("input-file")) {
+                int64_t ids;
+                countDotFormat(vm["input-file"].as<string>(), ids, edges);
+                n = max(n, ids);
+            }
+            int eigenvectors =
+                log2(sub_graphs ? vm["subgraphs"].as<int>() : 4);
+            int m = Lanczos<vector<double>, double>::getIteration(
+                eigenvectors, n);
+            m = max<int64_t>(1, min<int64_t>(m, n - 1));
+            size_t basis = mixed_precision ? sizeof(float) : sizeof(double);
+            MemoryUsage::report(
+                cout, {MemoryUsage::estimate(n, edges, m, eigenvectors,
+                                             world.size(), basis, true)},
+                {});
+        }
+        return 0;
+    }
+    if (vm.count("trace")) {
+#ifndef Trace_
+        if (world.rank() == 0) {
+            cout << "WARNING: built without Trace_, the trace is empty"
+                 << endl;
+        }
+#endif
+        world.barrier();  // The same origin of the timelines
+        Trace::start();
+    }
+    Timers::Scope timer_read("read");
     if (read_graph) {
         g = new Graph;
         vertices = vm["vertices"].as<int>();
@@ -74,12 +149,34 @@ int main(int argc, char* argv[])
             if (world.rank() == 0) {
                 cout << "cluster assignment" << endl;
             }
+        } else if (balanced) {
+            g->readDotFormatBalanced(filename, vertices);
+            if (world.rank() == 0) {
+                cout << "balanced assignment" << endl;
+            }
         } else {
             g->readDotFormat(filename, vertices);
             if (world.rank() == 0) {
                 cout << "even assignment" << endl;
             }
         }
+    } else if (vm.count("generate") && vm.count("vertices")) {
+        g = new Graph;
+        vertices = vm["vertices"].as<int>();
+        long long edges = vm.count("edges") ? vm["edges"].as<long long>()
+                                            : 8LL * vertices;
+        unsigned long long seed =
+            vm.count("seed") ? vm["seed"].as<unsigned long long>() : 1;
+        Generator generator(Generator::model(vm["generate"].as<string>()),
+                            vertices, edges, seed);
+        g->generate(generator,
+                    vm.count("threads") ? vm["threads"].as<int>() : 0);
+        int64_t generated = 0;
+        mpi::reduce(world, g->edgesNum(), generated, std::plus<int64_t>(), 0);
+        if (world.rank() == 0) {
+            cout << "generated: vertices = " << vertices
+                 << ", edges = " << generated << "." << endl;
+        }
     } else {
         if (world.rank() == 0) {
             cout << "Please set file name and number of vertices" << endl;
@@ -87,6 +184,22 @@ int main(int argc, char* argv[])
         }
         return 0;
     }
+    if (vm.count("reorder")) {
+        int64_t halo_edges = 0, halo_edges_reordered = 0;
+        mpi::reduce(world, g->haloEdgesNum(), halo_edges,
+                    std::plus<int64_t>(), 0);
+        g->reorder(vm["reorder"].as<string>());
+        mpi::reduce(world, g->haloEdgesNum(), halo_edges_reordered,
+                    std::plus<int64_t>(), 0);
+        if (world.rank() == 0) {
+            cout << "reorder: edges between processes " << halo_edges / 2
+                 << " -> " << halo_edges_reordered / 2 << endl;
+        }
+    }
+    if (rebalance && g->rebalance(vm["rebalance"].as<double>()) &&
+        world.rank() == 0) {
+        cout << "vertices have been migrated for load balancing" << endl;
+    }
     if (sub_graphs) {
         subgraphs = vm["subgraphs"].as<int>();
         if (world.rank() == 0 && read_graph) {
@@ -101,16 +214,51 @@ int main(int argc, char* argv[])
             cout << "number of processes = " << world.size() << "." << endl;
         }
     }
+    double t_input = timer_read.stop();
     if (world.rank() == 0) {
-        double t_input = timer_io_input.elapsed();
         cout << "input takes " << t_input << "s" << endl;
     }
 
     world.barrier();
-    Partition partition(*g, subgraphs, gram_schmidt);
+    Timers::Scope timer_solve("solve");
+    PartitionOptions options(gram_schmidt);
+    options.mixedPrecision = mixed_precision;
+    if (vm.count("spill-dir")) {
+        options.spillDirectory = vm["spill-dir"].as<string>();
+    }
+    if (vm.count("block-size")) {
+        options.blockSize = vm["block-size"].as<int>();
+    }
+    if (vm.count("chebyshev-degree")) {
+        options.chebyshevDegree = vm["chebyshev-degree"].as<int>();
+    }
+    if (vm.count("min-component-size")) {
+        options.minComponentSize = vm["min-component-size"].as<int>();
+    }
+    if (vm.count("eigensolver")) {
+        options.eigensolver = vm["eigensolver"].as<string>();
+    }
+    if (vm.count("preconditioner")) {
+        options.preconditioner = vm["preconditioner"].as<string>();
+    }
+    if (vm.count("laplacian")) {
+        options.laplacian = vm["laplacian"].as<string>();
+    }
+    if (vm.count("warm-start")) {
+        options.startVectors = g->readVectors(vm["warm-start"].as<string>());
+    } else if (vm.count("warm-start-colours")) {
+        options.startVectors = Partition::colourVectors(
+            g->readColours(vm["warm-start-colours"].as<string>()), subgraphs);
+    }
+    Partition partition(*g, subgraphs, options);
+    if (vm.count("save-vectors")) {
+        g->outputVectors(vm["save-vectors"].as<string>(),
+                         partition.eigenvectors());
+    }
     world.barrier();
+    timer_solve.stop();
 
-    boost::timer timer_io_output;
+    Timers::Scope timer_output("output");
     if (world.rank() != 0) {
         filename = "./output/temp_";
         filename += to_string(vertices);
@@ -134,6 +282,7 @@ int main(int argc, char* argv[])
             filename += "r.dot";
             g->readDotFormatWithColour(filename);
         }
+        g->restoreOrder();
         if (output) {
             filename = "./output/result_";
             filename += to_string(g->globalSize());
@@ -143,10 +292,50 @@ int main(int argc, char* argv[])
             g->outputDotFormat(filename);
         }
         Analysis::outputTimes(world.size(), vertices, partition.times);
-        double t_output = timer_io_output.elapsed();
+        double t_output = timer_output.elapsed();
         cout << "output takes " << t_output << "s" << endl;
         Analysis::cutEdgeVertexTable(*g, partition.ritzValues);
     }
+    timer_output.stop();
+    if (vm.count("times-file") && world.rank() == 0) {
+        // The timers of the whole phases, the solver's own times of the
+        // steps of the partition
+        const Timers::Entries& timers = Timers::entries();
+        double input = timers.at("read").first,
+               solve = timers.at("solve").first,
+               t_output = timers.at("output").first;
+        ofstream Times(vm["times-file"].as<string>());
+        Times << "input " << input << endl
+              << "solve " << solve << endl
+              << "output " << t_output << endl
+              << "lanczos " << partition.times[0] << endl
+              << "tqli " << partition.times[1] << endl
+              << "partition " << partition.times[2] << endl
+              << "total " << input + solve + t_output << endl;
+    }
+    if (vm.count("timers")) {
+        std::vector<Timers::Entries> processes;
+        mpi::gather(world, Timers::entries(), processes, 0);
+        if (world.rank() == 0) {
+            ofstream Output(vm["timers"].as<string>());
+            Timers::report(Output, processes);
+        }
+    }
+    if (vm.count("trace")) {
+        std::vector<string> processes;
+        mpi::gather(world, Trace::json(world.rank()), processes, 0);
+        if (world.rank() == 0) {
+            ofstream Output(vm["trace"].as<string>());
+            Trace::write(Output, processes);
+        }
+    }
+    std::vector<MemoryUsage::Entries> memory;
+    std::vector<size_t> rss;
+    mpi::gather(world, MemoryUsage::entries(), memory, 0);
+    mpi::gather(world, MemoryUsage::peakRss(), rss, 0);
+    if (world.rank() == 0) {
+        MemoryUsage::report(cout, memory, rss);
+    }
 
     delete g;
     return 0;
@@ -6,48 +6,120 @@
 
 /*
  * =====================================================================================
- *        Class:  Graph
- *  Description:  Class to create a new graph object
+ *        Class:  BasicGraph
+ *  Description:  Class to create a new graph object, Index is the type of
+ *                the vertex ids
  * =====================================================================================
  */
 
 #ifndef GRAPH_H_
 #define GRAPH_H_
 
+#include <cstdint>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+#include "generator.h"
 
-class Graph
+template <typename Index>
+class BasicGraph
 {
 private:
-    typedef std::unordered_set<int> SetOfNeighbours;
-    std::unordered_map<int, SetOfNeighbours> G;
-    mutable std::unordered_map<int, int> Colour;
+    typedef std::unordered_set<Index> SetOfNeighbours;
+    std::unordered_map<Index, SetOfNeighbours> G;
+    mutable std::unordered_map<Index, int> Colour;
+    // Both directions of an undirected edge, the smaller id first
+    typedef std::pair<Index, Index> EdgeKey;
+    struct EdgeHash {
+        std::size_t operator()(const EdgeKey& key) const
+        {
+            return std::hash<Index>()(key.first) * 31 +
+                   std::hash<Index>()(key.second);
+        }
+    };
+    static EdgeKey edgeKey(Index src, Index dest);
+    // <edge key, weight>, only the weights other than 1 are kept
+    std::unordered_map<EdgeKey, double, EdgeHash> Weight;
+    std::vector<Index> original_index_;  // <new index, index in the input>
+    void relabel(const std::vector<Index>& new_index);
 
 public:
-    Graph() {}
-    Graph(int n);  // Construct a random graph with n vertices
+    typedef Index index_type;
 
-    void addEdge(int src, int dest);
-    const int edgesNum() const;
+    BasicGraph() {}
+    BasicGraph(Index n);  // Construct a random graph with n vertices
+
+    void addEdge(Index src, Index dest, double weight = 1.0);
+    const int64_t edgesNum() const;  // 64-bit, may exceed 2^31
     const int subgraphsNum() const;
-    const int size() const;
+    const Index size() const;
 
     void outputDotFormat(const std::string& filename) const;
     void printLaplacianMat() const;
-    void setColour(int vertex, int colour) const;
-    const int getColour(int vertex) const;
-    const int globalIndex(int& vertex) const;
+    // Record the sizes of the adjacency and the weights in MemoryUsage
+    void recordMemory() const;
+    void setColour(Index vertex, int colour) const;
+    const int getColour(Index vertex) const;
+    const double getWeight(Index src, Index dest) const;  // 1 if not weighted
+    // Any weight other than 1, the Laplacian uses the weighted kernel then
+    bool weighted() const { return !Weight.empty(); }
+    const Index globalIndex(const Index& vertex) const;
+    // Throw std::out_of_range for a vertex id beyond Index
     void readDotFormat(const std::string& filename);
+    // Two passes over threads into CSR, then the adjacency sets are built at
+    // their exact sizes, 0 threads for the hardware concurrency
+    void readDotFormatStreaming(const std::string& filename,
+                                const int& threads = 0);
+    // Replace the graph by the one of the generator, 0 threads for the
+    // hardware concurrency, throw std::out_of_range beyond Index ids
+    void generate(const Generator& generator, const int& threads = 0);
     void readDotFormatWithColour(const std::string& filename);
+    void reorder(const std::string& ordering);
+    void restoreOrder();
+
+    // component[vertex] = smallest vertex in its connected component
+    std::vector<Index> components() const;
+    // <label, number of vertices with the label>, label[vertex]
+    std::map<Index, Index> globalCounts(const std::vector<Index>& label) const;
+    // The graph induced by the vertices, relabelled 0.. in the given order
+    BasicGraph subgraph(const std::vector<Index>& vertices) const;
+    // Threads to partition the components on, one per core
+    static int solverThreads();
+
+    // Batched updates of the adjacency sets, no other structure is rebuilt,
+    // throw std::out_of_range for a vertex not in the graph
+    void insertEdges(const std::vector<std::pair<Index, Index>>& edges);
+    void removeEdges(const std::vector<std::pair<Index, Index>>& edges);
+    // All the neighbours are local, nothing to exchange
+    void updateHaloColours() const {}
 
-    typedef std::unordered_map<int, std::unordered_set<int>>::const_iterator
+    // vectors[r][vertex] to a file by the indices in the input, e.g. the
+    // eigenvectors for a warm start
+    void outputVectors(const std::string& filename,
+                       const std::vector<std::vector<double>>& vectors) const;
+    // vectors[r][vertex] of outputVectors, 0 for the vertices not in the file
+    std::vector<std::vector<double>> readVectors(
+        const std::string& filename) const;
+    // colour[vertex] of a dot file with colours, -1 if a vertex has none
+    std::vector<int> readColours(const std::string& filename) const;
+
+    typedef typename std::unordered_map<Index, SetOfNeighbours>::const_iterator
         const_iterator;
-    const const_iterator find(int vertex) const;
+    const const_iterator find(Index vertex) const;
     const const_iterator cbegin() const;
     const const_iterator cend() const;
 };
 
+// 32-bit ids keep the adjacency compact, 64-bit ids go beyond 2^31
+// vertices, both are instantiated in graph.cc
+typedef BasicGraph<int32_t> Graph;
+typedef BasicGraph<int64_t> Graph64;
+extern template class BasicGraph<int32_t>;
+extern template class BasicGraph<int64_t>;
+
 #endif
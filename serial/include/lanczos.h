@@ -7,30 +7,111 @@
 #ifndef LANCZOS_H_
 #define LANCZOS_H_
 
+#include <cstdint>
 #include <map>
+#include <string>
 #include <vector>
+#include "basis.h"
+#include "chebyshev.h"
 #include "graph.h"
+#include "laplacian.h"
 
-template <typename Vector, typename T>
+/*
+ * =====================================================================================
+ *        Class:  Lanczos
+ *  Description:  Vector is the type of the working vectors with entries of T,
+ *                Basis is the type to store the Lanczos vectors, e.g.
+ *                std::vector<float> halves the memory of the basis while the
+ *                recurrence and reductions are still done in T. The basis
+ *                is kept in a file in spill_dir when it is not empty.
+ *                With block > 1 block Lanczos is used, the result is
+ *                block_tri instead of alpha and beta.
+ *                The start vectors are Chebyshev filtered with
+ *                filter_degree > 0.
+ *                A warm start takes the start vector from the eigenvectors
+ *                of a previous run (their sum, or the first block), and
+ *                stops as soon as the smallest Ritz pairs have converged
+ *                instead of after the fixed number of iterations.
+ *                The constant vector is projected out of the start vector
+ *                and every iterate, the Ritz values are the non-trivial
+ *                eigenvalues only.
+ *                Operator is the policy of normalisation.h, the null
+ *                vector D^1/2 1 is projected out instead for a normalised
+ *                one. Index is the vertex type of the graph, the Lanczos
+ *                vectors are indexed by int either way.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T, typename Basis = Vector,
+          typename Operator = Combinatorial, typename Index = int32_t>
 class Lanczos
 {
 private:
-    Vector init(const int& size);
-    Vector multGraphVec(const Graph& g, const Vector& vec);
-    const int getIteration(const int& num_of_eigenvec, const int& size);
-    inline T dot(const Vector& v1, const Vector& v2);
+    Vector init(const int& size);  // Random, orthogonal to the constant
+    Vector init(const std::vector<Vector>& start, const int& size);
+    void deflate(Vector& x, const int& width = 1);
+    Vector null_;  // Unit null vector of the operator, empty if constant
+    template <typename V>
+    inline T dot(const V& v1, const Vector& v2);
     inline T norm(const Vector& vec);
     inline Vector& normalise(Vector& vec);
-    inline void gramSchmidt(const int& iter, Vector& w);
+    inline T reorthogonalise(const std::vector<int>& against, Vector& w);
     inline T l2norm(const Vector& alpha, const Vector& beta);
 
+    static int basisSize(const BasicGraph<Index>& g);
+
+    void blockLanczos(const BasicGraph<Index>& g,
+                      Laplacian<Vector, T, Operator, Index>& laplacian,
+                      ChebyshevFilter<Vector, T, Operator, Index>& filter,
+                      const int& num_of_eigenvec, const int& m, bool SO,
+                      const std::string& spill_dir,
+                      const std::vector<Vector>& start);
+    std::vector<T> orthonormalise(const BasicGraph<Index>& g, Vector& x);
+    void reorthogonaliseBlock(Vector& w);
+    void storeBlock(const Vector& x);
+    // Where the next Lanczos vector is written: in place into the basis when
+    // it is in T, otherwise into buffer, then stored in lower precision by
+    // storeVector
+    static T* nextVector(LanczosBasis<T>& basis, Vector& buffer)
+    {
+        return basis.append();
+    }
+    template <typename S>
+    static T* nextVector(LanczosBasis<S>& basis, Vector& buffer)
+    {
+        return buffer.data();
+    }
+    static void storeVector(LanczosBasis<T>& basis, const Vector& buffer) {}
+    template <typename S>
+    static void storeVector(LanczosBasis<S>& basis, const Vector& buffer)
+    {
+        basis.push_back(buffer);
+    }
+    void reduce(std::vector<T>& local) {}  // Nothing to reduce in serial
+
 public:
-    Lanczos(const Graph& g, const int& num_of_eigenvec, bool GramSchmidt);
+    Lanczos(const BasicGraph<Index>& g, const int& num_of_eigenvec,
+            bool GramSchmidt, const std::string& spill_dir = std::string(),
+            const int& block = 1, const int& filter_degree = 0,
+            const std::vector<Vector>& start = std::vector<Vector>());
 
     Vector alpha;
     Vector beta;
-    std::vector<Vector> lanczos_vecs;
+    LanczosBasis<typename Basis::value_type> lanczos_vecs;
+    int reorthogonalisations;  // Steps that needed reorthogonalisation
+    int block_size;
+    bool converged;  // The Ritz pairs of a warm start have converged
+    std::vector<Vector> block_tri;  // If block_size > 1
     void print_tri_mat();
+    // Classical Gram-Schmidt of w against the rows against of basis, the
+    // reorthogonalisation of the iterates, w is not normalised
+    template <typename S>
+    static void gramSchmidt(const LanczosBasis<S>& basis,
+                            const std::vector<int>& against, Vector& w);
+    // Number of iterations for the eigenvectors of a graph of size vertices,
+    // throw std::out_of_range if it does not fit in int
+    static const int getIteration(const int& num_of_eigenvec,
+                                  const int64_t& size);
 };
 
 #include "../src/lanczos.cc"
@@ -0,0 +1,63 @@
+/**
+ * @file laplacian.h
+ * @brief The interface of the Laplacian matrix
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef LAPLACIAN_H_
+#define LAPLACIAN_H_
+
+#include <cstdint>
+#include <vector>
+#include "graph.h"
+#include "normalisation.h"
+
+/*
+ * =====================================================================================
+ *        Class:  Laplacian
+ *  Description:  L = D - A of the (weighted) graph, multiplies width
+ *                vectors stored row by row (entry (i, c) at x[i * width + c]).
+ *                A normalised Operator multiplies by D^-1/2 L D^-1/2.
+ *                Index is the type of the vertex ids of the graph.
+ * =====================================================================================
+ */
+
+template <typename Vector, typename T, typename Operator = Combinatorial,
+          typename Index = int32_t>
+class Laplacian
+{
+private:
+    const BasicGraph<Index>& g;
+    // Weights in the order the rows and their neighbours are visited, empty
+    // for an unweighted graph
+    std::vector<T> weights;
+    // D^-1/2 of each vertex for a normalised operator, 0 if isolated
+    std::vector<T> scale;
+    template <bool Weighted, bool Normalised>
+    void multiplyRows(const T* x, T* y, const int& width);
+    // Sum of the edge weights
+    T degree(typename BasicGraph<Index>::const_iterator it) const;
+
+public:
+    explicit Laplacian(const BasicGraph<Index>& graph);
+
+    void multiply(const Vector& x, Vector& y, const int& width = 1);
+    // Into y of size() * width entries given by the caller, e.g. a row of
+    // the Lanczos basis
+    void multiply(const T* x, T* y, const int& width = 1);
+    void reduce(std::vector<T>& local) {}  // Nothing to reduce in serial
+    Index size() const { return g.size(); }
+    Index globalSize() const { return g.size(); }
+    int rank() const { return 0; }
+    Vector diagonal() const;  // Weighted degrees, 1 if normalised
+    T spectralBound() const;  // Upper bound of the eigenvalues, 2 * max degree
+    // Unit eigenvector of eigenvalue 0 of a normalised operator, D^1/2 1
+    // normalised, empty for the combinatorial one (the constant vector)
+    Vector nullVector() const;
+    // Map an eigenvector of the operator multiply applies to one of
+    // Operator, D^-1/2 u for the random walk Laplacian
+    void toEigenvector(Vector& u) const;
+};
+
+#include "../src/laplacian.cc"
+#endif
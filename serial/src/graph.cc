@@ -1,21 +1,79 @@
 /**
  * @file graph.cc
- * @brief Member functions for Class Graph.hpp
+ * @brief Member functions for Class BasicGraph
  * @author Ken Hu, xnchnhu@gmail.com
  */
 
+#include <algorithm>
 #include <chrono>
 #include <climits>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
+#include "csr.h"
 #include "graph.h"
+#include "memory_usage.h"
+#include "ordering.h"
 
 using namespace std;
-typedef std::unordered_map<int, std::unordered_set<int>>::const_iterator
-    const_iterator;
+
+/**
+ * @brief Key of an undirected edge, the same for both directions
+ */
+template <typename Index>
+typename BasicGraph<Index>::EdgeKey BasicGraph<Index>::edgeKey(Index src,
+                                                               Index dest)
+{
+    if (src > dest) swap(src, dest);
+    return EdgeKey(src, dest);
+}
+
+/**
+ * @brief Read the rest of an edge line, "[weight=w] ;" or " ;"
+ * @return The weight, 1 if the line has none
+ */
+static double readWeight(istream& In)
+{
+    string rest;
+    getline(In, rest);
+    size_t at = rest.find("weight=");
+    if (at == string::npos) return 1.0;
+    double weight = atof(rest.c_str() + at + 7);
+    if (weight < 0.0) {
+        std::cerr << "ERROR: Negative edge weight " << weight << endl;
+        exit(-1);
+    }
+    return weight;
+}
+
+/**
+ * @brief Read "src--dest" of an edge line into the ids of the graph
+ * @return false at the end of the file
+ */
+template <typename Index>
+static bool readEdge(istream& In, Index& from, Index& to)
+{
+    int64_t src, dest;
+    In >> src;
+    In.ignore(INT_MAX, '-');
+    In.ignore(1);  // Skip the second '-'
+    In >> dest;
+    if (!In.good()) return false;
+    if (src > numeric_limits<Index>::max() ||
+        dest > numeric_limits<Index>::max()) {
+        throw out_of_range("Vertex id out of the index range");
+    }
+    from = src;
+    to = dest;
+    return true;
+}
 
 /**
  * @brief Generate random graphs with the addEdge function
@@ -23,20 +81,20 @@ typedef std::unordered_map<int, std::unordered_set<int>>::const_iterator
  * @return FILL-ME-IN
  */
 
-Graph::Graph(int num_of_vertex)
+template <typename Index>
+BasicGraph<Index>::BasicGraph(Index num_of_vertex)
 {
     unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
     std::default_random_engine rng(seed);
     uniform_int_distribution<int> num_of_neigh(2, 3);
 
-    for (int vertex = 0; vertex < num_of_vertex; ++vertex) {
+    for (Index vertex = 0; vertex < num_of_vertex; ++vertex) {
         int num_of_neighbour = num_of_neigh(rng);
         // cout << "num_of_neighbour = " << num_of_neighbour << endl;
-        uniform_int_distribution<int> randneigh(
+        uniform_int_distribution<Index> randneigh(
             0, num_of_vertex - 1);  // [0, num_of_vertex - 1]
-        unordered_set<int> neighbours;
         for (int neighbour = 0; neighbour < num_of_neighbour; neighbour++) {
-            int rand_neighbour = 0;
+            Index rand_neighbour = 0;
             int trials = 1000;
             do {
                 rand_neighbour = randneigh(rng);
@@ -47,21 +105,29 @@ Graph::Graph(int num_of_vertex)
             addEdge(vertex, rand_neighbour);
         }
     }
-    if (G.size() != (unsigned)num_of_vertex)
+    if ((Index)G.size() != num_of_vertex)
         throw std::length_error("The size of generated graph is incorrect.");
     cout << "Graph generation is done." << endl;
 }
 
-void Graph::addEdge(int src, int dest)
+template <typename Index>
+void BasicGraph<Index>::addEdge(Index src, Index dest, double weight)
 {
     // Avoid the self circle
     if (src == dest) return;
+    // Only the weights other than 1 are kept, a weight of 1 drops the one
+    // of an earlier insertion
+    if (weight != 1.0) {
+        Weight[edgeKey(src, dest)] = weight;
+    } else if (!Weight.empty()) {
+        Weight.erase(edgeKey(src, dest));
+    }
     // Add edge src->edge
     auto it = G.find(src);
     if (it != G.end()) {
         it->second.insert(dest);
     } else {
-        unordered_set<int> edges;
+        SetOfNeighbours edges;
         edges.insert(dest);
         G.insert({src, edges});
     }
@@ -70,7 +136,7 @@ void Graph::addEdge(int src, int dest)
     if (it != G.end()) {
         it->second.insert(src);
     } else {
-        unordered_set<int> edges;
+        SetOfNeighbours edges;
         edges.insert(src);
         G.insert({dest, edges});
     }
@@ -82,9 +148,14 @@ void Graph::addEdge(int src, int dest)
  * @return FILL-ME-IN
  */
 
-void Graph::setColour(int vertex, int colour) const { Colour[vertex] = colour; }
+template <typename Index>
+void BasicGraph<Index>::setColour(Index vertex, int colour) const
+{
+    Colour[vertex] = colour;
+}
 
-const int Graph::getColour(int vertex) const
+template <typename Index>
+const int BasicGraph<Index>::getColour(Index vertex) const
 {
     if (Colour.size() == 0) {
         return 0;
@@ -92,43 +163,85 @@ const int Graph::getColour(int vertex) const
     return Colour.at(vertex);
 }
 
+template <typename Index>
+const double BasicGraph<Index>::getWeight(Index src, Index dest) const
+{
+    if (Weight.empty()) return 1.0;
+    auto it = Weight.find(edgeKey(src, dest));
+    return it != Weight.end() ? it->second : 1.0;
+}
+
 /**
  * @brief Functions to return graph properties
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
 
-const int Graph::size() const { return G.size(); }
+template <typename Index>
+const Index BasicGraph<Index>::size() const
+{
+    return G.size();
+}
 
-const int Graph::edgesNum() const
+template <typename Index>
+const int64_t BasicGraph<Index>::edgesNum() const
 {
-    int edges = 0;
+    int64_t edges = 0;
     for (const auto& it : G) {
         edges += it.second.size();
     }
     return edges / 2;
 }
 
-const int Graph::subgraphsNum() const
+template <typename Index>
+const int BasicGraph<Index>::subgraphsNum() const
 {
     if (Colour.size() == 0) {
         cout << "WARNING:The graph hasn't been partitioned." << endl;
         return 1;
     }
-    unordered_map<int, int> reverse_colour_map;
+    unordered_map<int, Index> reverse_colour_map;
     for (const auto& it : Colour) {
         reverse_colour_map.insert({it.second, it.first});
     }
     return reverse_colour_map.size();
 }
 
-const const_iterator Graph::find(int vertex) const { return G.find(vertex); }
+template <typename Index>
+const typename BasicGraph<Index>::const_iterator BasicGraph<Index>::find(
+    Index vertex) const
+{
+    return G.find(vertex);
+}
 
-const const_iterator Graph::cbegin() const { return G.cbegin(); }
+template <typename Index>
+const typename BasicGraph<Index>::const_iterator BasicGraph<Index>::cbegin()
+    const
+{
+    return G.cbegin();
+}
 
-const const_iterator Graph::cend() const { return G.cend(); }
+template <typename Index>
+const typename BasicGraph<Index>::const_iterator BasicGraph<Index>::cend()
+    const
+{
+    return G.cend();
+}
 
-const int Graph::globalIndex(int& vertex) const { return vertex; }
+template <typename Index>
+const Index BasicGraph<Index>::globalIndex(const Index& vertex) const
+{
+    return vertex;
+}
+
+template <typename Index>
+void BasicGraph<Index>::recordMemory() const
+{
+    MemoryUsage::record("graph/adjacency", MemoryUsage::bytes(G));
+    if (weighted()) {
+        MemoryUsage::record("graph/weights", MemoryUsage::bytes(Weight));
+    }
+}
 
 /**
  * @brief Write graph in DOT format
@@ -136,25 +249,30 @@ const int Graph::globalIndex(int& vertex) const { return vertex; }
  * @return FILL-ME-IN
  */
 
-void Graph::outputDotFormat(const string& filename) const
+template <typename Index>
+void BasicGraph<Index>::outputDotFormat(const string& filename) const
 {
-    int num_of_vertex = G.size();
+    Index num_of_vertex = G.size();
     ofstream Output(filename);
 
     Output << "Undirected Graph {" << endl;
     if (Colour.size() == 0) {
-        for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+        for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
             Output << vertex << ";" << endl;
         }
     } else {
-        for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+        for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
             Output << vertex << "[C=" << getColour(vertex) << "];" << endl;
         }
     }
-    for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
         auto it = G.find(vertex);
-        for (const int& neighbour : it->second) {
-            Output << vertex << "--" << neighbour << " ;" << endl;
+        for (const Index& neighbour : it->second) {
+            Output << vertex << "--" << neighbour;
+            if (weighted()) {
+                Output << " [weight=" << getWeight(vertex, neighbour) << "]";
+            }
+            Output << " ;" << endl;
         }
     }
     Output << "}" << endl;
@@ -166,19 +284,20 @@ void Graph::outputDotFormat(const string& filename) const
  * @return FILL-ME-IN
  */
 
-void Graph::printLaplacianMat() const
+template <typename Index>
+void BasicGraph<Index>::printLaplacianMat() const
 {
-    int num_of_vertex = G.size();
+    Index num_of_vertex = G.size();
     cout << "Laplacian Matrix:" << endl;
-    for (int vertex = 0; vertex < num_of_vertex; vertex++) {
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
         cout << "\t" << vertex;
     }
     cout << endl;
 
-    for (int row = 0; row < num_of_vertex; row++) {
+    for (Index row = 0; row < num_of_vertex; row++) {
         cout << row << "\t";
         auto it = G.find(row);
-        for (int col = 0; col < num_of_vertex; col++) {
+        for (Index col = 0; col < num_of_vertex; col++) {
             if (col == row)
                 cout << G.at(row).size() << "\t";
             else if (it->second.find(col) != it->second.end())
@@ -196,49 +315,110 @@ void Graph::printLaplacianMat() const
  * @return FILL-ME-IN
  */
 
-void Graph::readDotFormat(const string& filename)
+template <typename Index>
+void BasicGraph<Index>::readDotFormat(const string& filename)
 {
     ifstream In(filename);
     if (!In.is_open()) {
         std::cerr << "ERROR: Can't open the file" << endl;
         exit(-1);
     }
-    int from, to;
+    Index from, to;
     In.ignore(INT_MAX, '{');  // Ignore the chars before the value of colour
-    In >> from;               // the first vertex
-    In.ignore(INT_MAX, '-');
-    In.ignore(1);  // Skip the second '-'
-    In >> to;
-    In.ignore(INT_MAX,
-              '\n');  // Ignore other chars before end of line, go to next line
-
-    while (In.good()) {
-        addEdge(from, to);
-        In >> from;
-        In.ignore(2);  // Ignore "--"
-        In >> to;
-        In.ignore(INT_MAX, '\n');
+    // The first vertex, then each line "src--dest [weight=w] ;"
+    while (readEdge(In, from, to)) {
+        addEdge(from, to, readWeight(In));  // The rest of the line
     }
     In.close();
 }
 
+/**
+ * @brief Read the graph from Dot file through compressed sparse rows, the
+ *        edges are counted and stored at their exact size before any
+ *        adjacency set is built, no set is rehashed while reading. The
+ *        rows are freed as their sets are built. The vertices without an
+ *        edge are kept.
+ * @param filename The dot file
+ * @param threads Number of threads to parse the file with
+ */
+
+template <typename Index>
+void BasicGraph<Index>::readDotFormatStreaming(const string& filename,
+                                               const int& threads)
+{
+    Csr<Index> csr;
+    try {
+        csr = readDotFormatCsr<Index>(filename, threads);
+    } catch (const runtime_error&) {
+        std::cerr << "ERROR: Can't open the file" << endl;
+        exit(-1);
+    }
+    G.clear();
+    G.reserve(csr.size());
+    // From the last row, the rows turned into sets are given back as the
+    // sets grow, the rows and the sets are not held whole at once
+    size_t kept = csr.neighbours.capacity();
+    for (Index vertex = csr.size() - 1; vertex >= 0; vertex--) {
+        SetOfNeighbours& neighbours = G[vertex];
+        neighbours.reserve(csr.degree(vertex));
+        neighbours.insert(csr.neighbours.begin() + csr.offsets[vertex],
+                          csr.neighbours.begin() + csr.offsets[vertex + 1]);
+        csr.neighbours.resize(csr.offsets[vertex]);
+        if (csr.neighbours.size() < kept / 2) {
+            csr.neighbours.shrink_to_fit();
+            kept = csr.neighbours.capacity();
+        }
+    }
+}
+
+/**
+ * @brief Generate a random graph in memory, the edges are generated over
+ *        threads and added in both directions, the isolated vertices are
+ *        kept
+ * @param generator The model, size and seed of the graph
+ * @param threads Number of threads to generate the edges with
+ */
+
+template <typename Index>
+void BasicGraph<Index>::generate(const Generator& generator, const int& threads)
+{
+    if (generator.vertices() > numeric_limits<Index>::max()) {
+        throw out_of_range("Too many vertices for the graph");
+    }
+    const Index size = generator.vertices();
+    G.clear();
+    Colour.clear();
+    Weight.clear();
+    original_index_.clear();
+    G.reserve(size);
+    for (Index vertex = 0; vertex < size; vertex++) {
+        G[vertex];
+    }
+    for (const auto& edge : generator.edges(0, 1, threads)) {
+        addEdge(edge.first, edge.second);
+        addEdge(edge.second, edge.first);
+    }
+}
+
 /**
  * @brief Read the graph from Dot file with the colour of each vertex
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
 
-void Graph::readDotFormatWithColour(const string& filename)
+template <typename Index>
+void BasicGraph<Index>::readDotFormatWithColour(const string& filename)
 {
     ifstream In(filename);
     if (!In.is_open()) {
         std::cerr << "ERROR: Can't open the file" << endl;
         exit(-1);
     }
-    int vertex, colour;
+    Index vertex;
+    int colour;
     In.ignore(INT_MAX, '{');  // Ignore the chars before the value of colour
     In >> vertex;
-    int first_vertex = vertex;
+    Index first_vertex = vertex;
     In.ignore(INT_MAX, '=');  // Ignore the chars before the value of colour
     In >> colour;
     In.ignore(INT_MAX,
@@ -253,16 +433,314 @@ void Graph::readDotFormatWithColour(const string& filename)
         In >> colour;
         In.ignore(INT_MAX, '\n');
     }
-    int from = first_vertex, to;
+    Index from = first_vertex, to;
     In.ignore(2);  // Ignore "--"
     In >> to;
-    In.ignore(INT_MAX, '\n');
+    double weight = readWeight(In);
     while (In.good()) {
-        addEdge(from, to);
+        addEdge(from, to, weight);
         In >> from;
         In.ignore(2);  // Ignore "--"
         In >> to;
-        In.ignore(INT_MAX, '\n');
+        weight = readWeight(In);
     }
     In.close();
 }
+
+/**
+ * @brief Relabel the vertices to improve the locality of the neighbours in
+ * the Lanczos vectors, the input indices are kept for restoreOrder
+ * @param ordering "rcm", "bfs" or "degree"
+ */
+
+template <typename Index>
+void BasicGraph<Index>::reorder(const string& ordering)
+{
+    Index num_of_vertex = G.size();
+    vector<vector<Index>> adjacency(num_of_vertex);
+    for (const auto& it : G) {
+        adjacency.at(it.first).assign(it.second.cbegin(), it.second.cend());
+    }
+    vector<Index> order = vertexOrdering(ordering, adjacency);
+    vector<Index> new_index(num_of_vertex);
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
+        new_index[order[vertex]] = vertex;
+    }
+    relabel(new_index);
+
+    if (!original_index_.empty()) {
+        for (auto& x : order) {
+            x = original_index_[x];
+        }
+    }
+    original_index_ = order;
+}
+
+/**
+ * @brief Map the vertices and colours back to the indices in the input
+ */
+
+template <typename Index>
+void BasicGraph<Index>::restoreOrder()
+{
+    if (original_index_.empty()) return;
+    relabel(original_index_);
+    original_index_.clear();
+}
+
+template <typename Index>
+void BasicGraph<Index>::relabel(const vector<Index>& new_index)
+{
+    unordered_map<Index, SetOfNeighbours> relabelled;
+    relabelled.reserve(G.size());
+    for (const auto& it : G) {
+        SetOfNeighbours& neighbours = relabelled[new_index[it.first]];
+        neighbours.reserve(it.second.size());
+        for (const Index& neighbour : it.second) {
+            neighbours.insert(new_index[neighbour]);
+        }
+    }
+    G.swap(relabelled);
+
+    unordered_map<Index, int> colour;
+    for (const auto& it : Colour) {
+        colour.insert({new_index[it.first], it.second});
+    }
+    Colour.swap(colour);
+
+    unordered_map<EdgeKey, double, EdgeHash> weight;
+    for (const auto& it : Weight) {
+        weight.insert({edgeKey(new_index[it.first.first],
+                               new_index[it.first.second]),
+                       it.second});
+    }
+    Weight.swap(weight);
+}
+
+/**
+ * @brief Union-find over the edges, the root of each set is its smallest
+ *        vertex
+ * @return component[vertex] = smallest vertex in its connected component
+ */
+
+template <typename Index>
+vector<Index> BasicGraph<Index>::components() const
+{
+    vector<Index> parent(G.size());
+    for (size_t vertex = 0; vertex < parent.size(); vertex++) {
+        parent[vertex] = vertex;
+    }
+    auto find = [&parent](Index vertex) {
+        while (parent[vertex] != vertex) {
+            parent[vertex] = parent[parent[vertex]];  // Path halving
+            vertex = parent[vertex];
+        }
+        return vertex;
+    };
+    for (const auto& it : G) {
+        for (const Index& neighbour : it.second) {
+            Index a = find(it.first), b = find(neighbour);
+            if (a < b) {
+                parent[b] = a;
+            } else if (b < a) {
+                parent[a] = b;
+            }
+        }
+    }
+    for (size_t vertex = 0; vertex < parent.size(); vertex++) {
+        parent[vertex] = find(vertex);
+    }
+    return parent;
+}
+
+template <typename Index>
+map<Index, Index> BasicGraph<Index>::globalCounts(
+    const vector<Index>& label) const
+{
+    map<Index, Index> counts;
+    for (const Index& l : label) {
+        counts[l]++;
+    }
+    return counts;
+}
+
+template <typename Index>
+int BasicGraph<Index>::solverThreads()
+{
+    return max(1u, thread::hardware_concurrency());
+}
+
+/**
+ * @brief Copy the vertices and the edges between them with their weights,
+ *        the colours are not copied
+ * @param vertices The vertices to keep
+ */
+
+template <typename Index>
+BasicGraph<Index> BasicGraph<Index>::subgraph(
+    const vector<Index>& vertices) const
+{
+    vector<Index> new_index(G.size(), -1);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        new_index[vertices[i]] = i;
+    }
+    BasicGraph sub;
+    for (Index i = 0; i < (Index)vertices.size(); i++) {
+        SetOfNeighbours& neighbours = sub.G[i];  // Keep isolated vertices
+        for (const Index& neighbour : G.at(vertices[i])) {
+            if (new_index[neighbour] >= 0) {
+                neighbours.insert(new_index[neighbour]);
+                double weight = getWeight(vertices[i], neighbour);
+                if (weight != 1.0) {
+                    sub.Weight[edgeKey(i, new_index[neighbour])] = weight;
+                }
+            }
+        }
+    }
+    return sub;
+}
+
+/**
+ * @brief Write vectors over the vertices, one line per vertex with its index
+ *        in the input and its entry of each vector, e.g. the eigenvectors to
+ *        warm start the next run
+ * @param filename The file to write
+ * @param vectors vectors[r][vertex]
+ */
+
+template <typename Index>
+void BasicGraph<Index>::outputVectors(
+    const string& filename, const vector<vector<double>>& vectors) const
+{
+    ofstream Output(filename, ios::out | ios::trunc);
+    Output.precision(17);
+    Index num_of_vertex = G.size();
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
+        Output << (original_index_.empty() ? vertex : original_index_[vertex]);
+        for (const auto& v : vectors) {
+            Output << " " << v[vertex];
+        }
+        Output << endl;
+    }
+}
+
+/**
+ * @brief Read vectors written by outputVectors, the input indices are mapped
+ *        to the vertices after reordering
+ * @param filename The file to read
+ * @return vectors[r][vertex], 0 for the vertices not in the file
+ */
+
+template <typename Index>
+vector<vector<double>> BasicGraph<Index>::readVectors(
+    const string& filename) const
+{
+    ifstream In(filename);
+    if (!In.is_open()) {
+        std::cerr << "ERROR: Can't open the file" << endl;
+        exit(-1);
+    }
+    Index num_of_vertex = G.size();
+    vector<Index> current(num_of_vertex);
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
+        current[original_index_.empty() ? vertex : original_index_[vertex]] =
+            vertex;
+    }
+    vector<vector<double>> vectors;
+    string line;
+    while (getline(In, line)) {
+        istringstream entries(line);
+        int64_t input;
+        double entry;
+        if (!(entries >> input) || input < 0 || input >= num_of_vertex) {
+            continue;
+        }
+        for (unsigned int r = 0; entries >> entry; r++) {
+            if (r == vectors.size()) {
+                vectors.emplace_back(num_of_vertex, 0.0);
+            }
+            vectors[r][current[input]] = entry;
+        }
+    }
+    return vectors;
+}
+
+/**
+ * @brief Read the colours of a dot file written by outputDotFormat, the
+ *        input indices are mapped to the vertices after reordering
+ * @param filename The file to read
+ * @return colour[vertex], -1 for the vertices without a colour
+ */
+
+template <typename Index>
+vector<int> BasicGraph<Index>::readColours(const string& filename) const
+{
+    ifstream In(filename);
+    if (!In.is_open()) {
+        std::cerr << "ERROR: Can't open the file" << endl;
+        exit(-1);
+    }
+    Index num_of_vertex = G.size();
+    vector<Index> current(num_of_vertex);
+    for (Index vertex = 0; vertex < num_of_vertex; vertex++) {
+        current[original_index_.empty() ? vertex : original_index_[vertex]] =
+            vertex;
+    }
+    vector<int> colours(num_of_vertex, -1);
+    string line;
+    while (getline(In, line)) {
+        size_t at = line.find("[C=");
+        if (at == string::npos) {
+            continue;
+        }
+        int64_t input = stoll(line.substr(0, at));
+        if (input >= 0 && input < num_of_vertex) {
+            colours[current[input]] = stoi(line.substr(at + 3));
+        }
+    }
+    return colours;
+}
+
+/**
+ * @brief Insert a batch of edges, the vertices have to exist already
+ * @param edges <src, dest> pairs, self loops are ignored
+ */
+
+template <typename Index>
+void BasicGraph<Index>::insertEdges(const vector<pair<Index, Index>>& edges)
+{
+    Index num_of_vertex = G.size();
+    for (const auto& edge : edges) {
+        if (edge.first < 0 || edge.first >= num_of_vertex ||
+            edge.second < 0 || edge.second >= num_of_vertex) {
+            throw out_of_range("Edge " + to_string(edge.first) + "--" +
+                               to_string(edge.second) + " is not in the graph");
+        }
+        addEdge(edge.first, edge.second);
+    }
+}
+
+/**
+ * @brief Remove a batch of edges, the vertices are kept even if they have no
+ *        neighbour left
+ * @param edges <src, dest> pairs, the ones not in the graph are ignored
+ */
+
+template <typename Index>
+void BasicGraph<Index>::removeEdges(const vector<pair<Index, Index>>& edges)
+{
+    Index num_of_vertex = G.size();
+    for (const auto& edge : edges) {
+        if (edge.first < 0 || edge.first >= num_of_vertex ||
+            edge.second < 0 || edge.second >= num_of_vertex) {
+            throw out_of_range("Edge " + to_string(edge.first) + "--" +
+                               to_string(edge.second) + " is not in the graph");
+        }
+        G[edge.first].erase(edge.second);
+        G[edge.second].erase(edge.first);
+        Weight.erase(edgeKey(edge.first, edge.second));
+    }
+}
+
+template class BasicGraph<int32_t>;
+template class BasicGraph<int64_t>;
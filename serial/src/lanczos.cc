@@ -8,10 +8,20 @@
 #define LANCZOS_CC_
 
 #include "lanczos.h"
+#include <algorithm>
 #include <cmath>
 #include <exception>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <utility>
+#include "kernels.h"
+#include "random_stream.h"
+#include "reorthogonalisation.h"
+#include "solver_log.h"
+#include "timers.h"
+#include "tqli.h"
+#include "trace.h"
 
 #ifdef VT_
 #include "vt_user.h"
@@ -21,7 +31,7 @@ using std::cout;
 using std::endl;
 
 /**
- * @brief Lanczos algorithm with selective orthogonalisation
+ * @brief Lanczos algorithm with partial reorthogonalisation
  * @param FILL-ME-IN
  * @return FILL-ME-IN
  */
@@ -41,33 +51,93 @@ using std::endl;
  *-----------------------------------------------------------------------------*/
 
 #include <cmath>
-template <typename Vector, typename T>
-Lanczos<Vector, T>::Lanczos(const Graph& g, const int& num_of_eigenvec, bool SO)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+Lanczos<Vector, T, Basis, Operator, Index>::Lanczos(
+    const BasicGraph<Index>& g, const int& num_of_eigenvec, bool SO,
+    const std::string& spill_dir, const int& block, const int& filter_degree,
+    const std::vector<Vector>& start)
+    : reorthogonalisations(0),
+      block_size(std::max(1, std::min(block, basisSize(g) - 1))),
+      converged(false)
 {
 #ifdef VT_
     VT_TRACER("LANCZOS_SO");
 #endif
-    const int size = g.size();
-    int t = 0;
-    int m = getIteration(num_of_eigenvec, size);
+    const int size = basisSize(g);
+    // The constant vector is projected out, it leaves size - 1 dimensions
+    int m = std::min(getIteration(num_of_eigenvec, size), size - 1);
+    m = std::max(m, 1);
+    Laplacian<Vector, T, Operator, Index> laplacian(g);
+    ChebyshevFilter<Vector, T, Operator, Index> filter(laplacian,
+                                                       filter_degree);
+    null_ = laplacian.nullVector();
+    if (block_size > 1) {
+        blockLanczos(g, laplacian, filter, num_of_eigenvec, m, SO, spill_dir,
+                     start);
+        return;
+    }
 
-    Vector v0 = init(size);
-    Vector v1 = v0, w, vstart = v0;
+    // The Lanczos vectors are written in place into the basis, v0 and v1
+    // view its last two rows. A basis in lower precision stores copies of
+    // the two spare vectors instead, written in turn.
+    Vector spare[2];
+    spare[0] = start.empty() ? init(size) : init(start, size);
+    if (filter.degree() > 0) {
+        filter.apply(spare[0]);
+        deflate(spare[0]);
+        normalise(spare[0]);
+    }
 
-    T beta_val = 0.0, tol = 1e-6;
+    T beta_val = 0.0;
+    const T breakdown = 1e-10 * laplacian.spectralBound();
+    PartialReorthogonalisation pro(
+        std::numeric_limits<typename Basis::value_type>::epsilon());
     alpha.resize(m);
     beta.resize(m - 1);
-    lanczos_vecs.resize(m);
-    lanczos_vecs[0] = v0;
+    lanczos_vecs.reserve(m, size, spill_dir);
+    T* next = nextVector(lanczos_vecs, spare[0]);
+    if (next != spare[0].data()) {
+        std::copy(spare[0].begin(), spare[0].end(), next);
+        Vector().swap(spare[0]);
+    } else {
+        spare[1].resize(size);
+    }
+    storeVector(lanczos_vecs, spare[0]);
+    BasisRow<T> v0(next, size), v1 = v0;
+    Vector w(size);
 
-    for (int iter = 1; iter < m; iter++) {
-        w = multGraphVec(g, v1);
+    int iter = 1;
+    for (; iter < m; iter++) {
+        TRACE_SCOPE("lanczos_iteration");
+        laplacian.multiply(v1.data(), w.data());
+        deflate(w);  // Rounding errors bring the constant vector back
         alpha[iter - 1] = dot(v1, w);
-        for (int i = 0; i < size; i++) {
-            w[i] = w[i] - alpha[iter - 1] * v1[i] - beta_val * v0[i];
+        // w = w - alpha * v1 - beta * v0, fused with the norm of w
+        beta_val = std::sqrt(VectorOps<Vector, T>::update(
+            w.data(), v1.data(), v0.data(), alpha[iter - 1], beta_val, size));
+        if (SO) {
+            const std::vector<int>& against =
+                pro.next(alpha[iter - 1], beta_val);
+            if (!against.empty()) {
+                beta_val = reorthogonalise(against, w);
+                pro.orthogonalised(beta_val);
+            }
+        }
+        if (beta_val < breakdown) {  // An invariant subspace is found
+            break;
+        }
+        // Check a warm start every iter / 10 steps, O(iter^2) each
+        if (!start.empty() && iter >= num_of_eigenvec &&
+            iter % std::max(1, iter / 10) == 0 &&
+            ritzConverged(std::vector<double>(alpha.begin(),
+                                              alpha.begin() + iter),
+                          std::vector<double>(beta.begin(),
+                                              beta.begin() + iter - 1),
+                          beta_val, num_of_eigenvec, 1e-6)) {
+            converged = true;
+            break;
         }
-
-        beta_val = norm(w);
         beta[iter - 1] = beta_val;
         /*
         if (std::abs(beta[iter - 1]) < 1e-5) {
@@ -80,42 +150,249 @@ Lanczos<Vector, T>::Lanczos(const Graph& g, const int& num_of_eigenvec, bool SO)
             }
         }
         */
-        for (int index = 0; index < size; index++) {
-            v1[index] = w[index] / beta[iter - 1];
+        Vector& buffer = spare[iter % 2];
+        next = nextVector(lanczos_vecs, buffer);
+        VectorOps<Vector, T>::scale(next, w.data(), 1.0 / beta_val, size);
+        storeVector(lanczos_vecs, buffer);
+        v0 = v1;
+        v1 = BasisRow<T>(next, size);
+    }
+    if (iter == m) {
+        laplacian.multiply(v1.data(), w.data());
+        alpha[m - 1] = dot(v1, w);
+    }
+    alpha.resize(iter);
+    beta.resize(iter - 1);
+    reorthogonalisations = pro.steps();
+    std::ostream& out = SolverLog::out();
+    if (SO) {
+        out << "Lanczos algorithm WITH Partial Reorthogonalisation is done."
+            << endl;
+    } else {
+        out << "Lanczos algorithm WITHOUT Partial Reorthogonalisation is done."
+            << endl;
+    }
+    out << "number of iterations = " << iter
+        << ", number of Orthogonalisation = " << pro.steps() << " (against "
+        << pro.vectors() << " vectors)" << (converged ? ", converged" : "")
+        << endl;
+}
+
+/**
+ * @brief Block Lanczos, block_tri returns the block tridiagonal matrix with
+ *        the diagonal blocks A_j and subdiagonal blocks B_j of
+ *        L X_j = X_(j-1) B_(j-1)^T + X_j A_j + X_(j+1) B_j
+ * @param g The graph
+ * @param laplacian The Laplacian matrix of g
+ * @param filter Chebyshev filter of the start block
+ * @param num_of_eigenvec Number of the Ritz pairs wanted
+ * @param m Number of Lanczos vectors, rounded up to a multiple of block_size
+ * @param SO Reorthogonalise each block against all the Lanczos vectors
+ * @param spill_dir Directory to keep the Lanczos vectors in, or empty
+ * @param start The first columns of the start block, stop once the Ritz
+ *        pairs have converged if not empty
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::blockLanczos(
+    const BasicGraph<Index>& g,
+    Laplacian<Vector, T, Operator, Index>& laplacian,
+    ChebyshevFilter<Vector, T, Operator, Index>& filter,
+    const int& num_of_eigenvec, const int& m, bool SO,
+    const std::string& spill_dir, const std::vector<Vector>& start)
+{
+#ifdef VT_
+    VT_TRACER("BlockLanczos");
+#endif
+    const int size = basisSize(g), b = block_size;
+    int steps = std::min((m + b - 1) / b, (size - 1) / b);
+    Vector x(size * b), x_prev, w, column;
+    for (int c = 0; c < b; c++) {
+        column = c < (int)start.size() ? start[c] : init(size);
+        for (int i = 0; i < size; i++) {
+            x[i * b + c] = column[i];
+        }
+    }
+    lanczos_vecs.reserve(steps * b, size, spill_dir);
+    if (!start.empty()) {
+        deflate(x, b);
+    }
+    filter.apply(x, b);
+    orthonormalise(g, x);
+    storeBlock(x);
+
+    std::vector<T> beta_block;
+    block_tri.assign(steps * b, Vector(steps * b, 0.0));
+    for (int j = 0; j < steps; j++) {
+        TRACE_SCOPE("lanczos_iteration");
+        laplacian.multiply(x, w, b);
+        deflate(w, b);
+        if (j > 0) {
+            BlockOps<Vector, T>::subtract(w, x_prev, beta_block, b, true);
+        }
+        std::vector<T> alpha_block = BlockOps<Vector, T>::gram(x, w, b);
+        reduce(alpha_block);
+        BlockOps<Vector, T>::subtract(w, x, alpha_block, b, false);
+        for (int r = 0; r < b; r++) {
+            for (int c = 0; c < b; c++) {
+                block_tri[j * b + r][j * b + c] =
+                    0.5 * (alpha_block[r * b + c] + alpha_block[c * b + r]);
+            }
+        }
+        if (j == steps - 1) {
+            break;
         }
         if (SO) {
-            if (std::abs(dot(vstart, v1)) >= tol) {
-                gramSchmidt(iter, v1);
-                t++;
+            reorthogonaliseBlock(w);
+        }
+        beta_block = orthonormalise(g, w);
+        for (int r = 0; r < b; r++) {
+            for (int c = 0; c < b; c++) {
+                block_tri[(j + 1) * b + r][j * b + c] = beta_block[r * b + c];
+                block_tri[j * b + c][(j + 1) * b + r] = beta_block[r * b + c];
             }
         }
-        lanczos_vecs[iter] = v1;
-        v0 = lanczos_vecs[iter - 1];
+        if (!start.empty() && (j + 1) * b >= num_of_eigenvec &&
+            (j + 1) % std::max(1, (j + 1) / 10) == 0 &&
+            blockRitzConverged(block_tri, (j + 1) * b, beta_block, b,
+                               num_of_eigenvec, 1e-6)) {
+            converged = true;
+            steps = j + 1;
+            break;
+        }
+        x_prev.swap(x);
+        x.swap(w);
+        storeBlock(x);
     }
-    w = multGraphVec(g, v1);
-    alpha[m - 1] = dot(v1, w);
-    if (SO) {
-        cout << "Lanczos algorithm WITH Selective Orthogonalisation is done."
-             << endl;
-    } else {
-        cout << "Lanczos algorithm WITHOUT Selective Orthogonalisation is done."
-             << endl;
+    block_tri.resize(steps * b);
+    for (auto& row : block_tri) {
+        row.resize(steps * b);
+    }
+    std::ostream& out = SolverLog::out();
+    out << "Block Lanczos algorithm (block size " << b << ") is done." << endl;
+    out << "number of iterations = " << steps
+        << ", number of Lanczos vectors = " << steps * b
+        << (converged ? ", converged" : "") << endl;
+}
+
+/**
+ * @brief QR factorisation of a block by Gram-Schmidt applied twice to each
+ *        column, a column in the span of the previous ones (e.g. an invariant
+ *        subspace is found) is replaced by a random orthogonal vector
+ * @param g The graph
+ * @param x The block, returns Q
+ * @return R, b * b row major
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+std::vector<T> Lanczos<Vector, T, Basis, Operator, Index>::orthonormalise(
+    const BasicGraph<Index>& g, Vector& x)
+{
+    const int b = block_size, size = x.size() / b;
+    std::vector<T> r(b * b, 0.0);
+    Vector column;
+    for (int c = 0; c < b; c++) {
+        BlockOps<Vector, T>::column(column, x, b, c);
+        T before = std::sqrt(dot(column, column));
+        for (int pass = 0; pass < 2; pass++) {
+            std::vector<T> d(c, 0.0);
+            for (int i = 0; i < size; i++) {
+                for (int k = 0; k < c; k++) {
+                    d[k] += x[i * b + k] * x[i * b + c];
+                }
+            }
+            reduce(d);
+            for (int i = 0; i < size; i++) {
+                for (int k = 0; k < c; k++) {
+                    x[i * b + c] -= d[k] * x[i * b + k];
+                }
+            }
+            for (int k = 0; k < c; k++) {
+                r[k * b + c] += d[k];
+            }
+        }
+        BlockOps<Vector, T>::column(column, x, b, c);
+        T after = std::sqrt(dot(column, column));
+        if (after > 1e-8 * before) {
+            r[c * b + c] = after;
+        } else {
+            column = init(size);
+            Vector previous;
+            for (int pass = 0; pass < 2; pass++) {
+                for (int k = 0; k < lanczos_vecs.size(); k++) {
+                    auto basis_vec = lanczos_vecs[k];
+                    VectorOps<Vector, T>::axpy(column, basis_vec,
+                                               -dot(basis_vec, column));
+                }
+                for (int k = 0; k < c; k++) {
+                    BlockOps<Vector, T>::column(previous, x, b, k);
+                    VectorOps<Vector, T>::axpy(column, previous,
+                                               -dot(previous, column));
+                }
+            }
+            after = std::sqrt(dot(column, column));
+            for (int i = 0; i < size; i++) {
+                x[i * b + c] = column[i];
+            }
+        }
+        for (int i = 0; i < size; i++) {
+            x[i * b + c] /= after;
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief Orthogonalise a block against all the Lanczos vectors
+ * @param w The block
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::reorthogonaliseBlock(Vector& w)
+{
+#ifdef VT_
+    VT_TRACER("GramSchmidt");
+#endif
+    Timers::Scope timer("reorthogonalise");
+    const int b = block_size, vecs = lanczos_vecs.size();
+    std::vector<T> d(vecs * b);
+    for (int k = 0; k < vecs; k++) {
+        BlockOps<Vector, T>::dots(&d[k * b], lanczos_vecs[k], w, b);
+    }
+    reduce(d);
+    for (int k = 0; k < vecs; k++) {
+        BlockOps<Vector, T>::subtract(w, lanczos_vecs[k], &d[k * b], b);
+    }
+    reorthogonalisations++;
+}
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::storeBlock(const Vector& x)
+{
+    Vector column;
+    for (int c = 0; c < block_size; c++) {
+        BlockOps<Vector, T>::column(column, x, block_size, c);
+        lanczos_vecs.push_back(column);
     }
-    cout << "number of iterations = " << m
-         << ", number of Orthogonalisation = " << t << endl;
 }
 
 /**
  * @brief Calculate iterations for Lanczos algorithm
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @param num_of_eigenvec Number of the eigenvectors wanted
+ * @param size Number of vertices, 64-bit for the estimates of --dry-run
+ * @return The number of iterations, at most size
  */
 
-template <typename Vector, typename T>
-const int Lanczos<Vector, T>::getIteration(const int& num_of_eigenvec,
-                                           const int& size)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+const int Lanczos<Vector, T, Basis, Operator, Index>::getIteration(
+    const int& num_of_eigenvec, const int64_t& size)
 {
-    int scale, m;
+    int scale;
     if (num_of_eigenvec == 1) {
         scale = 4 * num_of_eigenvec;
     } else if (num_of_eigenvec == 2) {
@@ -127,55 +404,71 @@ const int Lanczos<Vector, T>::getIteration(const int& num_of_eigenvec,
         scale -= round(log10(std::sqrt(size)));
         scale = scale <= 0 ? 1 : scale;
     }
-    m = scale * std::sqrt(size) < size ? scale * std::sqrt(size) : size;
+    const double m = std::min<double>(scale * std::sqrt(size), size);
+    if (m > std::numeric_limits<int>::max()) {
+        throw std::out_of_range("Too many Lanczos iterations for int");
+    }
     return m;
 }
 
 /**
- * @brief The first component of Lanczos iteration fomular, Laplacian matrix *
- * vector
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @brief The length of the Lanczos vectors, the basis is indexed by int
+ *        whatever the index type of the graph
+ * @param g The graph
+ * @return The number of vertices, throw std::out_of_range if it does not
+ *         fit in int
  */
 
-template <typename Vector, typename T>
-Vector Lanczos<Vector, T>::multGraphVec(const Graph& g, const Vector& vec)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+int Lanczos<Vector, T, Basis, Operator, Index>::basisSize(
+    const BasicGraph<Index>& g)
 {
-    Vector prod(g.size());
-    for (auto it = g.cbegin(); it != g.cend(); it++) {
-        T temp = 0.0;
-        if (!it->second.empty()) {
-            for (const int& neighbour : it->second) {
-                temp += vec[neighbour];
-            }
-        }
-        prod[it->first] = it->second.size() * vec[it->first] - temp;
+    if (g.size() > std::numeric_limits<int>::max()) {
+        throw std::out_of_range("Too many vertices for the Lanczos basis");
     }
-    return prod;
+    return g.size();
 }
 
 /**
- * @brief Reorthogonalisation
- * @param FILL-ME-IN
- * @return FILL-ME-IN
+ * @brief Reorthogonalisation against the chosen Lanczos vectors
+ * @param against Indices of the Lanczos vectors
+ * @param w The unnormalised new Lanczos vector
+ * @return The norm of w
  */
 
-template <typename Vector, typename T>
-inline void Lanczos<Vector, T>::gramSchmidt(const int& k, Vector& v)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::reorthogonalise(
+    const std::vector<int>& against, Vector& w)
 {
 #ifdef VT_
     VT_TRACER("GramSchmidt");
 #endif
-    int size = v.size();
-    for (int i = 0; i < k; i++) {
-        T reorthog_dot_product = dot(lanczos_vecs[i], v);
-        // cout << "iter " << i << " gramSchmidt global dot product " <<
-        // reorthog_dot_product << endl;
-        for (int j = 0; j < size; j++) {
-            v[j] -= reorthog_dot_product * lanczos_vecs[i][j];
-        }
+    Timers::Scope timer("reorthogonalise");
+    gramSchmidt(lanczos_vecs, against, w);
+    return norm(w);
+}
+
+/**
+ * @brief Classical Gram-Schmidt, w minus its projections on the chosen
+ *        rows of the basis
+ * @param basis The orthonormal vectors
+ * @param against Indices of the rows of basis
+ * @param w The vector to orthogonalise
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+template <typename S>
+void Lanczos<Vector, T, Basis, Operator, Index>::gramSchmidt(
+    const LanczosBasis<S>& basis, const std::vector<int>& against, Vector& w)
+{
+    for (const int& i : against) {
+        auto basis_vec = basis[i];  // Prefetches basis[i + 1]
+        T reorthog_dot_product = VectorOps<Vector, T>::dot(basis_vec, w);
+        VectorOps<Vector, T>::axpy(w, basis_vec, -reorthog_dot_product);
     }
-    normalise(v);
 }
 
 /**
@@ -184,31 +477,26 @@ inline void Lanczos<Vector, T>::gramSchmidt(const int& k, Vector& v)
  * @return FILL-ME-IN
  */
 
-template <typename Vector, typename T>
-inline T Lanczos<Vector, T>::dot(const Vector& v1, const Vector& v2)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+template <typename V>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::dot(const V& v1,
+                                                         const Vector& v2)
 {
-    if (v1.size() != v2.size())
-        throw std::length_error("Lanczos - dot: The vector sizes don't match.");
-    int size = v1.size();
-    T dotprod = 0.0;
-    for (int index = 0; index < size; index++) {
-        dotprod += v1[index] * v2[index];
-    }
-    return dotprod;
+    return VectorOps<Vector, T>::dot(v1, v2);
 }
 
-template <typename Vector, typename T>
-inline T Lanczos<Vector, T>::norm(const Vector& vec)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::norm(const Vector& vec)
 {
-    T normret = 0.0;
-    for (const auto& x : vec) {
-        normret += x * x;
-    }
-    return sqrt(normret);
+    return std::sqrt(VectorOps<Vector, T>::dot(vec, vec));
 }
 
-template <typename Vector, typename T>
-inline T Lanczos<Vector, T>::l2norm(const Vector& alpha, const Vector& beta)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+inline T Lanczos<Vector, T, Basis, Operator, Index>::l2norm(const Vector& alpha,
+                                                     const Vector& beta)
 {
     T normret = 0.0;
     T col_sum = 0.0;
@@ -230,23 +518,67 @@ inline T Lanczos<Vector, T>::l2norm(const Vector& alpha, const Vector& beta)
     return normret;
 }
 
-template <typename Vector, typename T>
-inline Vector& Lanczos<Vector, T>::normalise(Vector& vec)
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+inline Vector& Lanczos<Vector, T, Basis, Operator, Index>::normalise(
+    Vector& vec)
 {
-    T normal = norm(vec);
-    for (auto& x : vec) {
-        x /= normal;
-    }
+    VectorOps<Vector, T>::scale(vec, vec, 1.0 / norm(vec));
     return vec;
 }
 
-template <typename Vector, typename T>
-Vector Lanczos<Vector, T>::init(const int& size)
+/**
+ * @brief Project the eigenvector of eigenvalue 0 out of each of the vectors,
+ *        the constant vector or null_ of a normalised operator
+ * @param x width vectors stored row by row
+ * @param width Number of vectors
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::deflate(Vector& x,
+                                                        const int& width)
+{
+    const int size = x.size() / width;
+    if (!null_.empty()) {
+        std::vector<T> dots(width, 0.0);
+        for (int i = 0; i < size; i++) {
+            for (int c = 0; c < width; c++) {
+                dots[c] += null_[i] * x[i * width + c];
+            }
+        }
+        reduce(dots);
+        for (int i = 0; i < size; i++) {
+            for (int c = 0; c < width; c++) {
+                x[i * width + c] -= dots[c] * null_[i];
+            }
+        }
+        return;
+    }
+    std::vector<T> sums(width + 1, 0.0);  // Column sums and number of rows
+    for (int i = 0; i < size; i++) {
+        for (int c = 0; c < width; c++) {
+            sums[c] += x[i * width + c];
+        }
+    }
+    sums[width] = size;
+    reduce(sums);
+    for (int i = 0; i < size; i++) {
+        for (int c = 0; c < width; c++) {
+            x[i * width + c] -= sums[c] / sums[width];
+        }
+    }
+}
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+Vector Lanczos<Vector, T, Basis, Operator, Index>::init(const int& size)
 {
     Vector vec(size);
     for (auto& x : vec) {
-        x = drand48();
+        x = RandomStream::uniform();
     }
+    deflate(vec);
     T normalise = norm(vec);
     for (auto& x : vec) {
         x /= normalise;
@@ -254,8 +586,39 @@ Vector Lanczos<Vector, T>::init(const int& size)
     return vec;
 }
 
-template <typename Vector, typename T>
-void Lanczos<Vector, T>::print_tri_mat()
+/**
+ * @brief The start vector of a warm start, the sum of the normalised
+ *        previous eigenvectors orthogonal to the constant. Random if they
+ *        are (nearly) constant, e.g. all zero.
+ * @param start The previous eigenvectors
+ * @param size Number of vertices
+ */
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+Vector Lanczos<Vector, T, Basis, Operator, Index>::init(
+    const std::vector<Vector>& start, const int& size)
+{
+    Vector vec(size, 0.0), x;
+    for (const auto& previous : start) {
+        x = previous;
+        deflate(x);
+        T length = norm(x);
+        if (length > 0.0) {
+            VectorOps<Vector, T>::axpy(vec, x, 1.0 / length);
+        }
+    }
+    T length = norm(vec);
+    if (!(length > 1e-8)) {
+        return init(size);
+    }
+    VectorOps<Vector, T>::scale(vec, vec, 1.0 / length);
+    return vec;
+}
+
+template <typename Vector, typename T, typename Basis, typename Operator,
+          typename Index>
+void Lanczos<Vector, T, Basis, Operator, Index>::print_tri_mat()
 {
     int size = alpha.size();
     for (int row = 0; row < size; row++) {
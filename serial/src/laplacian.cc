@@ -0,0 +1,226 @@
+/**
+ * @file laplacian.cc
+ * @brief The Laplacian matrix of the graph
+ * @author Ken Hu, xnchnhu@gmail.com
+ */
+
+#ifndef LAPLACIAN_CC_
+#define LAPLACIAN_CC_
+
+#include "laplacian.h"
+#include <algorithm>
+#include <cmath>
+#include "timers.h"
+
+#ifdef VT_
+#include "vt_user.h"
+#endif
+
+/**
+ * @brief Copy the weights of a weighted graph into one array, read in step
+ *        with the adjacency sets by multiply, and the degree scaling of a
+ *        normalised operator
+ * @param graph The graph, kept by reference
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+Laplacian<Vector, T, Operator, Index>::Laplacian(
+    const BasicGraph<Index>& graph)
+    : g(graph)
+{
+    if (g.weighted()) {
+        for (auto it = g.cbegin(); it != g.cend(); it++) {
+            for (const Index& neighbour : it->second) {
+                weights.push_back(g.getWeight(it->first, neighbour));
+            }
+        }
+    }
+    if (Operator::normalised) {
+        scale.resize(g.size());
+        for (auto it = g.cbegin(); it != g.cend(); it++) {
+            T d = degree(it);
+            scale[it->first] = d > 0.0 ? 1.0 / std::sqrt(d) : 0.0;
+        }
+    }
+}
+
+/**
+ * @brief Laplacian matrix * vectors, each neighbour index is loaded once for
+ *        the width values of a vertex
+ * @param x The vectors, row by row
+ * @param y Returns L * x
+ * @param width Number of vectors
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::multiply(const Vector& x,
+                                                     Vector& y,
+                                                     const int& width)
+{
+    y.resize(x.size());
+    multiply(x.data(), y.data(), width);
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::multiply(const T* x, T* y,
+                                                     const int& width)
+{
+#ifdef VT_
+    VT_TRACER("Laplacian::multiply");
+#endif
+    Timers::Scope timer("spmv");
+    if (weights.empty()) {
+        multiplyRows<false, Operator::normalised>(x, y, width);
+    } else {
+        multiplyRows<true, Operator::normalised>(x, y, width);
+    }
+}
+
+/**
+ * @brief The rows of L * x, the unweighted rows are degree * x_i - sum x_j,
+ *        the weighted ones sum w_ij * (x_i - x_j) with the weights read in
+ *        order from one array. The normalised rows are
+ *        x_i - s_i * sum w_ij * s_j * x_j with s = D^-1/2.
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+template <bool Weighted, bool Normalised>
+void Laplacian<Vector, T, Operator, Index>::multiplyRows(const T* x, T* y,
+                                                         const int& width)
+{
+    const T* weight = weights.data();
+    for (auto it = g.cbegin(); it != g.cend(); it++) {
+        T* row = &y[it->first * width];
+        const T* own_row = &x[it->first * width];
+        if (Normalised) {
+            const T s = scale[it->first];
+            for (int c = 0; c < width; c++) {
+                row[c] = s > 0.0 ? own_row[c] : 0.0;
+            }
+            for (const Index& neighbour : it->second) {
+                const T* neighbour_row = &x[neighbour * width];
+                T w = s * scale[neighbour];
+                if (Weighted) w *= *weight++;
+                for (int c = 0; c < width; c++) {
+                    row[c] -= w * neighbour_row[c];
+                }
+            }
+            continue;
+        }
+        if (Weighted) {
+            for (int c = 0; c < width; c++) {
+                row[c] = 0.0;
+            }
+            for (const Index& neighbour : it->second) {
+                const T* neighbour_row = &x[neighbour * width];
+                const T w = *weight++;
+                for (int c = 0; c < width; c++) {
+                    row[c] += w * (own_row[c] - neighbour_row[c]);
+                }
+            }
+            continue;
+        }
+        const T degree = it->second.size();
+        for (int c = 0; c < width; c++) {
+            row[c] = degree * own_row[c];
+        }
+        for (const Index& neighbour : it->second) {
+            const T* neighbour_row = &x[neighbour * width];
+            for (int c = 0; c < width; c++) {
+                row[c] -= neighbour_row[c];
+            }
+        }
+    }
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+T Laplacian<Vector, T, Operator, Index>::degree(
+    typename BasicGraph<Index>::const_iterator it) const
+{
+    if (!g.weighted()) {
+        return it->second.size();
+    }
+    T sum = 0.0;
+    for (const Index& neighbour : it->second) {
+        sum += g.getWeight(it->first, neighbour);
+    }
+    return sum;
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+Vector Laplacian<Vector, T, Operator, Index>::diagonal() const
+{
+    Vector degrees(g.size());
+    for (auto it = g.cbegin(); it != g.cend(); it++) {
+        if (Operator::normalised) {
+            degrees[it->first] = scale[it->first] > 0.0 ? 1.0 : 0.0;
+        } else {
+            degrees[it->first] = degree(it);
+        }
+    }
+    return degrees;
+}
+
+/**
+ * @brief Gershgorin bound of the largest eigenvalue, a row of L has the
+ *        (weighted) degree on the diagonal and as the sum of the off-diagonal
+ *        magnitudes. The normalised eigenvalues are at most 2.
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+T Laplacian<Vector, T, Operator, Index>::spectralBound() const
+{
+    if (Operator::normalised) {
+        return 2.0;
+    }
+    T max_degree = 0.0;
+    for (auto it = g.cbegin(); it != g.cend(); it++) {
+        max_degree = std::max<T>(max_degree, degree(it));
+    }
+    return 2.0 * max_degree;
+}
+
+template <typename Vector, typename T, typename Operator, typename Index>
+Vector Laplacian<Vector, T, Operator, Index>::nullVector() const
+{
+    Vector null;
+    if (!Operator::normalised) {
+        return null;
+    }
+    null.resize(g.size());
+    T sum = 0.0;  // The volume of the graph
+    for (Index i = 0; i < g.size(); i++) {
+        null[i] = scale[i] > 0.0 ? 1.0 / scale[i] : 0.0;
+        sum += null[i] * null[i];
+    }
+    for (auto& entry : null) {
+        entry /= std::sqrt(sum);
+    }
+    return null;
+}
+
+/**
+ * @brief The random walk Laplacian D^-1 L = D^-1/2 (D^-1/2 L D^-1/2) D^1/2
+ *        has the eigenvectors D^-1/2 u, normalised again
+ * @param u A (local) eigenvector of the symmetric normalised Laplacian
+ */
+
+template <typename Vector, typename T, typename Operator, typename Index>
+void Laplacian<Vector, T, Operator, Index>::toEigenvector(Vector& u) const
+{
+    if (!Operator::randomWalk) {
+        return;
+    }
+    T sum = 0.0;
+    for (unsigned int i = 0; i < u.size(); i++) {
+        u[i] *= scale[i];
+        sum += u[i] * u[i];
+    }
+    if (sum > 0.0) {
+        for (auto& entry : u) {
+            entry /= std::sqrt(sum);
+        }
+    }
+}
+
+#endif
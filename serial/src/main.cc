@@ -5,13 +5,19 @@
  */
 
 #include <boost/program_options.hpp>
-#include <boost/timer.hpp>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <string>
 
 #include "analysis.h"
+#include "csr.h"
 #include "graph.h"
+#include "lanczos.h"
+#include "memory_usage.h"
 #include "partition.h"
+#include "timers.h"
+#include "trace.h"
 
 #ifdef VT_
 #include "vt_user.h"
@@ -37,6 +43,26 @@ int main(int argc, char* argv[])
     ("vertices,v", po::value<int>(), ":set number of vertices, default: 20")
     ("colours,c", po::value<int>(), ":set number of colours, has to be the power of 2, default: 2")
     ("input-file,f", po::value<string>(), ":input file name")
+    ("generate", po::value<string>(), ":generate a random graph of --vertices vertices: erdos-renyi, rmat or geometric")
+    ("edges", po::value<long long>(), ":number of edges of --generate, default: 8 per vertex")
+    ("seed", po::value<unsigned long long>(), ":seed of --generate, default: 1")
+    ("streaming", po::value<int>(), ":read the input file in two passes with the given number of threads (0 for all cores)")
+    ("reorder", po::value<string>(), ":relabel vertices for locality: rcm, bfs or degree")
+    ("mixed-precision", ":store the Lanczos vectors in float, default: false")
+    ("spill-dir", po::value<string>(), ":store the Lanczos vectors in a file in the directory, default: in memory")
+    ("block-size", po::value<int>(), ":block Lanczos with the given block size, default: 1")
+    ("chebyshev-degree", po::value<int>(), ":Chebyshev filter the Lanczos start vector with the given degree, default: 0 (off)")
+    ("min-component-size", po::value<int>(), ":partition the connected components with at least the given number of vertices on their own, assign the smaller ones whole, default: 0 (off)")
+    ("eigensolver", po::value<string>(), ":lanczos or lobpcg, default: lanczos")
+    ("preconditioner", po::value<string>(), ":preconditioner of LOBPCG: none, jacobi or smoother, default: jacobi")
+    ("laplacian", po::value<string>(), ":operator of Lanczos: combinatorial, normalised or random-walk, default: combinatorial")
+    ("warm-start", po::value<string>(), ":start the eigensolver from the vectors in the file of --save-vectors and stop once converged")
+    ("warm-start-colours", po::value<string>(), ":start the eigensolver from the colours in the dot file of --output and stop once converged")
+    ("save-vectors", po::value<string>(), ":save the eigenvectors into the file for --warm-start")
+    ("precision-report", ":compare the double and float Lanczos vectors")
+    ("timers", po::value<string>(), ":write the wall-clock times of the phases into the file as JSON")
+    ("dry-run", ":print the memory estimated from --vertices and --edges or the input file, nothing else is done")
+    ("trace", po::value<string>(), ":write the timeline of the phases into the file as a Chrome trace, needs cmake -DTrace_=ON")
     ;
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -52,16 +78,54 @@ int main(int argc, char* argv[])
          sub_graphs = vm.count("colours"),
          output = vm.count("output"),
          gram_schmidt = vm.count("gram-schmidt"),
-         benchmarks = vm.count("benchmarks");
+         benchmarks = vm.count("benchmarks"),
+         mixed_precision = vm.count("mixed-precision"),
+         precision_report = vm.count("precision-report");
 
     Graph* g;
 
+    if (vm.count("dry-run")) {
+        int64_t n = random_graph ? vm["vertices"].as<int>() : 20;
+        int64_t edges =
+            vm.count("edges") ? vm["edges"].as<long long>() : 8 * n;
+        if (read_graph) {
+            countDotFormat(vm["input-file"].as<string>(), n, edges);
+        }
+        int eigenvectors = log2(sub_graphs ? vm["colours"].as<int>() : 2);
+        int m = Lanczos<vector<double>, double>::getIteration(eigenvectors, n);
+        m = max<int64_t>(1, min<int64_t>(m, n - 1));
+        size_t basis = mixed_precision ? sizeof(float) : sizeof(double);
+        MemoryUsage::report(cout, {MemoryUsage::estimate(n, edges, m,
+                                                         eigenvectors, 1,
+                                                         basis, false)},
+                            {});
+        return 0;
+    }
+    if (vm.count("trace")) {
+#ifndef Trace_
+        cout << "WARNING: built without Trace_, the trace is empty" << endl;
+#endif
+        Trace::start();
+    }
     if (random_graph && read_graph) {
         cout << "WARNING: you can either set vertices or read graphs" << endl;
         cout << desc << endl;
         return 1;
     }
-    if (random_graph) {
+    Timers::Scope timer_read("read");
+    if (random_graph && vm.count("generate")) {
+        vertices = vm["vertices"].as<int>();
+        long long edges = vm.count("edges") ? vm["edges"].as<long long>()
+                                            : 8LL * vertices;
+        unsigned long long seed =
+            vm.count("seed") ? vm["seed"].as<unsigned long long>() : 1;
+        Generator generator(Generator::model(vm["generate"].as<string>()),
+                            vertices, edges, seed);
+        g = new Graph;
+        g->generate(generator);
+        cout << "generated: vertices = " << vertices
+             << ", edges = " << g->edgesNum() << "." << endl;
+    } else if (random_graph) {
         vertices = vm["vertices"].as<int>();
         cout << "argument: vertices =  " << vertices << "." << endl;
         g = new Graph(vertices);
@@ -69,13 +133,24 @@ int main(int argc, char* argv[])
         g = new Graph;
         filename = vm["input-file"].as<string>();
         cout << "Input file is \"" << filename << "\"" << endl;
-        g->readDotFormat(filename);
+        if (vm.count("streaming")) {
+            g->readDotFormatStreaming(filename, vm["streaming"].as<int>());
+        } else {
+            g->readDotFormat(filename);
+        }
     } else {
         cout << desc << endl;
         vertices = 20;
         cout << "default argument: vertices = " << vertices << "." << endl;
         g = new Graph(vertices);
     }
+    timer_read.stop();
+    if (vm.count("reorder")) {
+        int bandwidth = Analysis::bandwidth(*g);
+        g->reorder(vm["reorder"].as<string>());
+        cout << "reorder: bandwidth " << bandwidth << " -> "
+             << Analysis::bandwidth(*g) << endl;
+    }
     if (sub_graphs) {
         colours = vm["colours"].as<int>();
         cout << "argument: colours = " << colours << "." << endl;
@@ -86,8 +161,46 @@ int main(int argc, char* argv[])
 
     if (benchmarks) {
         // Analysis::benchmarks(gram_schmidt);
+    } else if (precision_report) {
+        Analysis::precisionReport(*g, colours, gram_schmidt);
     } else {
-        Partition partition(*g, colours, gram_schmidt);
+        PartitionOptions options(gram_schmidt);
+        options.mixedPrecision = mixed_precision;
+        if (vm.count("spill-dir")) {
+            options.spillDirectory = vm["spill-dir"].as<string>();
+        }
+        if (vm.count("block-size")) {
+            options.blockSize = vm["block-size"].as<int>();
+        }
+        if (vm.count("chebyshev-degree")) {
+            options.chebyshevDegree = vm["chebyshev-degree"].as<int>();
+        }
+        if (vm.count("min-component-size")) {
+            options.minComponentSize = vm["min-component-size"].as<int>();
+        }
+        if (vm.count("eigensolver")) {
+            options.eigensolver = vm["eigensolver"].as<string>();
+        }
+        if (vm.count("preconditioner")) {
+            options.preconditioner = vm["preconditioner"].as<string>();
+        }
+        if (vm.count("laplacian")) {
+            options.laplacian = vm["laplacian"].as<string>();
+        }
+        if (vm.count("warm-start")) {
+            options.startVectors =
+                g->readVectors(vm["warm-start"].as<string>());
+        } else if (vm.count("warm-start-colours")) {
+            options.startVectors = Partition::colourVectors(
+                g->readColours(vm["warm-start-colours"].as<string>()),
+                colours);
+        }
+        Partition partition(*g, colours, options);
+        if (vm.count("save-vectors")) {
+            g->outputVectors(vm["save-vectors"].as<string>(),
+                             partition.eigenvectors());
+        }
+        g->restoreOrder();
         if (output) {
             string filename("./output/serial_");
             filename += to_string(g->size());
@@ -105,6 +218,17 @@ int main(int argc, char* argv[])
         Analysis::cutEdgeVertexTable(*g, partition.ritzValues);
     }
 
+    if (vm.count("timers")) {
+        ofstream Output(vm["timers"].as<string>());
+        Timers::report(Output, {Timers::entries()});
+    }
+    if (vm.count("trace")) {
+        ofstream Output(vm["trace"].as<string>());
+        Trace::write(Output, {Trace::json(0)});
+    }
+    MemoryUsage::report(cout, {MemoryUsage::entries()},
+                        {MemoryUsage::peakRss()});
+
     delete g;
     return 0;
 }
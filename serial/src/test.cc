@@ -92,11 +92,13 @@ bool Tests::testLanczos()
     // Create the identity matrix used as input for TQLI
     vector<vector<double>> eigenvecs;
     tqli(alpha, beta, eigenvecs);
-    vector<double> eigenvalues = {0,       1.20972, 1.505, 2,
-                                  2.86246, 4.32623, 5,     7.09659};
+    // The zero eigenvalue of the constant vector is deflated
+    vector<double> eigenvalues = {1.20972, 1.505,   2, 2.86246,
+                                  4.32623, 5, 7.09659};
 
     sort(alpha.begin(), alpha.end());
-    for (int i = 0; i < size; i++) {
+    if ((int)alpha.size() != size - 1) return false;
+    for (int i = 0; i < size - 1; i++) {
         if (abs(alpha[i] - eigenvalues[i]) > 1e-5) return false;
     }
     return true;
@@ -4,13 +4,22 @@
  * @author Ken Hu, xnchnhu@gmail.com
  */
 
+#include <algorithm>
 #include <boost/mpi.hpp>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <utility>
+#include "generator.h"
 #include "graph.h"
 #include "gtest/gtest.h"
+#include "lanczos.h"
+#include "lobpcg.h"
 #include "partition.h"
+#include "repartition.h"
+#include "tqli.h"
 
 namespace mpi = boost::mpi;
 using namespace std;
@@ -66,6 +75,313 @@ TEST_F(ParallelTest, testPartition)
     }
 }
 
+/**
+ * @brief Block Lanczos over the processes spanning the whole space orthogonal
+ *        to the constant vector gives all the non-zero eigenvalues
+ */
+TEST_F(ParallelTest, testBlockLanczos)
+{
+    int num = 10;
+    g.readDotFormat(filePath + "/test_partition_10.dot", num);
+    Lanczos<vector<double>, double> lanczos(g, num, true, "", 3);
+    ASSERT_EQ((int)lanczos.block_tri.size(), num - 1);
+    vector<double> eigenvalues;
+    vector<vector<double>> eigenvecs;
+    symmetricEigen(lanczos.block_tri, eigenvalues, eigenvecs);
+    vector<double> expected = {0.466941, 0.857996, 2,       2.81842, 3.17936,
+                               4,        4.12601,  4.88488, 5.66639};
+    sort(eigenvalues.begin(), eigenvalues.end());
+    for (int i = 0; i < num - 1; i++) {
+        EXPECT_LT(abs(eigenvalues[i] - expected[i]), 1e-5);
+    }
+}
+
+/**
+ * @brief The normalised Laplacian over the processes, the non-zero
+ *        eigenvalues are in (0, 2] and the random walk operator partitions
+ *        all the vertices into two colours
+ */
+TEST_F(ParallelTest, testNormalisedLaplacian)
+{
+    int num = 10;
+    g.readDotFormat(filePath + "/test_partition_10.dot", num);
+    Lanczos<vector<double>, double, vector<double>, SymmetricNormalised>
+        lanczos(g, num, true, "", 3);
+    ASSERT_EQ((int)lanczos.block_tri.size(), num - 1);
+    vector<double> eigenvalues;
+    vector<vector<double>> eigenvecs;
+    symmetricEigen(lanczos.block_tri, eigenvalues, eigenvecs);
+    for (const double& value : eigenvalues) {
+        EXPECT_GT(value, 1e-8);
+        EXPECT_LT(value, 2.0 + 1e-8);
+    }
+
+    PartitionOptions options(true);
+    options.laplacian = "random-walk";
+    Partition partition(g, 2, options);
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        int colour = g.getColour(it->first);
+        EXPECT_TRUE(colour == 0 || colour == 1);
+    }
+}
+
+/**
+ * @brief Each process generates its slice of the edges, together they are
+ *        the graph generated in one piece
+ */
+TEST_F(ParallelTest, testGenerators)
+{
+    Generator generator(Generator::Rmat, 1000, 4000, 7);
+    g.generate(generator, 2);
+    set<pair<int, int>> unique;
+    for (const auto& edge : generator.edges(0, 1, 1)) {
+        int src = edge.first, dest = edge.second;
+        if (src != dest) {
+            unique.insert(minmax(src, dest));
+        }
+    }
+    int64_t local_degrees = 0, global_degrees = 0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        local_degrees += it->second.size();
+    }
+    mpi::all_reduce(world, local_degrees, global_degrees,
+                    std::plus<int64_t>());
+    EXPECT_EQ(global_degrees, 2 * (int64_t)unique.size());
+    EXPECT_EQ(g.globalSize(), 1000);
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            pair<int, int> edge = minmax(it->first, neighbour);
+            EXPECT_TRUE(unique.count(edge));
+        }
+    }
+}
+
+/**
+ * @brief LOBPCG with the vectors distributed over the processes
+ */
+TEST_F(ParallelTest, testLobpcg)
+{
+    typedef Lobpcg<vector<double>, double> Solver;
+    int num = 8;
+    g.readDotFormat(filePath + "/par_test_8.dot", num);
+    Solver lobpcg(g, 3, Solver::Smoother, 500, 1e-8);
+    EXPECT_TRUE(lobpcg.converged);
+    vector<double> expected = {1.20972, 1.505, 2};
+    ASSERT_EQ(lobpcg.eigenvalues.size(), expected.size());
+    for (unsigned int i = 0; i < expected.size(); i++) {
+        EXPECT_LT(abs(lobpcg.eigenvalues[i] - expected[i]), 1e-5);
+    }
+}
+
+/**
+ * @brief Label propagation over the processes finds the components of two
+ *        copies of test_partition_10 and three tiny components
+ */
+TEST_F(ParallelTest, testComponents)
+{
+    int num = 30;
+    g.readDotFormat(filePath + "/test_components_30.dot", num);
+    vector<int> component = g.components();
+    ASSERT_EQ((int)component.size(), g.size());
+    for (int i = 0; i < g.size(); i++) {
+        int vertex = g.globalIndex(i);
+        int first = vertex < 20 ? vertex / 10 * 10 : vertex < 23 ? 20 : 23;
+        EXPECT_EQ(component[i], vertex < 25 ? first : 25);
+    }
+    map<int, int> sizes = g.globalCounts(component);
+    map<int, int> expected_sizes = {{0, 10}, {10, 10}, {20, 3}, {23, 2},
+                                    {25, 5}};
+    EXPECT_EQ(sizes, expected_sizes);
+
+    PartitionOptions options(true);
+    options.minComponentSize = 8;
+    Partition partition(g, 2, options);
+    vector<int> colours;
+    for (int i = 0; i < g.size(); i++) {
+        colours.push_back(g.getColour(g.globalIndex(i)));
+    }
+    map<int, int> colour_sizes = g.globalCounts(colours);
+    ASSERT_EQ(colour_sizes.size(), 2u);
+    EXPECT_EQ(colour_sizes[0] + colour_sizes[1], num);
+}
+
+/**
+ * @brief Partition a file as a graph with Index ids over the processes
+ * @return colour[local index], the Ritz values in ritz
+ */
+template <typename Index>
+static vector<int> partitionColours(const string& filename, const Index& num,
+                                    const PartitionOptions& options,
+                                    vector<double>& ritz)
+{
+    BasicGraph<Index> graph;
+    graph.readDotFormat(filename, num);
+    Partition partition(graph, 4, options);
+    ritz = partition.ritzValues;
+    vector<int> colours;
+    for (Index i = 0; i < graph.size(); i++) {
+        colours.push_back(graph.getColour(graph.globalIndex(i)));
+    }
+    return colours;
+}
+
+/**
+ * @brief Graph and Graph64 give the same partitions over the processes, by
+ *        LOBPCG (its start vectors are seeded by the rank) on the whole
+ *        graph and by components
+ */
+TEST_F(ParallelTest, testIndexTypes)
+{
+    auto compare = [&](const string& file, const int& num,
+                       const PartitionOptions& options) {
+        vector<double> narrow_ritz, wide_ritz;
+        vector<int> narrow_colours = partitionColours<int32_t>(
+            filePath + file, num, options, narrow_ritz);
+        vector<int> wide_colours = partitionColours<int64_t>(
+            filePath + file, num, options, wide_ritz);
+        EXPECT_EQ(narrow_colours, wide_colours) << file;
+        ASSERT_EQ(narrow_ritz.size(), wide_ritz.size());
+        for (unsigned int i = 0; i < narrow_ritz.size(); i++) {
+            EXPECT_NEAR(narrow_ritz[i], wide_ritz[i], 1e-10);
+        }
+    };
+    PartitionOptions options;
+    options.eigensolver = "lobpcg";
+    compare("/par_test_1024.dot", 1024, options);
+    options.minComponentSize = 8;
+    compare("/test_components_30.dot", 30, options);
+}
+
+/**
+ * @brief The saved eigenvectors are read back by the owners of the vertices
+ *        and warm start Lanczos over the processes
+ */
+TEST_F(ParallelTest, testWarmStart)
+{
+    int num = 1024;
+    g.readDotFormat(filePath + "/par_test_1024.dot", num);
+    PartitionOptions options;
+    options.eigensolver = "lobpcg";
+    Partition cold(g, 4, options);
+    g.outputVectors("warm_start_vectors.txt", cold.eigenvectors());
+    world.barrier();
+    vector<vector<double>> start = g.readVectors("warm_start_vectors.txt");
+    world.barrier();
+    if (world.rank() == 0) {
+        remove("warm_start_vectors.txt");
+    }
+    ASSERT_EQ(start.size(), 2u);
+    for (unsigned int r = 0; r < start.size(); r++) {
+        ASSERT_EQ((int)start[r].size(), g.size());
+        for (int i = 0; i < g.size(); i++) {
+            EXPECT_LT(abs(start[r][i] - cold.eigenvectors()[r][i]), 1e-12);
+        }
+    }
+    Lanczos<vector<double>, double> warm(g, 2, true, "", 1, 0, start);
+    EXPECT_TRUE(warm.converged);
+    for (unsigned int r = 0; r < start.size(); r++) {
+        vector<double> ritz(warm.alpha.begin(), warm.alpha.end()), z;
+        vector<double> beta(warm.beta.begin(), warm.beta.end());
+        tqliLastRow(ritz, beta, z);
+        sort(ritz.begin(), ritz.end());
+        EXPECT_LT(abs(ritz[r] - cold.ritzValues[r]), 1e-6);
+    }
+}
+
+/**
+ * @brief Every process updates the ends of the batch it owns, and they all
+ *        agree on recomputing
+ */
+TEST_F(ParallelTest, testRepartition)
+{
+    int num = 1024;
+    g.readDotFormat(filePath + "/par_test_1024.dot", num);
+    auto adjacency = [&]() {
+        int local = 0, global = 0;
+        for (auto it = g.cbegin(); it != g.cend(); ++it) {
+            local += it->second.size();
+        }
+        mpi::all_reduce(world, local, global, std::plus<int>());
+        return global;
+    };
+    Repartition::Edges inserted;
+    set<pair<int, int>> unique;
+    for (int i = 0; i < 300; i++) {
+        int from = i * 3 % num, to = (i * 37 + 512) % num;
+        if (from != to && unique.insert(minmax(from, to)).second) {
+            inserted.push_back({from, to});
+        }
+    }
+    g.removeEdges(inserted);
+    int before = adjacency();
+    Repartition repartition(g, 2);
+    bool recomputed = repartition.update(inserted, {}), all = false;
+    mpi::all_reduce(world, recomputed, all, std::logical_and<bool>());
+    EXPECT_EQ(recomputed, all);
+    EXPECT_EQ(adjacency(), before + 2 * (int)inserted.size());
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            EXPECT_GE(g.getColour(neighbour), 0);
+        }
+    }
+    repartition.update({}, inserted);
+    EXPECT_EQ(adjacency(), before);
+}
+
+/**
+ * @brief Each process reads the weights of its edges, they are kept through
+ *        reordering and the partition of a ring cuts its two light edges
+ */
+TEST_F(ParallelTest, testWeightedGraph)
+{
+    int num = 16;
+    auto light = [](int a, int b) {
+        pair<int, int> edge = minmax(a, b);
+        return edge == make_pair(3, 4) || edge == make_pair(11, 12);
+    };
+    if (world.rank() == 0) {
+        ofstream Output("weighted_test.dot");
+        Output << "Undirected Graph {" << endl;
+        for (int vertex = 0; vertex < num; vertex++) {
+            Output << vertex << ";" << endl;
+        }
+        for (int vertex = 0; vertex < num; vertex++) {
+            for (int next : {(vertex + 1) % num, (vertex + num - 1) % num}) {
+                Output << vertex << "--" << next << " [weight="
+                       << (light(vertex, next) ? 0.1 : 1.0) << "] ;" << endl;
+            }
+        }
+        Output << "}" << endl;
+    }
+    world.barrier();
+    g.readDotFormat("weighted_test.dot", num);
+    world.barrier();
+    if (world.rank() == 0) {
+        remove("weighted_test.dot");
+    }
+    g.reorder("rcm");
+    g.restoreOrder();
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            EXPECT_EQ(g.getWeight(it->first, neighbour),
+                      light(it->first, neighbour) ? 0.1 : 1.0);
+        }
+    }
+
+    Partition partition(g, 2, PartitionOptions(true));
+    g.updateHaloColours();
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            EXPECT_EQ(g.getColour(it->first) != g.getColour(neighbour),
+                      light(it->first, neighbour));
+        }
+    }
+
+    // An edge inserted again without a weight has weight 1 at its owners
+    g.insertEdges({{4, 3}});
+    EXPECT_EQ(g.getWeight(3, 4), 1.0);
+}
+
 /**
  * @brief Test the read function, can not verify the correctness in unit
  *        testing, but can test the performance
@@ -84,6 +400,49 @@ TEST_F(ParallelTest, testReadGraph)
     }
 }
 
+/**
+ * @brief Even assignment covers all the vertices when the number of vertices
+ *        can't be divided by the number of processes
+ */
+TEST_F(ParallelTest, testReadGraphRemainder)
+{
+    int num = 10;
+    g.readDotFormat(filePath + "/test_partition_10.dot", num);
+    int global_size = 0, local_degrees = 0, global_degrees = 0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        local_degrees += it->second.size();
+    }
+    mpi::all_reduce(world, g.size(), global_size, std::plus<int>());
+    mpi::all_reduce(world, local_degrees, global_degrees, std::plus<int>());
+
+    EXPECT_EQ(num, global_size);
+    EXPECT_EQ(2 * 14, global_degrees);
+}
+
+/**
+ * @brief Balanced assignment: every vertex is owned by exactly one process and
+ *        the number of non-zeros on each process is close to the average
+ */
+TEST_F(ParallelTest, testReadGraphBalanced)
+{
+    int num = 1024;
+    g.readDotFormatBalanced(filePath + "/par_test_1024.dot", num);
+    int global_size = 0, local_nnz = g.size(), max_nnz = 0, global_nnz = 0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        local_nnz += it->second.size();
+    }
+    mpi::all_reduce(world, g.size(), global_size, std::plus<int>());
+    mpi::all_reduce(world, local_nnz, global_nnz, std::plus<int>());
+    mpi::all_reduce(world, local_nnz, max_nnz, mpi::maximum<int>());
+
+    EXPECT_EQ(num, global_size);
+    EXPECT_EQ(num, (int)g.global_rank_map.size());
+    for (int i = 0; i < g.size(); i++) {
+        EXPECT_EQ(g.rank(), g.global_rank_map[g.globalIndex(i)]);
+    }
+    EXPECT_LE(max_nnz - global_nnz / world.size(), 16);
+}
+
 /**
  * @brief Test reading the vertices with same colours and corresponding edges
  */
@@ -100,6 +459,85 @@ TEST_F(ParallelTest, testReadGraphByColour)
     }
 }
 
+/**
+ * @brief Rebalance the cluster assignment, the vertices and edges are kept and
+ *        the non-zeros on each process are close to the average
+ */
+TEST_F(ParallelTest, testRebalance)
+{
+    int num = 1024;
+    g.readDotFormatByColour(filePath + "/par_test_1024_4s.dot", num);
+    int local_degrees = 0, global_degrees = 0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        local_degrees += it->second.size();
+    }
+    mpi::all_reduce(world, local_degrees, global_degrees, std::plus<int>());
+
+    EXPECT_TRUE(g.rebalance(1.0));
+    EXPECT_FALSE(g.rebalance(1.1));
+
+    int global_size = 0, local_nnz = g.size(), global_nnz = 0, max_nnz = 0;
+    for (auto it = g.cbegin(); it != g.cend(); ++it) {
+        local_nnz += it->second.size();
+    }
+    mpi::all_reduce(world, g.size(), global_size, std::plus<int>());
+    mpi::all_reduce(world, local_nnz, global_nnz, std::plus<int>());
+    mpi::all_reduce(world, local_nnz, max_nnz, mpi::maximum<int>());
+
+    EXPECT_EQ(num, global_size);
+    EXPECT_EQ(num + global_degrees, global_nnz);
+    EXPECT_LE(max_nnz - global_nnz / world.size(), 16);
+    for (int i = 0; i < g.size(); i++) {
+        EXPECT_EQ(i, g.localIndex(g.globalIndex(i)));
+        EXPECT_EQ(g.rank(), g.global_rank_map[g.globalIndex(i)]);
+    }
+    Partition partition(g, 4, true);
+}
+
+/**
+ * @brief Reordering reduces the edges between processes in even assignment,
+ *        the graph is restored to the input indices
+ */
+TEST_F(ParallelTest, testReorder)
+{
+    int num = 1024;
+    g.readDotFormat(filePath + "/par_test_1024.dot", num);
+    int64_t halo_edges = 0, halo_edges_reordered = 0;
+    int global_size = 0;
+    mpi::all_reduce(world, g.haloEdgesNum(), halo_edges,
+                    std::plus<int64_t>());
+
+    g.reorder("rcm");
+    mpi::all_reduce(world, g.haloEdgesNum(), halo_edges_reordered,
+                    std::plus<int64_t>());
+    mpi::all_reduce(world, g.size(), global_size, std::plus<int>());
+    EXPECT_EQ(num, global_size);
+    EXPECT_LT(halo_edges_reordered, halo_edges);
+
+    Partition partition(g, 4, true);
+    g.restoreOrder();
+    Graph input;
+    input.readDotFormat(filePath + "/par_test_1024.dot", num);
+    // Compare the checksums of the edges with the input graph
+    long long local_sum = 0, sum = 0, local_input_sum = 0, input_sum = 0;
+    for (int i = 0; i < g.size(); i++) {
+        int vertex = g.globalIndex(i);
+        EXPECT_EQ(i, g.localIndex(vertex));
+        EXPECT_EQ(g.rank(), g.global_rank_map[vertex]);
+        for (const int& neighbour : g.find(vertex)->second) {
+            local_sum += (long long)vertex * num + neighbour;
+        }
+    }
+    for (auto it = input.cbegin(); it != input.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            local_input_sum += (long long)it->first * num + neighbour;
+        }
+    }
+    mpi::all_reduce(world, local_sum, sum, std::plus<long long>());
+    mpi::all_reduce(world, local_input_sum, input_sum, std::plus<long long>());
+    EXPECT_EQ(input_sum, sum);
+}
+
 /**
  * @brief Cluster assignment: test the partition with partitioned graph
  */
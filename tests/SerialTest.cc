@@ -9,13 +9,26 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <utility>
 #include "analysis.h"
+#include "chebyshev.h"
+#include "csr.h"
+#include "generator.h"
 #include "graph.h"
 #include "gtest/gtest.h"
+#include "kernels.h"
 #include "lanczos.h"
+#include "lobpcg.h"
+#include "memory_usage.h"
 #include "partition.h"
+#include "repartition.h"
+#include "timers.h"
 #include "tqli.h"
+#include "trace.h"
 
 using namespace std;
 
@@ -57,6 +70,38 @@ TEST_F(SerialTest, testReadGraphWithColour)
     EXPECT_EQ(g.subgraphsNum(), 4);
 }
 
+/**
+ * @brief Reordering keeps the graph, reduces the bandwidth and the colours are
+ *        mapped back to the input indices
+ */
+TEST_F(SerialTest, testReorder)
+{
+    g.readDotFormat(filePath + "/test_1000.dot");
+    Graph input;
+    input.readDotFormat(filePath + "/test_1000.dot");
+    int bandwidth = Analysis::bandwidth(g);
+
+    for (const char* ordering : {"rcm", "bfs", "degree"}) {
+        Graph reordered;
+        reordered.readDotFormat(filePath + "/test_1000.dot");
+        reordered.reorder(ordering);
+        EXPECT_EQ(1000, reordered.size());
+        EXPECT_EQ(input.edgesNum(), reordered.edgesNum());
+    }
+    g.reorder("rcm");
+    EXPECT_LT(Analysis::bandwidth(g), bandwidth);
+
+    Partition partition(g, 4, true);
+    double cut_edge_percent = Analysis::cutEdgePercent(g);
+    g.restoreOrder();
+    EXPECT_EQ(cut_edge_percent, Analysis::cutEdgePercent(g));
+    for (auto it = input.cbegin(); it != input.cend(); ++it) {
+        auto reordered = g.find(it->first);
+        ASSERT_TRUE(reordered != g.cend());
+        EXPECT_TRUE(it->second == reordered->second);
+    }
+}
+
 /**
  * @brief Test tqli function for the correctness of calculating eigenvalues,
  *        correct eigenvalues come from Matlab.
@@ -77,9 +122,60 @@ TEST_F(SerialTest, testTqli)
     }
 }
 
+/**
+ * @brief The SIMD kernels of every supported ISA match the generic version,
+ *        including the tails
+ */
+template <typename T>
+static void checkKernels(int size)
+{
+    vector<T> x(size), y(size), z(size);
+    for (int i = 0; i < size; i++) {
+        x[i] = std::sin(i + 1.0);
+        y[i] = std::cos(i + 2.0);
+        z[i] = std::sin(2.0 * i);
+    }
+    typedef VectorOps<vector<T>, T> Fast;
+    typedef ContiguousVectorOps<T> Base;
+    T tol = sizeof(T) == sizeof(float) ? 1e-4 : 1e-12;
+    T expected_dot = 0.0, expected_sum = 0.0;
+    vector<T> expected_w = x, expected_axpy = y, expected_scale(size);
+    for (int i = 0; i < size; i++) {
+        expected_dot += x[i] * y[i];
+        expected_w[i] = x[i] - 0.5 * y[i] - 0.25 * z[i];
+        expected_sum += expected_w[i] * expected_w[i];
+        expected_axpy[i] += 3.0 * x[i];
+        expected_scale[i] = 3.0 * x[i];
+    }
+
+    for (int isa = Kernels::Scalar; isa <= Kernels::supportedISA(); isa++) {
+        Kernels::setISA(static_cast<Kernels::ISA>(isa));
+        vector<T> w = x, axpy = y, scale;
+        EXPECT_NEAR(expected_dot, Base::dot(x, y), tol) << Kernels::isaName();
+        EXPECT_NEAR(expected_sum, Fast::update(w, y, z, 0.5, 0.25), tol);
+        Fast::axpy(axpy, x, 3.0);
+        Fast::scale(scale, x, 3.0);
+        for (int i = 0; i < size; i++) {
+            EXPECT_NEAR(expected_w[i], w[i], tol);
+            EXPECT_NEAR(expected_axpy[i], axpy[i], tol);
+            EXPECT_NEAR(expected_scale[i], scale[i], tol);
+        }
+    }
+    Kernels::setISA(Kernels::supportedISA());
+}
+
+TEST_F(SerialTest, testKernels)
+{
+    for (int size : {0, 1, 7, 37, 100}) {
+        checkKernels<double>(size);
+        checkKernels<float>(size);
+    }
+}
+
 /**
  * @brief The output alpha/beta would vary based on different initial vector,
- *        the eigenvalues should always be same.
+ *        the eigenvalues should always be same. The constant vector is
+ *        deflated, size - 1 iterations give all the non-zero eigenvalues.
  */
 TEST_F(SerialTest, testLanczos)
 {
@@ -91,21 +187,856 @@ TEST_F(SerialTest, testLanczos)
     Lanczos<vector<double>, double> lanczos(g, size, true);
     vector<double> alpha = lanczos.alpha;
     vector<double> beta = lanczos.beta;
+    ASSERT_EQ((int)alpha.size(), size - 1);
 
     beta.push_back(0);
 
     // Create the identity matrix used as input for TQLI
     vector<vector<double>> eigenvecs;
     tqli(alpha, beta, eigenvecs);
-    vector<double> eigenvalues = {0,       1.20972, 1.505, 2,
-                                  2.86246, 4.32623, 5,     7.09659};
+    vector<double> eigenvalues = {1.20972, 1.505,   2, 2.86246,
+                                  4.32623, 5, 7.09659};
 
     sort(alpha.begin(), alpha.end());
-    for (int i = 0; i < size; i++) {
+    for (int i = 0; i < size - 1; i++) {
         EXPECT_LT(abs(alpha[i] - eigenvalues[i]), 1e-5);
     }
 }
 
+/**
+ * @brief With the Lanczos vectors stored in float, the recurrence is still
+ *        done in double and the eigenvalues only lose the rounding of the
+ *        stored basis.
+ */
+TEST_F(SerialTest, testMixedPrecision)
+{
+    Graph g;
+    g.readDotFormat(filePath + "/par_test_8.dot");
+    int size = g.size();
+
+    Lanczos<vector<double>, double, vector<float>> lanczos(g, size, true);
+    vector<double> alpha = lanczos.alpha;
+    vector<double> beta = lanczos.beta;
+    beta.push_back(0);
+    vector<vector<double>> eigenvecs;
+    tqli(alpha, beta, eigenvecs);
+    vector<double> eigenvalues = {1.20972, 1.505,   2, 2.86246,
+                                  4.32623, 5, 7.09659};
+    sort(alpha.begin(), alpha.end());
+    ASSERT_EQ((int)alpha.size(), size - 1);
+    for (int i = 0; i < size - 1; i++) {
+        EXPECT_LT(abs(alpha[i] - eigenvalues[i]), 1e-4);
+    }
+
+    typedef VectorOps<vector<double>, double> Ops;
+    vector<double> x(37), y(37, 1.0);
+    for (unsigned int i = 0; i < x.size(); i++) {
+        x[i] = std::sin(i + 1.0);
+    }
+    for (int isa = Kernels::Scalar; isa <= Kernels::supportedISA(); isa++) {
+        Kernels::setISA(static_cast<Kernels::ISA>(isa));
+        vector<float> basis;
+        vector<double> axpy = y;
+        Ops::store(basis, x);
+        Ops::axpy(axpy, basis, 2.0);
+        EXPECT_NEAR(Ops::dot(basis, x), Ops::dot(x, x), 1e-5)
+            << Kernels::isaName();
+        for (unsigned int i = 0; i < x.size(); i++) {
+            EXPECT_NEAR(basis[i], x[i], 1e-7);
+            EXPECT_NEAR(axpy[i], 1.0 + 2.0 * x[i], 1e-6);
+        }
+    }
+    Kernels::setISA(Kernels::supportedISA());
+
+    Graph h;
+    h.readDotFormat(filePath + "/test_partition_10.dot");
+    PartitionOptions options(true);
+    options.mixedPrecision = true;
+    Partition partition(h, 2, options);
+    EXPECT_EQ(h.subgraphsNum(), 2);
+    EXPECT_LT(std::abs(Analysis::cutEdgePercent(h) - 0.142857), 1e-5);
+}
+
+/**
+ * @brief The Lanczos vectors spilled to a file give the same results as in
+ *        memory
+ */
+TEST_F(SerialTest, testSpillBasis)
+{
+    Graph g;
+    g.readDotFormat(filePath + "/par_test_8.dot");
+    int size = g.size();
+
+    typedef Lanczos<vector<double>, double> DoubleLanczos;
+    srand48(1);
+    DoubleLanczos memory(g, size, true);
+    srand48(1);
+    DoubleLanczos spilled(g, size, true, "/tmp");
+    EXPECT_FALSE(memory.lanczos_vecs.spilled());
+    EXPECT_TRUE(spilled.lanczos_vecs.spilled());
+    ASSERT_EQ(memory.lanczos_vecs.size(), spilled.lanczos_vecs.size());
+    for (int row = 0; row < memory.lanczos_vecs.size(); row++) {
+        for (int col = 0; col < size; col++) {
+            EXPECT_EQ(memory.lanczos_vecs[row][col],
+                      spilled.lanczos_vecs[row][col]);
+        }
+    }
+    EXPECT_EQ(memory.alpha, spilled.alpha);
+    EXPECT_THROW(DoubleLanczos(g, size, true, "/nonexistent"),
+                 std::runtime_error);
+
+    Graph h;
+    h.readDotFormat(filePath + "/test_partition_10.dot");
+    PartitionOptions options(true);
+    options.spillDirectory = "/tmp";
+    Partition partition(h, 2, options);
+    EXPECT_LT(std::abs(Analysis::cutEdgePercent(h) - 0.142857), 1e-5);
+}
+
+/**
+ * @brief Test the rows of the basis arena, aligned to 64 bytes and written
+ *        in place or stored
+ */
+TEST_F(SerialTest, testBasisArena)
+{
+    MemoryUsage::reset();
+    LanczosBasis<float> basis;
+    basis.reserve(3, 5, "");
+    float* row = basis.append();
+    for (int i = 0; i < 5; i++) {
+        row[i] = i;
+    }
+    basis.push_back(vector<double>(5, 0.5));
+    basis.append()[4] = 2.0f;
+    ASSERT_EQ(basis.size(), 3);
+    for (int r = 0; r < basis.size(); r++) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(basis[r].data()) % 64, 0u);
+    }
+    EXPECT_EQ(basis[0][3], 3.0f);
+    EXPECT_EQ(basis[1][4], 0.5f);
+    EXPECT_EQ(basis[2][4], 2.0f);
+    EXPECT_EQ(MemoryUsage::entries().at("lanczos/basis"), 3 * 64u);
+    MemoryUsage::reset();
+}
+
+/**
+ * @brief Partial reorthogonalisation keeps the Lanczos vectors orthogonal to
+ *        about sqrt(eps) while orthogonalising against a part of them only
+ */
+TEST_F(SerialTest, testPartialReorthogonalisation)
+{
+    Graph g;
+    g.readDotFormat(filePath + "/test_1000.dot");
+    auto loss = [](const LanczosBasis<double>& basis) {
+        double maxDot = 0.0;
+        for (int i = 0; i < basis.size(); i++) {
+            for (int j = 0; j < i; j++) {
+                double q = Kernels::dot(basis[i].data(), basis[j].data(),
+                                        basis.cols());
+                maxDot = max(maxDot, abs(q));
+            }
+        }
+        return maxDot;
+    };
+
+    srand48(1);
+    Lanczos<vector<double>, double> plain(g, 3, false);
+    srand48(1);
+    Lanczos<vector<double>, double> partial(g, 3, true);
+    int m = partial.lanczos_vecs.size();
+    EXPECT_GT(loss(plain.lanczos_vecs), 1e-2);
+    EXPECT_LT(loss(partial.lanczos_vecs), 1e-6);
+    EXPECT_EQ(plain.reorthogonalisations, 0);
+    EXPECT_GT(partial.reorthogonalisations, 0);
+    EXPECT_LT(partial.reorthogonalisations, m / 2);
+}
+
+/**
+ * @brief The filter damps the upper part of the spectrum, the Rayleigh
+ *        quotient of a random vector orthogonal to the constant vector drops
+ *        below the damped interval
+ */
+TEST_F(SerialTest, testChebyshevFilter)
+{
+    g.readDotFormat(filePath + "/test_1000.dot");
+    Laplacian<vector<double>, double> laplacian(g);
+    vector<double> degrees = laplacian.diagonal();
+    double bound = laplacian.spectralBound();
+    EXPECT_EQ(bound, 2 * *max_element(degrees.begin(), degrees.end()));
+
+    auto rayleigh = [&](const vector<double>& x) {
+        vector<double> lx;
+        laplacian.multiply(x, lx);
+        double xlx = 0.0, xx = 0.0;
+        for (int i = 0; i < g.size(); i++) {
+            xlx += x[i] * lx[i];
+            xx += x[i] * x[i];
+        }
+        return xlx / xx;
+    };
+    srand48(1);
+    vector<double> x(g.size());
+    double mean = 0.0;
+    for (auto& entry : x) {
+        entry = drand48();
+        mean += entry / g.size();
+    }
+    for (auto& entry : x) {
+        entry -= mean;
+    }
+    vector<double> y = x;
+    ChebyshevFilter<vector<double>, double> none(laplacian, 0);
+    none.apply(y);
+    EXPECT_EQ(x, y);
+    ChebyshevFilter<vector<double>, double> filter(laplacian, 10);
+    filter.apply(y);
+    EXPECT_GT(rayleigh(x), 0.05 * bound);
+    EXPECT_LT(rayleigh(y), 0.05 * bound);
+
+    Graph h;
+    h.readDotFormat(filePath + "/test_partition_10.dot");
+    PartitionOptions options(true);
+    options.chebyshevDegree = 10;
+    Partition partition(h, 2, options);
+    EXPECT_LT(std::abs(Analysis::cutEdgePercent(h) - 0.142857), 1e-5);
+}
+
+/**
+ * @brief Block Lanczos spanning the whole space orthogonal to the constant
+ *        vector gives all the non-zero eigenvalues, and the same partition
+ */
+TEST_F(SerialTest, testBlockLanczos)
+{
+    Graph g;
+    g.readDotFormat(filePath + "/test_partition_10.dot");
+    int size = g.size();
+
+    Lanczos<vector<double>, double> lanczos(g, size, true, "", 3);
+    EXPECT_EQ(lanczos.block_size, 3);
+    ASSERT_EQ((int)lanczos.block_tri.size(), size - 1);
+    vector<double> eigenvalues;
+    vector<vector<double>> eigenvecs;
+    symmetricEigen(lanczos.block_tri, eigenvalues, eigenvecs);
+    vector<double> expected = {0.466941, 0.857996, 2,       2.81842, 3.17936,
+                               4,        4.12601,  4.88488, 5.66639};
+    sort(eigenvalues.begin(), eigenvalues.end());
+    for (int i = 0; i < size - 1; i++) {
+        EXPECT_LT(abs(eigenvalues[i] - expected[i]), 1e-5);
+    }
+
+    Graph h;
+    h.readDotFormat(filePath + "/test_partition_10.dot");
+    PartitionOptions options(true);
+    options.blockSize = 2;
+    Partition partition(h, 2, options);
+    EXPECT_EQ(h.subgraphsNum(), 2);
+    EXPECT_LT(std::abs(Analysis::cutEdgePercent(h) - 0.142857), 1e-5);
+}
+
+/**
+ * @brief LOBPCG finds the smallest non-trivial eigenvalues with every
+ *        preconditioner and gives the same partition as Lanczos
+ */
+TEST_F(SerialTest, testLobpcg)
+{
+    typedef Lobpcg<vector<double>, double> Solver;
+    g.readDotFormat(filePath + "/par_test_8.dot");
+    vector<double> expected = {1.20972, 1.505, 2};
+    for (const char* name : {"none", "jacobi", "smoother"}) {
+        Solver lobpcg(g, 3, Solver::preconditioner(name), 500, 1e-8);
+        EXPECT_TRUE(lobpcg.converged);
+        ASSERT_EQ(lobpcg.eigenvalues.size(), expected.size());
+        for (unsigned int i = 0; i < expected.size(); i++) {
+            EXPECT_LT(abs(lobpcg.eigenvalues[i] - expected[i]), 1e-5);
+        }
+    }
+    EXPECT_THROW(Solver::preconditioner("multigrid"), std::invalid_argument);
+
+    Graph h;
+    h.readDotFormat(filePath + "/test_partition_10.dot");
+    PartitionOptions options;
+    options.eigensolver = "lobpcg";
+    Partition partition(h, 2, options);
+    EXPECT_EQ(h.subgraphsNum(), 2);
+    EXPECT_LT(std::abs(Analysis::cutEdgePercent(h) - 0.142857), 1e-5);
+    options.eigensolver = "arnoldi";
+    EXPECT_THROW(Partition(h, 2, options), std::invalid_argument);
+}
+
+/**
+ * @brief Two copies of test_partition_10 and three tiny components, only the
+ *        copies are partitioned, concurrently, and the tiny components are
+ *        not split
+ */
+TEST_F(SerialTest, testComponents)
+{
+    g.readDotFormat(filePath + "/test_components_30.dot");
+    vector<int> component = g.components();
+    ASSERT_EQ((int)component.size(), 30);
+    for (int vertex = 0; vertex < 30; vertex++) {
+        int first = vertex < 20 ? vertex / 10 * 10 : vertex < 23 ? 20 : 23;
+        EXPECT_EQ(component[vertex], vertex < 25 ? first : 25);
+    }
+    map<int, int> sizes = g.globalCounts(component);
+    map<int, int> expected_sizes = {{0, 10}, {10, 10}, {20, 3}, {23, 2},
+                                    {25, 5}};
+    EXPECT_EQ(sizes, expected_sizes);
+    Graph sub = g.subgraph({25, 26, 27, 28, 29});
+    EXPECT_EQ(sub.size(), 5);
+    EXPECT_EQ(sub.edgesNum(), 5);
+
+    PartitionOptions options(true);
+    options.minComponentSize = 8;
+    Timers::reset();
+    stringstream log;
+    std::streambuf* console = cout.rdbuf(log.rdbuf());
+    Partition partition(g, 2, options);
+    cout.rdbuf(console);
+    EXPECT_EQ(g.subgraphsNum(), 2);
+    // The copies are partitioned on threads, their timers and reports
+    // merged, each report printed whole
+    const string report = "Lanczos algorithm WITH Partial Reorthogonalisation "
+                          "is done.\nnumber of iterations = ";
+    EXPECT_EQ(log.str().find(report), 0u);
+    EXPECT_NE(log.str().find("\n" + report), string::npos);
+    Timers::Entries entries = Timers::entries();
+    EXPECT_EQ(entries["partition/components"].second, 1);
+    EXPECT_EQ(entries["partition/partition/lanczos"].second, 2);
+    for (int vertex = 20; vertex < 30; vertex++) {
+        EXPECT_EQ(g.getColour(vertex), g.getColour(component[vertex]));
+    }
+    // The cut edges of the two copies only, 2 * 2 of 2 * 14 + 8 edges
+    EXPECT_LT(std::abs(Analysis::cutEdgePercent(g) - 4.0 / 36), 1e-5);
+}
+
+/**
+ * @brief A path splits in half even when its Fiedler value is below 1e-2,
+ *        here by weights of 0.1, only the values zero to rounding are
+ *        skipped. 15 Lanczos vectors span the whole space of 16 vertices.
+ */
+TEST_F(SerialTest, testPathFiedlerValue)
+{
+    for (int vertex = 0; vertex + 1 < 16; vertex++) {
+        g.addEdge(vertex, vertex + 1, 0.1);
+    }
+    Partition partition(g, 2, true);
+    ASSERT_EQ(partition.ritzValues.size(), 1u);
+    EXPECT_NEAR(partition.ritzValues[0], 0.2 * (1 - std::cos(M_PI / 16)),
+                1e-8);
+    for (int vertex = 0; vertex < 16; vertex++) {
+        EXPECT_EQ(g.getColour(vertex), g.getColour(vertex < 8 ? 0 : 15));
+    }
+    EXPECT_NE(g.getColour(0), g.getColour(15));
+}
+
+/**
+ * @brief The eigenvectors saved from one run warm start the next, Lanczos
+ *        stops once converged and gives the same partition
+ */
+TEST_F(SerialTest, testWarmStart)
+{
+    g.readDotFormat(filePath + "/test_1000.dot");
+    PartitionOptions options;
+    options.eigensolver = "lobpcg";
+    Partition cold(g, 4, options);
+    double cut = Analysis::cutEdgePercent(g);
+    g.outputVectors("warm_start_vectors.txt", cold.eigenvectors());
+    vector<vector<double>> start = g.readVectors("warm_start_vectors.txt");
+    remove("warm_start_vectors.txt");
+    ASSERT_EQ(start.size(), 2u);
+    for (unsigned int r = 0; r < start.size(); r++) {
+        ASSERT_EQ((int)start[r].size(), g.size());
+        for (int vertex = 0; vertex < g.size(); vertex++) {
+            EXPECT_LT(abs(start[r][vertex] - cold.eigenvectors()[r][vertex]),
+                      1e-12);
+        }
+    }
+
+    Lanczos<vector<double>, double> lanczos(g, 2, true);
+    Lanczos<vector<double>, double> warm(g, 2, true, "", 1, 0, start);
+    EXPECT_FALSE(lanczos.converged);
+    EXPECT_TRUE(warm.converged);
+    EXPECT_LT(warm.alpha.size(), lanczos.alpha.size() / 2);
+    Lanczos<vector<double>, double> block(g, 2, true, "", 2, 0, start);
+    EXPECT_TRUE(block.converged);
+
+    options.eigensolver = "lanczos";
+    options.startVectors = start;
+    Partition partition(g, 4, options);
+    EXPECT_LT(abs(Analysis::cutEdgePercent(g) - cut), 1e-12);
+    for (unsigned int r = 0; r < start.size(); r++) {
+        EXPECT_LT(abs(partition.ritzValues[r] - cold.ritzValues[r]), 1e-6);
+    }
+
+    vector<vector<double>> colours = Partition::colourVectors({0, 3, -1}, 4);
+    vector<vector<double>> expected = {{-1, 1, 0}, {-1, 1, 0}};
+    EXPECT_EQ(colours, expected);
+    options.startVectors.assign(1, vector<double>(10));
+    EXPECT_THROW(Partition(g, 4, options), std::invalid_argument);
+}
+
+/**
+ * @brief A vertex tied to the other colour by an update is moved there
+ *        locally, a batch that cuts many edges triggers a recompute
+ */
+TEST_F(SerialTest, testRepartition)
+{
+    g.readDotFormat(filePath + "/test_1000.dot");
+    Repartition repartition(g, 2, PartitionOptions(), 0.1, 0.1);
+    EXPECT_LT(abs(repartition.cut() - Analysis::cutEdgePercent(g)), 1e-12);
+    int64_t edges = g.edgesNum();
+
+    // A vertex of the larger colour tied to 10 vertices of the other one
+    vector<int> members[2];
+    for (int vertex = 0; vertex < g.size(); vertex++) {
+        members[g.getColour(vertex)].push_back(vertex);
+    }
+    int large = members[1].size() > members[0].size() ? 1 : 0;
+    int vertex = members[large][0];
+    Repartition::Edges inserted;
+    for (const int& other : members[1 - large]) {
+        if (inserted.size() < 10 && g.find(vertex)->second.count(other) == 0) {
+            inserted.push_back({vertex, other});
+        }
+    }
+    EXPECT_FALSE(repartition.update(inserted, {}));
+    EXPECT_EQ(g.edgesNum(), edges + 10);
+    EXPECT_EQ(g.getColour(vertex), 1 - large);
+    EXPECT_GE(repartition.moves, 1);
+    EXPECT_EQ(repartition.recomputes, 0);
+
+    EXPECT_FALSE(repartition.update({}, inserted));
+    EXPECT_EQ(g.edgesNum(), edges);
+
+    // Many edges between the colours
+    inserted.clear();
+    for (int i = 0; i < 200; i++) {
+        inserted.push_back({members[0][i * 7 % members[0].size()],
+                            members[1][i * 13 % members[1].size()]});
+    }
+    EXPECT_TRUE(repartition.update(inserted, {}));
+    EXPECT_EQ(repartition.recomputes, 1);
+    EXPECT_THROW(g.insertEdges({{0, g.size()}}), std::out_of_range);
+}
+
+/**
+ * @brief The streaming reader gives the same graph as readDotFormat with any
+ *        number of threads, duplicated edges and self loops are dropped
+ */
+TEST_F(SerialTest, testReadStreaming)
+{
+    for (const char* name : {"/test_1000.dot", "/par_test_10240.dot"}) {
+        Graph h;
+        h.readDotFormat(filePath + name);
+        for (int threads : {1, 3}) {
+            Graph streamed;
+            streamed.readDotFormatStreaming(filePath + name, threads);
+            ASSERT_EQ(streamed.size(), h.size());
+            EXPECT_EQ(streamed.edgesNum(), h.edgesNum());
+            for (auto it = h.cbegin(); it != h.cend(); ++it) {
+                EXPECT_TRUE(streamed.find(it->first)->second == it->second);
+            }
+        }
+    }
+
+    ofstream Output("streaming_test.dot");
+    Output << "Undirected Graph {" << endl
+           << "0;" << endl
+           << "1[C=1];" << endl
+           << "4;" << endl
+           << "0--1 ;" << endl
+           << "1--0 ;" << endl
+           << "1--2 ;" << endl
+           << "2--2 ;" << endl
+           << "0--1 ;" << endl
+           << "}" << endl;
+    Output.close();
+    Csr<int32_t> csr = readDotFormatCsr<int32_t>("streaming_test.dot", 2);
+    remove("streaming_test.dot");
+    vector<int64_t> offsets = {0, 1, 3, 4, 4, 4};
+    vector<int32_t> neighbours = {1, 0, 2, 1};
+    EXPECT_EQ(csr.size(), 5);
+    EXPECT_EQ(csr.offsets, offsets);
+    EXPECT_EQ(csr.neighbours, neighbours);
+    EXPECT_THROW(readDotFormatCsr<int32_t>(filePath + "/missing.dot"),
+                 runtime_error);
+}
+
+/**
+ * @brief Partition a file as a graph with Index ids from the same seed
+ * @return colour[vertex], the Ritz values in ritz
+ */
+template <typename Index>
+static vector<int> partitionColours(const string& filename,
+                                    const PartitionOptions& options,
+                                    vector<double>& ritz)
+{
+    BasicGraph<Index> graph;
+    graph.readDotFormat(filename);
+    srand48(1);
+    Partition partition(graph, 4, options);
+    ritz = partition.ritzValues;
+    vector<int> colours;
+    for (Index vertex = 0; vertex < graph.size(); vertex++) {
+        colours.push_back(graph.getColour(vertex));
+    }
+    return colours;
+}
+
+/**
+ * @brief 32-bit and 64-bit vertex ids give the same rows, an id beyond 2^31
+ *        does not fit in the 32-bit rows or graph. Graph and Graph64 give
+ *        the same partitions from the same seed, by Lanczos, LOBPCG and
+ *        by components.
+ */
+TEST_F(SerialTest, testIndexTypes)
+{
+    Csr<int32_t> narrow =
+        readDotFormatCsr<int32_t>(filePath + "/par_test_10240.dot", 2);
+    Csr<int64_t> wide =
+        readDotFormatCsr<int64_t>(filePath + "/par_test_10240.dot", 2);
+    ASSERT_EQ(narrow.size(), wide.size());
+    EXPECT_EQ(narrow.offsets, wide.offsets);
+    EXPECT_TRUE(std::equal(narrow.neighbours.begin(), narrow.neighbours.end(),
+                           wide.neighbours.begin()));
+
+    Graph g;
+    g.readDotFormat(filePath + "/par_test_10240.dot");
+    EXPECT_EQ(g.edgesNum(), (int64_t)wide.neighbours.size() / 2);
+
+    ofstream Output("index_test.dot");
+    Output << "Undirected Graph {" << endl
+           << "0--3000000000 ;" << endl
+           << "}" << endl;
+    Output.close();
+    EXPECT_THROW(readDotFormatCsr<int32_t>("index_test.dot", 1),
+                 out_of_range);
+    Graph narrow_graph;
+    EXPECT_THROW(narrow_graph.readDotFormat("index_test.dot"), out_of_range);
+    Graph64 wide_graph;
+    wide_graph.readDotFormat("index_test.dot");
+    EXPECT_EQ(wide_graph.edgesNum(), 1);
+    EXPECT_EQ(wide_graph.find(3000000000)->second.count(0), 1u);
+    remove("index_test.dot");
+
+    PartitionOptions lanczos(true), lobpcg, components(true);
+    lobpcg.eigensolver = "lobpcg";
+    components.minComponentSize = 8;
+    const vector<pair<string, PartitionOptions>> runs = {
+        {"/test_1000.dot", lanczos},
+        {"/test_1000.dot", lobpcg},
+        {"/test_components_30.dot", components}};
+    for (const auto& run : runs) {
+        vector<double> narrow_ritz, wide_ritz;
+        vector<int> narrow_colours = partitionColours<int32_t>(
+            filePath + run.first, run.second, narrow_ritz);
+        vector<int> wide_colours = partitionColours<int64_t>(
+            filePath + run.first, run.second, wide_ritz);
+        EXPECT_EQ(narrow_colours, wide_colours) << run.first;
+        ASSERT_EQ(narrow_ritz.size(), wide_ritz.size());
+        for (unsigned int i = 0; i < narrow_ritz.size(); i++) {
+            EXPECT_NEAR(narrow_ritz[i], wide_ritz[i], 1e-10);
+        }
+    }
+}
+
+/**
+ * @brief Edge weights are read from the dot file and used by the Laplacian,
+ *        the partition of a ring cuts its two light edges
+ */
+TEST_F(SerialTest, testWeightedGraph)
+{
+    ofstream Output("weighted_test.dot");
+    Output << "Undirected Graph {" << endl;
+    for (int vertex = 0; vertex < 8; vertex++) {
+        Output << vertex << ";" << endl;
+    }
+    for (int vertex = 0; vertex < 8; vertex++) {
+        int next = (vertex + 1) % 8;
+        double weight = vertex == 1 || vertex == 5 ? 0.1 : 1.0;
+        Output << vertex << "--" << next << " [weight=" << weight << "] ;"
+               << endl
+               << next << "--" << vertex << " [weight=" << weight << "] ;"
+               << endl;
+    }
+    Output << "}" << endl;
+    Output.close();
+    g.readDotFormat("weighted_test.dot");
+    remove("weighted_test.dot");
+    ASSERT_TRUE(g.weighted());
+    EXPECT_EQ(g.getWeight(1, 2), 0.1);
+    EXPECT_EQ(g.getWeight(6, 5), 0.1);
+    EXPECT_EQ(g.getWeight(2, 3), 1.0);
+
+    Laplacian<vector<double>, double> laplacian(g);
+    vector<double> degrees = laplacian.diagonal();
+    EXPECT_LT(std::abs(degrees[2] - 1.1), 1e-12);
+    EXPECT_LT(std::abs(laplacian.spectralBound() - 4.0), 1e-12);
+    vector<double> x(8, 0.0), y;
+    x[2] = 1.0;
+    laplacian.multiply(x, y);
+    vector<double> expected = {0, -0.1, 1.1, -1, 0, 0, 0, 0};
+    for (int vertex = 0; vertex < 8; vertex++) {
+        EXPECT_LT(std::abs(y[vertex] - expected[vertex]), 1e-12);
+    }
+
+    // The weights are kept by the writer and through reordering
+    g.reorder("rcm");
+    g.outputDotFormat("weighted_test.dot");
+    g.restoreOrder();
+    Graph h;
+    h.readDotFormat("weighted_test.dot");
+    remove("weighted_test.dot");
+    EXPECT_EQ(h.edgesNum(), 8);
+    int light = 0;
+    for (auto it = h.cbegin(); it != h.cend(); ++it) {
+        for (const int& neighbour : it->second) {
+            if (h.getWeight(it->first, neighbour) == 0.1) light++;
+        }
+    }
+    EXPECT_EQ(light, 4);
+
+    Partition partition(g, 2, PartitionOptions(true));
+    for (int vertex = 0; vertex < 8; vertex++) {
+        bool right = vertex >= 2 && vertex <= 5;
+        EXPECT_EQ(g.getColour(vertex) == g.getColour(2), right);
+    }
+
+    // An edge inserted again without a weight has weight 1
+    g.insertEdges({{2, 1}});
+    EXPECT_EQ(g.getWeight(1, 2), 1.0);
+    Graph single;
+    single.addEdge(0, 1, 2.0);
+    single.addEdge(0, 1, 1.0);
+    EXPECT_EQ(single.getWeight(0, 1), 1.0);
+    EXPECT_FALSE(single.weighted());
+}
+
+/**
+ * @brief The symmetric normalised Laplacian has the eigenvalues in [0, 2]
+ *        with D^1/2 1 in its null space, both normalised operators find the
+ *        same cut as the combinatorial one on a graph of even degrees
+ */
+TEST_F(SerialTest, testNormalisedLaplacian)
+{
+    g.readDotFormat(filePath + "/test_1000.dot");
+    Laplacian<vector<double>, double, SymmetricNormalised> laplacian(g);
+    EXPECT_EQ(laplacian.spectralBound(), 2.0);
+    vector<double> diagonal = laplacian.diagonal(), y;
+    vector<double> null = laplacian.nullVector();
+    laplacian.multiply(null, y);
+    for (int vertex = 0; vertex < g.size(); vertex++) {
+        EXPECT_TRUE(diagonal[vertex] == 1.0 || diagonal[vertex] == 0.0);
+        EXPECT_LT(std::abs(y[vertex]), 1e-12);
+    }
+
+    Lanczos<vector<double>, double, vector<double>, SymmetricNormalised>
+        lanczos(g, 4, true);
+    vector<double> alpha = lanczos.alpha, beta = lanczos.beta;
+    beta.push_back(0);
+    vector<vector<double>> eigenvecs;
+    tqli(alpha, beta, eigenvecs);
+    for (const double& value : alpha) {
+        EXPECT_GT(value, -1e-8);
+        EXPECT_LT(value, 2.0 + 1e-8);
+    }
+
+    for (const char* operation : {"normalised", "random-walk"}) {
+        Graph h;
+        h.readDotFormat(filePath + "/test_partition_10.dot");
+        PartitionOptions options(true);
+        options.laplacian = operation;
+        Partition partition(h, 2, options);
+        EXPECT_EQ(h.subgraphsNum(), 2);
+        EXPECT_LT(std::abs(Analysis::cutEdgePercent(h) - 0.142857), 1e-5);
+    }
+    PartitionOptions options(true);
+    options.laplacian = "symmetric";
+    EXPECT_THROW(Partition(g, 2, options), invalid_argument);
+
+    // A path 0-1-2-3 cut in the middle, cut 1 and volumes 3 on either side
+    Graph path;
+    for (int vertex = 0; vertex < 3; vertex++) {
+        path.addEdge(vertex, vertex + 1);
+        path.addEdge(vertex + 1, vertex);
+    }
+    for (int vertex = 0; vertex < 4; vertex++) {
+        path.setColour(vertex, vertex / 2);
+    }
+    EXPECT_LT(std::abs(Analysis::ratioCut(path) - 1.0), 1e-12);
+    EXPECT_LT(std::abs(Analysis::normalisedCut(path) - 2.0 / 3.0), 1e-12);
+}
+
+/**
+ * @brief The generators give the same edges whatever the slices and the
+ *        threads are, and the graph has about the requested number of edges
+ */
+TEST_F(SerialTest, testGenerators)
+{
+    const int vertices = 1000, edges = 4000;
+    for (const char* name : {"erdos-renyi", "rmat", "geometric"}) {
+        Generator generator(Generator::model(name), vertices, edges, 7);
+        Generator::Edges whole = generator.edges(0, 1, 1), slices;
+        for (int part = 0; part < 3; part++) {
+            Generator::Edges slice = generator.edges(part, 3, 2);
+            slices.insert(slices.end(), slice.begin(), slice.end());
+        }
+        EXPECT_EQ(slices, whole);
+        EXPECT_NE(Generator(Generator::model(name), vertices, edges, 8)
+                      .edges(0, 1, 1),
+                  whole);
+        for (const auto& edge : whole) {
+            EXPECT_TRUE(edge.first >= 0 && edge.first < vertices);
+            EXPECT_TRUE(edge.second >= 0 && edge.second < vertices);
+        }
+
+        Graph h;
+        h.generate(generator, 2);
+        EXPECT_EQ(h.size(), vertices);
+        EXPECT_LE(h.edgesNum(), (int64_t)whole.size());
+        EXPECT_GT(h.edgesNum(), 0.8 * edges);
+    }
+    EXPECT_EQ(Generator(Generator::ErdosRenyi, vertices, edges, 7)
+                  .edges(0, 1)
+                  .size(),
+              (size_t)edges);
+    EXPECT_THROW(Generator::model("kronecker"), invalid_argument);
+}
+
+/**
+ * @brief Test the nesting and the counts of the timers, their merging from
+ *        another thread and the JSON report over processes
+ */
+
+TEST_F(SerialTest, testTimers)
+{
+    Timers::reset();
+    for (int i = 0; i < 3; i++) {
+        Timers::Scope outer("outer");
+        Timers::Scope inner("inner");
+        EXPECT_GE(inner.stop(), 0.0);
+    }
+    Timers::Entries entries = Timers::entries();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries["outer"].second, 3);
+    EXPECT_EQ(entries["outer/inner"].second, 3);
+    EXPECT_GE(entries["outer"].first, entries["outer/inner"].first);
+
+    Timers::Entries worker;
+    std::thread([&worker]() {
+        Timers::Scope scope("worker");
+        scope.stop();
+        worker = Timers::entries();
+    }).join();
+    {
+        Timers::Scope outer("outer");
+        Timers::merge(worker);
+    }
+    entries = Timers::entries();
+    EXPECT_EQ(entries["outer/worker"].second, 1);
+    EXPECT_EQ(entries.count("worker"), 0u);
+
+    // The phases of the solver nest under the partition
+    Graph g;
+    g.readDotFormat(filePath + "/test_1000.dot");
+    Timers::reset();
+    Partition partition(g, 4, false);
+    entries = Timers::entries();
+    for (const char* path :
+         {"partition", "partition/lanczos", "partition/lanczos/spmv",
+          "partition/tqli", "partition/ritz_vector", "partition/colour"}) {
+        EXPECT_EQ(entries.count(path), 1u) << path;
+    }
+    EXPECT_EQ(partition.times.back(), entries["partition"].first);
+
+    Timers::Entries other;
+    other["outer"] = make_pair(2.0, 1LL);
+    stringstream report;
+    Timers::report(report, {entries, other});
+    EXPECT_NE(report.str().find("\"processes\": 2"), string::npos);
+    EXPECT_NE(report.str().find("{\"name\": \"outer\", \"calls\": 1, "
+                                "\"min\": 0, \"max\": 2, \"avg\": 1}"),
+              string::npos);
+}
+
+/**
+ * @brief Test the bounded buffer of the trace events, the ids of their
+ *        threads and the Chrome trace over processes
+ */
+TEST_F(SerialTest, testTrace)
+{
+    Trace::start(4);
+    const char* names[] = {"a", "b", "c", "d", "e"};
+    for (const char* name : names) {
+        Trace::Scope scope(name);
+    }
+    std::thread([]() { Trace::Scope scope("worker"); }).join();
+
+    std::vector<Trace::Event> events = Trace::events();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(Trace::dropped(), 2u);
+    EXPECT_EQ(string(events[0].name), "c");
+    EXPECT_EQ(string(events[3].name), "worker");
+    EXPECT_EQ(events[0].thread, 0);
+    EXPECT_NE(events[3].thread, 0);
+    for (const auto& event : events) {
+        EXPECT_LE(0, event.begin);
+        EXPECT_LE(event.begin, event.end);
+    }
+
+    stringstream trace;
+    Trace::write(trace, {Trace::json(0), Trace::json(1)});
+    EXPECT_EQ(trace.str().find("{\"traceEvents\": ["), 0u);
+    EXPECT_NE(trace.str().find("\"name\": \"worker\", \"ph\": \"X\", "
+                               "\"pid\": 1"),
+              string::npos);
+    Trace::start(0);
+}
+
+/**
+ * @brief Test the recorded peaks and allocation sizes, the edges counted in
+ *        a dot file and the estimate of --dry-run against a partition
+ */
+TEST_F(SerialTest, testMemoryUsage)
+{
+    MemoryUsage::reset();
+    MemoryUsage::record("a", 10);
+    MemoryUsage::record("a", 5);
+    EXPECT_EQ(MemoryUsage::entries().at("a"), 10u);
+    EXPECT_EQ(MemoryUsage::allocation(12), 32u);
+    EXPECT_EQ(MemoryUsage::allocation(72), 80u);
+    vector<double> x(100);
+    EXPECT_EQ(MemoryUsage::bytes(x), 800u);
+
+    const string filename = filePath + "/test_1000.dot";
+    int64_t vertices, edges;
+    countDotFormat(filename, vertices, edges, 2);
+    EXPECT_EQ(vertices, 1000);
+    Graph g;
+    g.readDotFormat(filename);
+    EXPECT_EQ(edges, g.edgesNum());
+
+    // The Lanczos vectors and z of the estimate are exact for a connected
+    // graph, the adjacency is at most the estimate of the edges
+    MemoryUsage::reset();
+    Partition partition(g, 4, false);
+    MemoryUsage::Entries recorded = MemoryUsage::entries();
+    int m = Lanczos<vector<double>, double>::getIteration(2, vertices);
+    MemoryUsage::Entries estimated =
+        MemoryUsage::estimate(vertices, edges, m, 2, 1, sizeof(double), false);
+    for (const char* name :
+         {"lanczos/basis", "tqli/z", "partition/eigenvectors"}) {
+        EXPECT_EQ(recorded[name], estimated[name]) << name;
+    }
+    EXPECT_GT(recorded["graph/adjacency"], 0u);
+    EXPECT_LE(recorded["graph/adjacency"], estimated["graph/adjacency"]);
+    EXPECT_GT(MemoryUsage::peakRss(), 0u);
+
+    stringstream report;
+    MemoryUsage::report(report, {recorded}, {MemoryUsage::peakRss()});
+    EXPECT_NE(report.str().find("rss high-water mark"), string::npos);
+}
+
 /**
  * @brief Partitioning is based on the correctness of the calculation of
  *        eigenvalues and corresponding eigenvectors of the Laplacian matrix